@@ -177,6 +177,10 @@ Num operator-(const Num num) {
   return ret;
 }
 
+real_t ToReal(Num num) {
+  return num.type == INTEGER ? num.int_value : num.float_value;
+}
+
 bool operator==(const Expression lhs, const Expression rhs) {
   if (lhs.constant != rhs.constant) return false;
   if (lhs.variable_coeff.size() != rhs.variable_coeff.size()) return false;
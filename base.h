@@ -197,6 +197,9 @@ bool operator>(const Num lhs, const Num rhs);
 bool operator>=(const Num lhs, const Num rhs);
 Num operator-(const Num num);
 
+// The value of a number, whatever its type.
+real_t ToReal(Num num);
+
 struct Expression {
  public:
   Expression(Num num) : constant(num) {}
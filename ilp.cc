@@ -1,106 +1,5 @@
 #include "ilp.h"
 
-Result ILPModel::BranchAndBoundSolve() {
-  std::queue<ILPModel> problems;
-
-  Result result = NOSOLUTION;
-  Num optimal(-100000000.f);
-  std::map<Variable, Num> sol;
-  problems.push(*this);
-  auto is_integral = [](float x) -> bool { return fabs(x - int(x)) < 1e-6; };
-  std::set<Variable> interger_vars;
-  for (auto constraint : model_.constraints) {
-    for (auto entry : constraint.expression.variable_coeff)
-      interger_vars.insert(entry.first);
-  }
-  auto is_integral_solution = [&](std::map<Variable, Num> solution) -> bool {
-    for (auto entry : solution) {
-      auto var = entry.first;
-      var.To(INTEGER);
-      if (interger_vars.find(var) == interger_vars.end()) continue;
-      if (!is_integral(entry.second.float_value)) {
-        return false;
-      }
-    }
-    return true;
-  };
-  while (!problems.empty()) {
-    auto sub_problem = problems.front();
-    problems.pop();
-    auto relaxed_sub_problem = sub_problem.ToRelaxedLPModel();
-    auto sub_result = relaxed_sub_problem.SimplexSolve();
-    if (sub_result == NOSOLUTION) continue;
-    if (sub_result == UNBOUNDED) return UNBOUNDED;
-    if (relaxed_sub_problem.GetSimplexOptimum() < optimal) continue;
-    if (is_integral_solution(relaxed_sub_problem.GetSimplexSolution())) {
-      optimal = relaxed_sub_problem.GetSimplexOptimum();
-      sol = relaxed_sub_problem.GetSimplexSolution();
-      result = SOLVED;
-      continue;
-    }
-    // The optimal solution of this sub problem is better than the optimal so
-    // far, need to split it into more sub-problems.
-    for (auto entry : relaxed_sub_problem.GetSimplexSolution()) {
-      if (!is_integral(entry.second.float_value)) {
-        auto var = entry.first;
-        var.To(INTEGER);
-        Constraint c1(INTEGER), c2(INTEGER);
-        c1.expression = var - Num(int(entry.second.float_value));
-        c1.equation_type = Constraint::Type::LE;
-        c2.expression = var - Num(int(entry.second.float_value) + 1);
-        c2.equation_type = Constraint::Type::GE;
-        auto sub_problem_1 = sub_problem, sub_problem_2 = sub_problem;
-        sub_problem_1.AddConstraint(c1);
-        sub_problem_2.AddConstraint(c2);
-        problems.push(sub_problem_1);
-        problems.push(sub_problem_2);
-        break;
-      }
-    }
-  }
-  optimum_ = optimal;
-  for (auto entry : sol) {
-    auto var = entry.first;
-    var.To(INTEGER);
-    solution_[var] = entry.second;
-  }
-  return result;
-}
-
-/* The general steps of cutting plane method:
- *    1. Convert the raw problem into relaxed form without integer constraints
- *       and solve it with normal LP solver.
- *    2. If there are non-integers in the solution, find a linear constraint and
- *       add it to the raw LP problem.
- *    3. Repeat this process until an all-integer solution is found.
- */
-Result ILPModel::CuttingPlaneSolve() {
-  LPModel model = ToRelaxedLPModel();
-  while (true) {
-    auto result = model.SimplexSolve();
-    if (result == NOSOLUTION) return NOSOLUTION;
-    if (result == UNBOUNDED) return UNBOUNDED;
-    bool all_intergral = true;
-    for (auto &constraint : model.model_.constraints) {
-      float b = constraint.expression.constant.float_value;
-      // If b < 0, int(b) will be larger than b.
-      int b_interger_part = b < 0.0f ? int(b) - 1 : int(b);
-      int b_decimal_part = b - b_interger_part;
-      if (abs(b_decimal_part) > 1e-6) {
-        all_intergral = false;
-        model.AddConstraint(FindGomoryCut(model, constraint));
-        break;
-      }
-    }
-    if (all_intergral) {
-      optimum_ = model.GetSimplexOptimum();
-      solution_ = model.GetSimplexSolution();
-      break;
-    }
-  }
-  return SOLVED;
-}
-
 // Gomory's cut
 Constraint ILPModel::FindGomoryCut(
     LPModel &model, Constraint non_integral_variable_constraint) {
@@ -127,9 +26,33 @@ Constraint ILPModel::FindGomoryCut(
   return con;
 }
 
-// Convert the raw problem into the relaxed linear programming model.
-LPModel ILPModel::ToRelaxedLPModel() {
-  LPModel model;
+void ILPModel::CollectIntegerVariables() {
+  integer_vars_.clear();
+  for (auto constraint : model_.constraints) {
+    for (auto entry : constraint.expression.variable_coeff)
+      if (entry.first.type == INTEGER) integer_vars_.insert(entry.first);
+  }
+}
+
+// The standard form appends a row for each equation after the other rows, the
+// equations are split in place so that the constraints added to the model
+// (branching constraints, cuts) come last.
+ILPModel ILPModel::SplitEquations() {
+  ILPModel split({{}, model_.opt_obj});
+  for (auto constraint : model_.constraints) {
+    if (constraint.equation_type == Constraint::Type::EQ) {
+      constraint.equation_type = Constraint::Type::GE;
+      split.AddConstraint(constraint);
+      constraint.equation_type = Constraint::Type::LE;
+    }
+    split.AddConstraint(constraint);
+  }
+  return split;
+}
+
+// The raw problem without the integer constraints.
+Model ILPModel::ToRelaxedModel() {
+  Model model = {{}, OptimizationObject(FLOAT)};
 
   for (auto constraint : model_.constraints) {
     auto con = Constraint(FLOAT);
@@ -147,7 +70,7 @@ LPModel ILPModel::ToRelaxedLPModel() {
     exp.constant = constraint.expression.constant;
     exp.constant.To(FLOAT);
     con.expression = exp;
-    model.AddConstraint(con);
+    model.constraints.push_back(con);
   }
   OptimizationObject obj(FLOAT);
   for (auto &entry : model_.opt_obj.expression.variable_coeff) {
@@ -160,8 +83,13 @@ LPModel ILPModel::ToRelaxedLPModel() {
   obj.opt_type = model_.opt_obj.opt_type;
   obj.expression.constant = model_.opt_obj.expression.constant;
   obj.expression.constant.To(FLOAT);
-  model.SetOptimizationObject(obj);
+  model.opt_obj = obj;
+  return model;
+}
 
+// Convert the raw problem into the relaxed linear programming model.
+LPModel ILPModel::ToRelaxedLPModel() {
+  LPModel model(ToRelaxedModel());
   model.ToStandardForm();
   model.ToSlackForm();
   return model;
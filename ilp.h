@@ -9,11 +9,352 @@
  */
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <queue>
+#include <thread>
+#include <tuple>
 
 #include "base.h"
 #include "lp.h"
 
+// Whether `value` is an integer, up to the integrality tolerance.
+bool IsIntegral(real_t value);
+
+struct BranchAndBoundStatistics {
+  // The nodes whose relaxation was solved.
+  int nodes = 0;
+  // The largest number of open nodes at a time, and the largest memory of the
+  // open nodes at a time (in bytes).
+  int max_open_nodes = 0;
+  size_t max_open_node_bytes = 0;
+  // The nodes whose relaxation started from the basis of their parent.
+  int warm_started_nodes = 0;
+  // The dual simplex pivots of all the relaxations.
+  int lp_iterations = 0;
+  // The nodes a thread took from the deque of another thread.
+  int steals = 0;
+  // The relaxations solved by strong branching (included in lp_iterations).
+  int strong_branching_lps = 0;
+  // The relaxations solved by the primal heuristics (included in
+  // lp_iterations), and the incumbents they found.
+  int heuristic_lps = 0;
+  int heuristic_solutions = 0;
+  // The runs of the improvement heuristics (RINS, local branching) started in
+  // the background.
+  int improvement_runs = 0;
+  // The bounds tightened by the propagation and by the reduced costs, and the
+  // nodes that the propagation proved infeasible without solving their LP.
+  int propagated_bounds = 0;
+  int reduced_cost_fixings = 0;
+  int propagation_cutoffs = 0;
+  // Whether the search stopped at the node or the time limit.
+  bool limit_reached = false;
+};
+
+// An integral solution of the model (over the variables of the relaxation),
+// and its objective in the maximization sense.
+struct PrimalSolution {
+  real_t bound;
+  Num optimum;
+  std::map<Variable, Num> solution;
+};
+
+/* The pseudocosts of the branching variables: the average loss of the bound
+ * of the relaxation per unit of change of a variable, when it is branched down
+ * (to floor(v), a change of f = v - floor(v)) and up (a change of 1 - f). A
+ * variable without record gets the average pseudocost of the others, or 1.
+ * The records are shared by the threads of the branch and bound.
+ */
+class Pseudocosts {
+ public:
+  struct Update {
+    Variable var;
+    bool up;
+    real_t gain;
+  };
+
+  void Apply(const std::vector<Update> &updates);
+  real_t Get(Variable var, bool up);
+  // The number of records of the direction of `var` with the fewest.
+  int Count(Variable var);
+
+ private:
+  struct Record {
+    real_t sum[2] = {0, 0};
+    int count[2] = {0, 0};
+  };
+
+  std::mutex mutex_;
+  std::map<Variable, Record> records_;
+  Record total_;
+};
+
+/* The variables of the relaxations of a branch and bound, numbered in the
+ * order they are met, so that the nodes refer to them by index: a bound change
+ * stores the index of its variable, and a basis the bitset of the indices of
+ * its variables. Shared by the threads of the branch and bound.
+ */
+class VariableDictionary {
+ public:
+  int Index(const Variable &var);
+  Variable Get(int index);
+
+  std::vector<uint64_t> Compress(const std::set<Variable> &vars);
+  std::set<Variable> Decompress(const std::vector<uint64_t> &bits);
+
+ private:
+  std::mutex mutex_;
+  std::map<Variable, int> indices_;
+  std::vector<Variable> vars_;
+};
+
+/* Activity-based bound propagation on the rows lhs <= sum_j a_j x_j <= rhs of
+ * a relaxation. Each row keeps its minimal and maximal activity over the
+ * domains (the finite part, and the number of infinite contributions), which
+ * are updated incrementally when a bound changes. The rows whose activity
+ * changed are propagated: each of their variables is bounded by the row and
+ * the activity of the other variables, rounded for the integer variables.
+ *
+ * The rows are shared by the copies of a propagator, a copy only owns the
+ * domains and the activities, so that the nodes start from a copy of the
+ * root.
+ */
+class DomainPropagator {
+ public:
+  // The rows of `relaxation` on a single variable are the initial domains.
+  DomainPropagator(const Model &relaxation,
+                   const std::set<Variable> &integer_vars);
+
+  // Tightens the bound of `var` (of the relaxation) to x <= value, or
+  // x >= value if not `upper`. Returns false if the domain becomes empty.
+  bool Tighten(Variable var, bool upper, real_t value);
+  // Propagates the rows whose activity changed, returns false if a row can
+  // not be satisfied.
+  bool Propagate();
+  // The bounds of the integer variables tightened since the last call, as
+  // (var, upper, value).
+  std::vector<std::tuple<Variable, bool, real_t>> TakeTightenedBounds();
+
+  real_t Lower(Variable var);
+  real_t Upper(Variable var);
+
+ private:
+  struct Row {
+    std::vector<std::pair<int, real_t>> entries;
+    real_t lhs, rhs;
+  };
+  struct Rows {
+    std::map<Variable, int> indices;
+    std::vector<Variable> vars;
+    std::vector<bool> integer;
+    std::vector<Row> rows;
+    // The (row, coefficient) of each variable.
+    std::vector<std::vector<std::pair<int, real_t>>> columns;
+  };
+  // The finite part of an activity, and its number of infinite terms.
+  struct Activity {
+    real_t finite = 0;
+    int infinite = 0;
+  };
+
+  bool Tighten(int var, bool upper, real_t value);
+  // The term a * x of the minimal (or maximal) activity, +-inf if unbounded.
+  real_t Term(int var, real_t coeff, bool max);
+  void AddTerm(Activity &activity, real_t term, real_t sign);
+  bool PropagateRow(int row);
+
+  std::shared_ptr<const Rows> rows_;
+  std::vector<real_t> lower_, upper_;
+  std::vector<Activity> min_activity_, max_activity_;
+  std::vector<bool> queued_;
+  std::deque<int> queue_;
+  std::set<std::pair<int, bool>> tightened_;
+};
+
+struct CuttingPlaneStatistics {
+  // The rounds of cuts, each reoptimizes the relaxation once.
+  int rounds = 0;
+  // The cuts added to the relaxation, and taken out of it by the aging.
+  int cuts_added = 0;
+  int cuts_removed = 0;
+  // The dual simplex pivots of the reoptimizations.
+  int lp_iterations = 0;
+  // The optimum of the relaxation before and after the cuts.
+  real_t initial_bound = 0;
+  real_t final_bound = 0;
+};
+
+/* A cut sum_j a_j x_j >= b over the variables of the relaxation. The pool
+ * keeps each cut once (up to a positive scaling). A cut is active while it is
+ * a row of the relaxation: it ages at each round where it is slack, is reset
+ * when it is tight, and leaves the relaxation when it is too old. It then
+ * stays in the pool, and comes back if it is violated again.
+ */
+struct Cut {
+  std::map<Variable, real_t> coeffs;
+  real_t rhs = 0;
+  int age = 0;
+  bool active = false;
+
+  // b - a x, positive if `solution` violates the cut.
+  real_t Violation(const std::map<Variable, Num> &solution) const;
+  // The distance from `solution` to the hyperplane of the cut.
+  real_t Efficacy(const std::map<Variable, Num> &solution) const;
+  // The cosine of the angle of the normals of the cuts.
+  real_t Parallelism(const Cut &other) const;
+};
+
+class CutPool {
+ public:
+  // Adds `cut` unless the pool has it, returns its index or -1.
+  int Add(Cut cut);
+  bool Contains(const Cut &cut) { return keys_.count(Key(cut)) > 0; }
+  // Ages the active cuts at `solution`. The cuts older than `max_age` are
+  // deactivated and returned.
+  std::vector<int> Age(const std::map<Variable, Num> &solution, int max_age);
+
+  Cut &Get(int index) { return cuts_[index]; }
+  int Size() { return cuts_.size(); }
+
+ private:
+  std::string Key(const Cut &cut);
+
+  std::vector<Cut> cuts_;
+  std::set<std::string> keys_;
+};
+
+struct BranchAndPriceStatistics {
+  // The nodes of the tree, and the Ryan-Foster branchings.
+  int nodes = 0;
+  int branchings = 0;
+  // The pricing rounds (each solves the dual of a restricted master), and the
+  // columns they added to the pool.
+  int pricing_rounds = 0;
+  int columns_generated = 0;
+  // The dual simplex pivots of the restricted masters and their duals.
+  int lp_iterations = 0;
+  // The nodes whose pricing stopped at the round limit before converging:
+  // they keep the bound of their parent, and if their solution is integral
+  // the node is closed without a proof that it is optimal.
+  int unconverged_nodes = 0;
+  // The branch and bounds on the columns of the pool: at the root for a first
+  // incumbent, and at the fractional nodes that do not branch.
+  int restricted_master_solves = 0;
+  // Whether the search stopped at the node or the time limit.
+  bool limit_reached = false;
+};
+
+// A column of the master problem of a branch and price: its variable, its cost
+// in the objective, and its non-zero coefficients by row of the master.
+struct Column {
+  Variable var;
+  real_t cost = 0;
+  std::map<int, real_t> coefficients;
+};
+
+// A Ryan-Foster branch on the rows `first` and `second` of a set partitioning
+// master: they are covered by the same column if `together`, by different
+// columns otherwise.
+struct RowPairBranch {
+  int first, second;
+  bool together;
+};
+
+// Whether `column` can be part of a solution of a node with `branches`.
+bool IsCompatible(const Column &column,
+                  const std::vector<RowPairBranch> &branches);
+
+/* The pricing problem of a branch and price. Given the duals u of the rows of
+ * the master, so that the reduced cost of a column is cost - sum_i u_i a_i,
+ * returns columns of negative reduced cost for a minimization (positive for a
+ * maximization) that are compatible with the branches of the node, or none if
+ * there is none. The best column is enough, more columns save pricing rounds.
+ */
+using Pricer = std::function<std::vector<Column>(
+    const std::vector<real_t> &duals,
+    const std::vector<RowPairBranch> &branches)>;
+
+/* The columns of a branch and price, shared by all its nodes: a column priced
+ * at a node enters the restricted master of every later node whose branches
+ * it is compatible with. The pool keeps the columns with the same
+ * coefficients once, with the best cost.
+ */
+class ColumnPool {
+ public:
+  // Adds `column`, named "column<index>" if its variable is undefined, or
+  // improves the cost of the column of the pool with the same coefficients.
+  // `sign` is 1 for a maximization and -1 for a minimization. Returns the
+  // index of the column, or -1 if the pool has it at a cost as good.
+  int Add(Column column, real_t sign);
+
+  const Column &Get(int index) { return columns_[index]; }
+  int Size() { return columns_.size(); }
+  const std::vector<Column> &Columns() { return columns_; }
+
+ private:
+  std::string Key(const Column &column);
+
+  std::vector<Column> columns_;
+  std::map<std::string, int> indices_;
+};
+
+/* Runs the improvement heuristics of a branch and bound in a background
+ * thread, one run at a time. A run leaves its solutions here, the search takes
+ * them between its nodes. Stopping raises the cutoff of the run to infinity,
+ * so that its sub problems prune all their nodes and return.
+ */
+class BackgroundHeuristics {
+ public:
+  BackgroundHeuristics(std::shared_ptr<std::atomic<real_t>> cutoff)
+      : cutoff_(cutoff) {}
+  ~BackgroundHeuristics() { Stop(); }
+
+  // Starts `run` unless a run is in progress, returns whether it did.
+  bool Start(std::function<std::vector<PrimalSolution>()> run);
+  // The solutions found since the last call.
+  std::vector<PrimalSolution> Take();
+  // Interrupts the run in progress and waits for it.
+  void Stop();
+
+ private:
+  std::shared_ptr<std::atomic<real_t>> cutoff_;
+  // Guards the solutions, and the thread when a run starts.
+  std::mutex mutex_;
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+  bool started_ = false;
+  std::vector<PrimalSolution> solutions_;
+};
+
+struct BranchAndBoundNode;
+struct NodeResult;
+
+// A non-basic integer variable of an optimal relaxation, at `value` (its upper
+// bound if `at_upper`, its lower bound otherwise), in a domain of width
+// `range`: moving it away from its bound by t lowers the bound of the
+// relaxation by at least `cost` * t.
+struct ReducedCost {
+  Variable var;
+  real_t value;
+  bool at_upper;
+  real_t range;
+  real_t cost;
+};
+
+// A bound x <= value (or x >= value) of a node, on the variable of index `var`
+// in the VariableDictionary.
+struct BoundChange {
+  int var;
+  bool upper;
+  real_t value;
+};
+
 class ILPModel {
  public:
   ILPModel(Model model) : model_(model) {}
@@ -31,13 +372,178 @@ class ILPModel {
   // (https://en.wikipedia.org/wiki/Branch_and_bound)
   Result BranchAndBoundSolve();
 
-  // Solves the integer programming problem with the cutting plane method.
-  // (https://en.wikipedia.org/wiki/Cutting-plane_method)
+  // The order in which the branch and bound explores the open nodes. The
+  // bound of a node is the optimum of its parent's relaxation, its estimate
+  // that bound minus the expected loss of rounding the fractional variables.
+  enum NodeSelection {
+    // The node with the best bound first: the fewest nodes to prove the
+    // optimality, but the incumbent is found late.
+    BEST_BOUND,
+    // The deepest node first until an incumbent is found (it dives to a
+    // feasible solution), the best bound afterwards.
+    DEPTH_FIRST,
+    // The node with the best estimate first, with the best bound every few
+    // nodes to move the global bound.
+    BEST_ESTIMATE,
+  };
+
+  void SetNodeSelection(NodeSelection node_selection) {
+    node_selection_ = node_selection;
+  }
+
+  // How the branch and bound picks the fractional variable to branch on.
+  enum BranchingRule {
+    // The first one, in the order of the variables.
+    FIRST_FRACTIONAL,
+    // The best product of the expected losses down and up, predicted by the
+    // pseudocosts.
+    PSEUDOCOST,
+    // Pseudocost branching, but the variables with fewer than a few records
+    // are evaluated by strong branching (solving the relaxations of both
+    // children), which initializes their pseudocosts.
+    RELIABILITY,
+  };
+
+  void SetBranchingRule(BranchingRule branching_rule) {
+    branching_rule_ = branching_rule;
+  }
+
+  // The relaxation of a node is solved by the dual simplex method from the
+  // optimal basis of its parent, which stays dual feasible after a bound
+  // change. Otherwise it is solved from the slack basis.
+  void SetEnableWarmStart(bool enable_warm_start) {
+    enable_warm_start_ = enable_warm_start;
+  }
+
+  // Each node propagates its bounds on the rows of the model before its LP is
+  // solved, and fixes the bounds of the non-basic integer variables that can
+  // not move by more than (bound - incumbent) / reduced cost, with the reduced
+  // costs of its relaxation (for its children) and of the root (for every
+  // node).
+  void SetEnablePropagation(bool enable_propagation) {
+    enable_propagation_ = enable_propagation;
+  }
+
+  /* The branch and bound runs on `threads` threads, each with its own deque of
+   * nodes: a thread selects its next node in its deque by the node selection
+   * (the newest node for a dive), and steals the oldest node of another deque
+   * when its own is empty. The incumbent and the global bound are shared
+   * atomics.
+   *
+   * The search depends on the timing of the threads, unless it is
+   * deterministic: it then runs in rounds, each thread solves a work unit of
+   * nodes from its own deque with the incumbent of the start of the round,
+   * and the incumbents are merged and the nodes rebalanced between the rounds.
+   */
+  void SetNumThreads(int threads) {
+    assert(threads > 0);
+    threads_ = threads;
+  }
+  void SetDeterministic(bool deterministic) { deterministic_ = deterministic; }
+
+  /* The primal heuristics look for integral solutions near the relaxations of
+   * the nodes, so that the branch and bound prunes early. Simple rounding runs
+   * at each node, the dives every few nodes, RENS and the feasibility pump at
+   * the root. The LPs of the dives and of the pump start from the basis of the
+   * node.
+   *
+   * Once there is an incumbent, the improvement heuristics (RINS, then local
+   * branching) run in a background thread each time it improves. Their sub
+   * problems are solved by a branch and bound with node and time limits,
+   * which prunes by the incumbent of the main search (the shared cutoff). They
+   * do not run in the deterministic search, whose tree would depend on the
+   * timing.
+   */
+  enum PrimalHeuristic {
+    // Rounds each fractional variable in the direction no row locks, or to
+    // the nearest integer.
+    SIMPLE_ROUNDING = 1 << 0,
+    // Solves the sub problem where the integral variables are fixed and the
+    // fractional ones are restricted to their two nearest integers, with a
+    // limited branch and bound.
+    RENS = 1 << 1,
+    // Bounds the least fractional variable to its nearest integer, and
+    // resolves the relaxation, until it is integral.
+    FRACTIONAL_DIVING = 1 << 2,
+    // Dives on the variable with the fewest locks in one direction, in that
+    // direction.
+    COEFFICIENT_DIVING = 1 << 3,
+    // Alternates between rounding the relaxation and solving the LP closest
+    // (in the L1 norm over the integer variables) to the rounded point.
+    FEASIBILITY_PUMP = 1 << 4,
+    // Solves the sub problem where the integer variables with the same value
+    // in the incumbent and in the relaxation of a node are fixed.
+    RINS = 1 << 5,
+    // Solves the sub problem of the solutions at an L1 distance (the Hamming
+    // distance for binary variables) of at most a few from the incumbent.
+    LOCAL_BRANCHING = 1 << 6,
+    ALL_HEURISTICS = (1 << 7) - 1,
+  };
+
+  void SetPrimalHeuristics(int heuristics) { heuristics_ = heuristics; }
+  void SetHeuristicFrequency(int frequency) {
+    assert(frequency > 0);
+    heuristic_frequency_ = frequency;
+  }
+
+  // The branch and bound stops after `node_limit` nodes or `seconds` (0 for no
+  // limit), with the best solution found if any. The nodes of all the threads
+  // count, the deterministic search checks the limits between its rounds.
+  void SetNodeLimit(int node_limit) { node_limit_ = node_limit; }
+  void SetTimeLimit(real_t seconds) { time_limit_ = seconds; }
+
+  const BranchAndBoundStatistics& GetBranchAndBoundStatistics() {
+    return branch_and_bound_statistics_;
+  }
+
+  /* Solves the integer programming problem with the cutting plane method.
+   * (https://en.wikipedia.org/wiki/Cutting-plane_method)
+   * Each round separates Gomory mixed-integer cuts from the rows of the
+   * optimal tableau, adds the best ones to the relaxation and reoptimizes it
+   * with the dual simplex method. If the rounds stall before the solution is
+   * integral, the branch and bound finishes on the model with the cuts.
+   */
   Result CuttingPlaneSolve();
 
+  const CuttingPlaneStatistics &GetCuttingPlaneStatistics() {
+    return cutting_plane_statistics_;
+  }
+
+  /* Solves the integer programming problem with the branch and price method.
+   * (https://en.wikipedia.org/wiki/Branch_and_price)
+   * The model is the master problem: its constraints are the rows, its
+   * variables (possibly none) the initial columns, all non-negative integers.
+   * The other columns are only known to `pricer`. Each node solves its
+   * relaxation by column generation: the dual of the restricted master (the
+   * columns of the pool compatible with the node) gives the duals of the
+   * pricing problem, until the pricer has no column to add. Artificial columns
+   * of a large cost keep the restricted master feasible, a node is infeasible
+   * if one of them is still used at the end.
+   *
+   * A fractional solution is branched on with the Ryan-Foster rule: two rows
+   * r, s covered together by a fractional amount of columns are covered by the
+   * same column in one child and by different columns in the other. The pricer
+   * honors the branches in its sub problem, and the pool only gives each node
+   * its compatible columns. The rule is complete for set partitioning masters
+   * (0/1 columns, rows = 1) only, so any other master never branches. A node
+   * that does not branch, for the master or for the lack of a pair, is
+   * finished by the branch and bound on its columns, as is the root for a
+   * first incumbent. The node and time limits apply.
+   */
+  Result BranchAndPriceSolve(Pricer pricer);
+
+  const BranchAndPriceStatistics &GetBranchAndPriceStatistics() {
+    return branch_and_price_statistics_;
+  }
+  // The columns of the last branch and price, the generated ones included.
+  const std::vector<Column> &GetColumns() { return column_pool_->Columns(); }
+
   Constraint FindGomoryCut(LPModel &model,
                            Constraint non_integral_variable_constraint);
 
+  // The raw problem without the integer constraints.
+  Model ToRelaxedModel();
+
   LPModel ToRelaxedLPModel();
 
   std::string ToString() {
@@ -59,8 +565,238 @@ class ILPModel {
   // OptimizationObject opt_obj_;
   Num optimum_;
   std::map<Variable, Num> solution_;
+
+  // The branch and bound of a sub problem of the heuristics: it prunes the
+  // nodes that are not better than `cutoff`, and raises it with its
+  // incumbent.
+  Result BranchAndBoundSolve(std::shared_ptr<std::atomic<real_t>> cutoff);
+
+  // The integer variables of the constraints.
+  void CollectIntegerVariables();
+  // The model with each equation split into two inequalities in place, the
+  // standard form then appends no row after the constraints added later.
+  ILPModel SplitEquations();
+  // Solves `relaxation` into `model`, from `basis` if it is the optimal basis
+  // of a relaxation with the same first `rows` rows (of the slack form), and
+  // replaces them with the optimal basis and the rows of `relaxation`.
+  Result SolveRelaxation(const Model &relaxation, std::set<Variable> &basis,
+                         int &rows, LPModel &model,
+                         BranchAndBoundStatistics &statistics);
+  // `relaxation` (the relaxation of the root by default) with the bounds of
+  // the integer variables applied natively: their rows on a single variable
+  // are replaced with the tightest bounds, and a variable with a lower bound l
+  // is shifted (x = l + x'), so that its bounds are the non-negativity and the
+  // upper bound of x'. Returns false if some bounds cross.
+  bool ApplyBoundChanges(const Model &relaxation,
+                         const std::vector<BoundChange> &changes,
+                         Model &bounded, std::map<Variable, real_t> &shifts);
+  // Solves the relaxation of a node, and keeps its optimal basis in the node
+  // for its children. The optimum and the solution are those of the unshifted
+  // variables.
+  Result SolveNodeRelaxation(BranchAndBoundNode &node, Num &optimum,
+                             std::map<Variable, Num> &solution,
+                             BranchAndBoundStatistics &statistics,
+                             const Model *relaxation = nullptr,
+                             std::vector<ReducedCost> *reduced_costs = nullptr);
+  // Propagates the bounds of `node`, with the root reduced-cost fixing
+  // against `incumbent`, and adds the tightened bounds to the node. Returns
+  // false if the node is infeasible.
+  bool PropagateNode(BranchAndBoundNode &node, real_t incumbent,
+                     BranchAndBoundStatistics &statistics);
+  // Fixes the bounds of `node` by the reduced costs of a relaxation whose
+  // bound is `bound`.
+  void FixByReducedCosts(BranchAndBoundNode &node,
+                         const std::vector<ReducedCost> &reduced_costs,
+                         real_t bound, real_t incumbent,
+                         BranchAndBoundStatistics &statistics);
+  // Adds x <= value (or x >= value if not `upper`) to the bounds of `node`,
+  // replacing the bound it tightens.
+  void AddBoundChange(BranchAndBoundNode &node, Variable var, bool upper,
+                      real_t value);
+  // Solves a node whose bound is better than `incumbent`, and branches on it
+  // if its solution is fractional.
+  void ProcessNode(BranchAndBoundNode &node, real_t incumbent,
+                   BranchAndBoundStatistics &statistics, NodeResult &result);
+  // Picks the variable to branch on among the fractional ones (var, value),
+  // and records the pseudocost updates of strong branching in `result`.
+  // Returns -1 when strong branching proves that the node is infeasible.
+  int SelectBranchingVariable(
+      BranchAndBoundNode &node,
+      const std::vector<std::pair<Variable, real_t>> &candidates,
+      BranchAndBoundStatistics &statistics, NodeResult &result);
+  // Runs the primal heuristics on a node with a fractional relaxation, and
+  // keeps the solutions better than `incumbent` in `result`.
+  void RunPrimalHeuristics(BranchAndBoundNode &node, NodeResult &result,
+                           real_t incumbent,
+                           BranchAndBoundStatistics &statistics);
+  // The number of rows of the model that may be violated by decreasing
+  // (first) or increasing (second) each variable of the relaxation.
+  void ComputeLocks();
+  // Fills `primal` if `solution` is integral and satisfies the model.
+  bool ToPrimalSolution(const std::map<Variable, Num> &solution,
+                        PrimalSolution &primal);
+  bool SimpleRounding(const std::map<Variable, Num> &solution,
+                      PrimalSolution &primal);
+  bool Dive(BranchAndBoundNode node, std::map<Variable, Num> solution,
+            bool coefficient, real_t incumbent,
+            BranchAndBoundStatistics &statistics, PrimalSolution &primal);
+  bool RensRounding(const std::map<Variable, Num> &solution,
+                    PrimalSolution &primal);
+  // Solves `sub`, a restriction of the model, with the limits of the sub
+  // problems of the heuristics.
+  bool SolveSubproblem(ILPModel &sub, int node_limit, PrimalSolution &primal);
+  bool Rins(const std::map<Variable, Num> &incumbent,
+            const std::map<Variable, Num> &relaxation, PrimalSolution &primal);
+  bool LocalBranching(const std::map<Variable, Num> &incumbent,
+                      PrimalSolution &primal);
+  // Starts RINS and local branching in `background` around `incumbent` and
+  // the relaxation of a node, unless a run is in progress.
+  bool StartImprovementHeuristics(BackgroundHeuristics &background,
+                                  const std::map<Variable, Num> &incumbent,
+                                  const std::map<Variable, Num> &relaxation);
+  bool FeasibilityPump(const BranchAndBoundNode &node,
+                       std::map<Variable, Num> solution,
+                       BranchAndBoundStatistics &statistics,
+                       PrimalSolution &primal);
+  // The Gomory mixed-integer cuts of the rows of the optimal tableau of
+  // `model` whose basic variable is integral but has a fractional value.
+  std::vector<Cut> SeparateGomoryCuts(LPModel &model);
+  Result ParallelBranchAndBoundSolve(
+      std::chrono::steady_clock::time_point start);
+  Result DeterministicBranchAndBoundSolve(
+      std::chrono::steady_clock::time_point start);
+  // Whether `nodes` processed nodes or the time since `start` reach the node
+  // or the time limit.
+  bool LimitReached(std::chrono::steady_clock::time_point start, int nodes);
+  // Keeps the optimum and the solution, over the integer variables.
+  void SetBranchAndBoundSolution(Num optimum,
+                                 const std::map<Variable, Num> &solution);
+  // The relaxation of a node of the branch and price by column generation
+  // with `pricer`. Sets the objective of the last restricted master (of the
+  // maximization), the values of its columns by index in the pool, and
+  // whether the pricing converged, that is, whether the objective is the
+  // bound of the node.
+  Result SolveMasterRelaxation(const Pricer &pricer,
+                               const std::vector<RowPairBranch> &branches,
+                               real_t &objective,
+                               std::map<int, real_t> &values, bool &converged);
+  // The branch and bound on the columns of the pool compatible with
+  // `branches`, returns whether it found a solution.
+  bool SolveRestrictedMaster(const std::vector<RowPairBranch> &branches,
+                             real_t &bound, std::map<int, real_t> &values);
+  // Two rows covered together by a fractional amount of the columns, the
+  // closest to 1/2.
+  bool FindRyanFosterPair(const std::map<int, real_t> &values, int &first,
+                          int &second);
+
+  NodeSelection node_selection_ = DEPTH_FIRST;
+  BranchingRule branching_rule_ = RELIABILITY;
+  bool enable_warm_start_ = true;
+  bool enable_propagation_ = true;
+  int threads_ = 1;
+  bool deterministic_ = false;
+  int heuristics_ = ALL_HEURISTICS;
+  int heuristic_frequency_ = 10;
+  int node_limit_ = 0;
+  real_t time_limit_ = 0;
+  std::set<Variable> integer_vars_;
+  std::map<Variable, std::pair<int, int>> locks_;
+  // Created by each branch and bound, the copies of the model in the nodes
+  // do not have one.
+  std::shared_ptr<Pseudocosts> pseudocosts_;
+  // The relaxation of the root of the current branch and bound, the nodes
+  // only store their bounds.
+  Model root_relaxation_ = {{}, OptimizationObject(FLOAT)};
+  std::shared_ptr<VariableDictionary> variables_;
+  // The domains of the root before propagation, copied by each node, and the
+  // reduced costs and the bound of the relaxation of the root.
+  std::shared_ptr<const DomainPropagator> propagator_;
+  std::vector<ReducedCost> root_reduced_costs_;
+  real_t root_bound_ = 0;
+  // The cutoff of the current branch and bound, shared with the sub problems
+  // of its heuristics.
+  std::shared_ptr<std::atomic<real_t>> cutoff_;
+  BranchAndBoundStatistics branch_and_bound_statistics_;
+  CuttingPlaneStatistics cutting_plane_statistics_;
+  std::shared_ptr<ColumnPool> column_pool_ = std::make_shared<ColumnPool>();
+  BranchAndPriceStatistics branch_and_price_statistics_;
 };
 
-// TODO: Implement the branch-and-cut method.
+// An open node of the branch and bound tree: the bounds of its sub problem
+// (relative to the root), and the bound and the estimate (of the maximization)
+// of its best integral solution. The basis is the optimal basis of the
+// parent's relaxation (a bitset of the VariableDictionary), whose slack form
+// has `rows` rows. The bounds do not add rows, so the basis of the parent is a
+// basis of the node.
+struct BranchAndBoundNode {
+  std::vector<BoundChange> bound_changes;
+  real_t bound, estimate;
+  int depth = 0;
+  int id = -1;
+  std::vector<uint64_t> basis;
+  int rows = 0;
+  // The branching that created the node, x <= floor(v) or x >= floor(v) + 1,
+  // and the distance from v to that bound.
+  Variable branch_var;
+  bool branch_up = false;
+  real_t branch_distance = 0;
 
-// TODO: Implement the branch-and-price method.
+  // The memory of the node, in bytes.
+  size_t Bytes() const {
+    return sizeof(BranchAndBoundNode) +
+           bound_changes.capacity() * sizeof(BoundChange) +
+           basis.capacity() * sizeof(uint64_t);
+  }
+};
+
+// The outcome of processing a node: its relaxation is infeasible (NOSOLUTION),
+// unbounded, or SOLVED with `bound`. A solved node is pruned by the incumbent,
+// or has an integral solution, or has children.
+struct NodeResult {
+  Result result = NOSOLUTION;
+  real_t bound = 0;
+  bool integral = false;
+  Num optimum;
+  std::map<Variable, Num> solution;
+  std::vector<BranchAndBoundNode> children;
+  // The losses observed while processing the node, the caller applies them
+  // to the pseudocosts.
+  std::vector<Pseudocosts::Update> pseudocost_updates;
+  // The solutions found by the primal heuristics, each better than the last.
+  std::vector<PrimalSolution> primal_solutions;
+};
+
+// The open nodes, selected in the order of the node selection. The nodes are
+// kept by id, the heaps of (priority, tie-breaker, id) are cleaned lazily.
+class NodeQueue {
+ public:
+  NodeQueue(ILPModel::NodeSelection node_selection)
+      : node_selection_(node_selection) {}
+
+  void Push(BranchAndBoundNode node);
+  // The next node to explore, the selection may depend on whether an
+  // incumbent is known.
+  BranchAndBoundNode Pop(bool has_incumbent);
+  // Drops the nodes whose bound is not better than the incumbent.
+  void Prune(real_t incumbent);
+  // The best bound of the open nodes, -inf if there are none.
+  real_t Bound();
+
+  bool Empty() { return nodes_.empty(); }
+  int Size() { return nodes_.size(); }
+  // The memory of the open nodes, in bytes.
+  size_t Bytes() { return bytes_; }
+
+ private:
+  using Heap = std::priority_queue<std::tuple<real_t, int, int>>;
+
+  void Clean(Heap& heap);
+
+  ILPModel::NodeSelection node_selection_;
+  std::map<int, BranchAndBoundNode> nodes_;
+  Heap bound_heap_, selection_heap_;
+  int next_id_ = 0, pops_ = 0;
+  size_t bytes_ = 0;
+};
+
+// TODO: Implement the branch-and-cut method.
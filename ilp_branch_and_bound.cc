@@ -0,0 +1,971 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "ilp.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// BEST_ESTIMATE selects the node with the best bound every this many nodes.
+const int kBestBoundFrequency = 10;
+// The nodes a thread solves in a round of the deterministic branch and bound.
+const int kWorkUnitNodes = 8;
+const real_t kIntegralityTolerance = 1e-6;
+// A variable is reliable once it has this many pseudocost records both ways.
+const int kReliabilityThreshold = 4;
+// Strong branching evaluates at most this many unreliable variables, and stops
+// after this many without a better score.
+const int kMaxStrongBranchingCandidates = 8;
+const int kStrongBranchingLookahead = 4;
+// The expected losses are at least this much in the product score, so that a
+// zero loss one way does not hide the loss the other way.
+const real_t kMinBranchingLoss = 1e-6;
+
+bool IsIntegral(real_t value) {
+  return std::abs(value - std::round(value)) < kIntegralityTolerance;
+}
+
+void NodeQueue::Push(BranchAndBoundNode node) {
+  node.id = next_id_++;
+  // The max-heaps break the ties by the oldest node, or the newest one when
+  // diving.
+  bound_heap_.push({node.bound, -node.id, node.id});
+  if (node_selection_ == ILPModel::DEPTH_FIRST)
+    selection_heap_.push({node.depth, node.id, node.id});
+  if (node_selection_ == ILPModel::BEST_ESTIMATE)
+    selection_heap_.push({node.estimate, -node.id, node.id});
+  bytes_ += node.Bytes();
+  nodes_.emplace(node.id, std::move(node));
+}
+
+void NodeQueue::Clean(Heap& heap) {
+  while (!heap.empty() and !nodes_.count(std::get<2>(heap.top()))) heap.pop();
+}
+
+BranchAndBoundNode NodeQueue::Pop(bool has_incumbent) {
+  assert(!nodes_.empty());
+  bool best_bound = true;
+  switch (node_selection_) {
+    case ILPModel::BEST_BOUND:
+      break;
+    case ILPModel::DEPTH_FIRST:
+      best_bound = has_incumbent;
+      break;
+    case ILPModel::BEST_ESTIMATE:
+      best_bound = pops_ % kBestBoundFrequency == kBestBoundFrequency - 1;
+      break;
+  }
+  pops_++;
+  auto& heap = best_bound ? bound_heap_ : selection_heap_;
+  Clean(heap);
+  auto iter = nodes_.find(std::get<2>(heap.top()));
+  heap.pop();
+  auto node = std::move(iter->second);
+  nodes_.erase(iter);
+  bytes_ -= node.Bytes();
+  return node;
+}
+
+void NodeQueue::Prune(real_t incumbent) {
+  for (auto iter = nodes_.begin(); iter != nodes_.end();) {
+    if (iter->second.bound <= incumbent) {
+      bytes_ -= iter->second.Bytes();
+      iter = nodes_.erase(iter);
+    } else {
+      iter++;
+    }
+  }
+  // Rebuilds the heaps, so that they do not keep the pruned nodes.
+  Heap bound_heap, selection_heap;
+  auto rebuild = [&](Heap& heap, Heap& rebuilt) {
+    for (; !heap.empty(); heap.pop())
+      if (nodes_.count(std::get<2>(heap.top()))) rebuilt.push(heap.top());
+    heap.swap(rebuilt);
+  };
+  rebuild(bound_heap_, bound_heap);
+  rebuild(selection_heap_, selection_heap);
+}
+
+real_t NodeQueue::Bound() {
+  Clean(bound_heap_);
+  if (bound_heap_.empty()) return -std::numeric_limits<real_t>::infinity();
+  return std::get<0>(bound_heap_.top());
+}
+
+void Pseudocosts::Apply(const std::vector<Update>& updates) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& update : updates) {
+    auto& record = records_[update.var];
+    record.sum[update.up] += update.gain;
+    record.count[update.up]++;
+    total_.sum[update.up] += update.gain;
+    total_.count[update.up]++;
+  }
+}
+
+real_t Pseudocosts::Get(Variable var, bool up) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = records_.find(var);
+  if (iter != records_.end() and iter->second.count[up] > 0)
+    return iter->second.sum[up] / iter->second.count[up];
+  if (total_.count[up] > 0) return total_.sum[up] / total_.count[up];
+  return 1;
+}
+
+int Pseudocosts::Count(Variable var) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = records_.find(var);
+  if (iter == records_.end()) return 0;
+  return std::min(iter->second.count[0], iter->second.count[1]);
+}
+
+real_t BranchingScore(real_t down_loss, real_t up_loss) {
+  return std::max(down_loss, kMinBranchingLoss) *
+         std::max(up_loss, kMinBranchingLoss);
+}
+
+int VariableDictionary::Index(const Variable& var) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = indices_.find(var);
+  if (iter != indices_.end()) return iter->second;
+  indices_[var] = vars_.size();
+  vars_.push_back(var);
+  return vars_.size() - 1;
+}
+
+Variable VariableDictionary::Get(int index) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return vars_[index];
+}
+
+std::vector<uint64_t> VariableDictionary::Compress(
+    const std::set<Variable>& vars) {
+  std::vector<uint64_t> bits;
+  for (auto& var : vars) {
+    int index = Index(var);
+    if (bits.size() <= index / 64) bits.resize(index / 64 + 1);
+    bits[index / 64] |= uint64_t(1) << (index % 64);
+  }
+  bits.shrink_to_fit();
+  return bits;
+}
+
+std::set<Variable> VariableDictionary::Decompress(
+    const std::vector<uint64_t>& bits) {
+  std::set<Variable> vars;
+  for (auto i = 0; i < bits.size(); i++)
+    for (auto j = 0; j < 64; j++)
+      if (bits[i] >> j & 1) vars.insert(Get(i * 64 + j));
+  return vars;
+}
+
+/* The slack form of the relaxation keeps the rows of the parent first, so the
+ * parent's basis plus the slack variables of the new rows is a basis of the
+ * node. It stays dual feasible: the costs are the same, and the bounds of the
+ * variables are not rows but bounds of the dual simplex method. A basis that
+ * does not fit (a bound made a free variable non-negative) is dropped for the
+ * slack basis.
+ */
+Result ILPModel::SolveRelaxation(const Model& relaxation,
+                                 std::set<Variable>& basis, int& rows,
+                                 LPModel& model,
+                                 BranchAndBoundStatistics& statistics) {
+  model = LPModel(relaxation);
+  model.ToStandardForm();
+  model.ExtractUpperBounds();
+  model.ToSlackForm();
+  model.ToTableau(COLUMN_ONLY);
+
+  std::set<Variable> start;
+  int model_rows = model.model_.constraints.size();
+  if (enable_warm_start_ and !basis.empty() and rows <= model_rows) {
+    start = basis;
+    for (auto i = rows; i < model_rows; i++) {
+      for (auto entry : model.model_.constraints[i].expression.variable_coeff)
+        if (model.base_variables_.count(entry.first)) start.insert(entry.first);
+    }
+    for (auto var : start) {
+      if (!model.base_variables_.count(var) and
+          !model.non_base_variables_.count(var)) {
+        start.clear();
+        break;
+      }
+    }
+    if (start.size() != model_rows) start.clear();
+    if (!start.empty()) statistics.warm_started_nodes++;
+  }
+  auto result = model.TableauDualSimplexSolve(start);
+  statistics.lp_iterations += model.GetTableauDualSimplexIterations();
+  if (result != SOLVED) return result;
+  basis = model.GetTableauBasis();
+  rows = model_rows;
+  return SOLVED;
+}
+
+bool ILPModel::ApplyBoundChanges(const Model& relaxation,
+                                 const std::vector<BoundChange>& changes,
+                                 Model& bounded,
+                                 std::map<Variable, real_t>& shifts) {
+  const real_t kInfinity = std::numeric_limits<real_t>::infinity();
+  // The lower and upper bounds of the integer variables.
+  std::map<Variable, std::pair<real_t, real_t>> bounds;
+  auto tighten = [&](Variable var, bool upper, real_t value) {
+    auto iter = bounds.emplace(var, std::make_pair(-kInfinity, kInfinity));
+    auto& bound = iter.first->second;
+    if (upper) {
+      bound.second = std::min(bound.second, value);
+    } else {
+      bound.first = std::max(bound.first, value);
+    }
+  };
+  bounded = {{}, relaxation.opt_obj};
+  for (auto& constraint : relaxation.constraints) {
+    Variable var;
+    real_t coeff = 0;
+    int nonzeros = 0;
+    for (auto entry : constraint.expression.variable_coeff) {
+      if (entry.second.IsZero()) continue;
+      var = entry.first;
+      coeff = ToReal(entry.second);
+      nonzeros++;
+    }
+    auto integer_var = var;
+    integer_var.To(INTEGER);
+    if (nonzeros != 1 or !integer_vars_.count(integer_var)) {
+      bounded.constraints.push_back(constraint);
+      continue;
+    }
+    // coeff * x + constant (<=, >=, =) compare.
+    real_t value = (ToReal(constraint.compare) -
+                    ToReal(constraint.expression.constant)) /
+                   coeff;
+    bool upper = constraint.equation_type == Constraint::Type::LE;
+    if (coeff < 0) upper = !upper;
+    if (constraint.equation_type == Constraint::Type::EQ) {
+      tighten(var, true, value);
+      tighten(var, false, value);
+    } else {
+      tighten(var, upper, value);
+    }
+  }
+  for (auto& change : changes) {
+    auto var = variables_->Get(change.var);
+    var.To(FLOAT);
+    tighten(var, change.upper, change.value);
+  }
+
+  for (auto& entry : bounds) {
+    auto var = entry.first;
+    real_t lower = entry.second.first, upper = entry.second.second;
+    if (lower > upper + kIntegralityTolerance) return false;
+    auto bound_row = [&](Constraint::Type type, real_t value) {
+      Constraint constraint(FLOAT);
+      constraint.SetEquationType(type);
+      constraint.SetCompare(Num(value));
+      constraint.expression.SetCoeffOf(var, Num(1.0));
+      bounded.constraints.push_back(constraint);
+    };
+    if (lower == -kInfinity) {
+      if (upper < kInfinity) bound_row(Constraint::Type::LE, upper);
+      continue;
+    }
+    if (lower != 0) {
+      shifts[var] = lower;
+      for (auto& constraint : bounded.constraints) {
+        auto iter = constraint.expression.variable_coeff.find(var);
+        if (iter == constraint.expression.variable_coeff.end()) continue;
+        constraint.expression.constant =
+            Num(ToReal(constraint.expression.constant) +
+                ToReal(iter->second) * lower);
+      }
+    }
+    // The non-negativity and the upper bound of the LP.
+    bound_row(Constraint::Type::GE, 0);
+    if (upper < kInfinity)
+      bound_row(Constraint::Type::LE, std::max(upper - lower, real_t(0)));
+  }
+  return true;
+}
+
+Result ILPModel::SolveNodeRelaxation(BranchAndBoundNode& node, Num& optimum,
+                                     std::map<Variable, Num>& solution,
+                                     BranchAndBoundStatistics& statistics,
+                                     const Model* relaxation,
+                                     std::vector<ReducedCost>* reduced_costs) {
+  if (relaxation == nullptr) relaxation = &root_relaxation_;
+  Model bounded = {{}, OptimizationObject(FLOAT)};
+  std::map<Variable, real_t> shifts;
+  if (!ApplyBoundChanges(*relaxation, node.bound_changes, bounded, shifts))
+    return NOSOLUTION;
+  LPModel model;
+  auto basis = variables_->Decompress(node.basis);
+  auto result = SolveRelaxation(bounded, basis, node.rows, model, statistics);
+  if (result != SOLVED) return result;
+  node.basis = variables_->Compress(basis);
+  real_t shifted_optimum = ToReal(model.GetTableauDualSimplexOptimum());
+  solution = model.GetTableauDualSimplexSolution();
+  auto& objective = relaxation->opt_obj.expression.variable_coeff;
+  for (auto entry : shifts) {
+    auto var = entry.first;
+    solution[var] = Num(ToReal(solution[var]) + entry.second);
+    auto iter = objective.find(var);
+    if (iter != objective.end())
+      shifted_optimum += ToReal(iter->second) * entry.second;
+  }
+  optimum = Num(shifted_optimum);
+  if (reduced_costs == nullptr) return SOLVED;
+  // The LP maximizes, a non-basic variable at its lower bound has a reduced
+  // cost >= 0 at the optimum and one at its upper bound a reduced cost <= 0.
+  reduced_costs->clear();
+  for (auto entry : model.variable_to_index_) {
+    auto var = entry.first;
+    auto col = entry.second;
+    if (col < 0 or col == model.constant_index_) continue;
+    if (model.tableau_is_base_variable_[col]) continue;
+    auto integer_var = var;
+    integer_var.To(INTEGER);
+    if (integer_vars_.find(integer_var) == integer_vars_.end()) continue;
+    bool at_upper = model.TableauAtUpperBound(col);
+    real_t cost = model.reduced_costs->At(col);
+    auto shift = shifts.find(var);
+    real_t lower = shift == shifts.end() ? 0 : shift->second;
+    real_t range = model.TableauUpperBound(col);
+    reduced_costs->push_back({var, at_upper ? lower + range : lower, at_upper,
+                              range, at_upper ? -cost : cost});
+  }
+  return SOLVED;
+}
+
+void ILPModel::AddBoundChange(BranchAndBoundNode& node, Variable var,
+                              bool upper, real_t value) {
+  var.To(FLOAT);
+  int index = variables_->Index(var);
+  for (auto& change : node.bound_changes) {
+    if (change.var != index or change.upper != upper) continue;
+    change.value = upper ? std::min(change.value, value)
+                         : std::max(change.value, value);
+    return;
+  }
+  node.bound_changes.push_back({index, upper, value});
+}
+
+/* Reliability branching scores the reliable variables by their pseudocosts,
+ * and the unreliable ones (the most promising first) by the losses of the
+ * relaxations of their children. A child that is infeasible is the best
+ * possible outcome: the node is then in fact a single child.
+ */
+int ILPModel::SelectBranchingVariable(
+    BranchAndBoundNode& node,
+    const std::vector<std::pair<Variable, real_t>>& candidates,
+    BranchAndBoundStatistics& statistics, NodeResult& result) {
+  if (branching_rule_ == FIRST_FRACTIONAL) return 0;
+  real_t sign = model_.opt_obj.opt_type == OptimizationObject::MIN ? -1 : 1;
+  std::vector<real_t> scores(candidates.size());
+  std::vector<int> unreliable;
+  for (auto i = 0; i < candidates.size(); i++) {
+    auto var = candidates[i].first;
+    real_t fraction = candidates[i].second - std::floor(candidates[i].second);
+    scores[i] = BranchingScore(pseudocosts_->Get(var, false) * fraction,
+                               pseudocosts_->Get(var, true) * (1 - fraction));
+    if (branching_rule_ == RELIABILITY and
+        pseudocosts_->Count(var) < kReliabilityThreshold)
+      unreliable.push_back(i);
+  }
+  std::stable_sort(unreliable.begin(), unreliable.end(),
+                   [&](int a, int b) { return scores[a] > scores[b]; });
+  if (unreliable.size() > kMaxStrongBranchingCandidates)
+    unreliable.resize(kMaxStrongBranchingCandidates);
+
+  int best = -1, without_improvement = 0;
+  real_t best_strong_score = -1;
+  for (auto i : unreliable) {
+    auto var = candidates[i].first;
+    real_t value = candidates[i].second, floor_value = std::floor(value);
+    real_t loss[2] = {0, 0};
+    bool infeasible[2] = {false, false};
+    for (auto up : {false, true}) {
+      BranchAndBoundNode child = {node.bound_changes, 0, 0, node.depth + 1};
+      child.basis = node.basis;
+      child.rows = node.rows;
+      AddBoundChange(child, var, !up, floor_value + up);
+      Num optimum;
+      std::map<Variable, Num> solution;
+      BranchAndBoundStatistics child_statistics;
+      auto child_result =
+          SolveNodeRelaxation(child, optimum, solution, child_statistics);
+      statistics.strong_branching_lps++;
+      statistics.lp_iterations += child_statistics.lp_iterations;
+      infeasible[up] = child_result == NOSOLUTION;
+      if (child_result != SOLVED) continue;
+      real_t distance = up ? floor_value + 1 - value : value - floor_value;
+      loss[up] = std::max(result.bound - sign * ToReal(optimum), real_t(0));
+      result.pseudocost_updates.push_back({var, up, loss[up] / distance});
+    }
+    if (infeasible[false] and infeasible[true]) return -1;
+    if (infeasible[false] or infeasible[true]) return i;
+    scores[i] = BranchingScore(loss[false], loss[true]);
+    if (scores[i] > best_strong_score) {
+      best_strong_score = scores[i];
+      without_improvement = 0;
+    } else if (++without_improvement >= kStrongBranchingLookahead) {
+      break;
+    }
+  }
+  for (auto i = 0; i < candidates.size(); i++)
+    if (best < 0 or scores[i] > scores[best]) best = i;
+  return best;
+}
+
+void ILPModel::ProcessNode(BranchAndBoundNode& node, real_t incumbent,
+                           BranchAndBoundStatistics& statistics,
+                           NodeResult& result) {
+  real_t sign = model_.opt_obj.opt_type == OptimizationObject::MIN ? -1 : 1;
+  statistics.nodes++;
+  if (enable_propagation_ and !PropagateNode(node, incumbent, statistics)) {
+    statistics.propagation_cutoffs++;
+    result.result = NOSOLUTION;
+    return;
+  }
+  std::vector<ReducedCost> reduced_costs;
+  result.result = SolveNodeRelaxation(
+      node, result.optimum, result.solution, statistics, nullptr,
+      enable_propagation_ ? &reduced_costs : nullptr);
+  if (result.result != SOLVED) return;
+  result.bound = sign * ToReal(result.optimum);
+  // The root is processed before any other node, by a single thread.
+  if (node.depth == 0 and enable_propagation_) {
+    root_reduced_costs_ = reduced_costs;
+    root_bound_ = result.bound;
+  }
+  // The loss of the branching that created the node, per unit of change.
+  if (node.branch_distance > 0) {
+    result.pseudocost_updates.push_back(
+        {node.branch_var, node.branch_up,
+         std::max(node.bound - result.bound, real_t(0)) /
+             node.branch_distance});
+  }
+  if (result.bound <= incumbent) return;
+
+  // The fractional variables, and the expected loss of rounding all of them:
+  // the smallest loss predicted by the pseudocosts for each.
+  std::vector<std::pair<Variable, real_t>> candidates;
+  real_t loss = 0;
+  for (auto entry : result.solution) {
+    auto var = entry.first;
+    var.To(INTEGER);
+    if (integer_vars_.find(var) == integer_vars_.end()) continue;
+    real_t value = ToReal(entry.second);
+    if (IsIntegral(value)) continue;
+    real_t fraction = value - std::floor(value);
+    loss += std::min(pseudocosts_->Get(var, false) * fraction,
+                     pseudocosts_->Get(var, true) * (1 - fraction));
+    candidates.push_back({var, value});
+  }
+  result.integral = candidates.empty();
+  if (result.integral) return;
+  RunPrimalHeuristics(node, result, incumbent, statistics);
+  if (enable_propagation_) {
+    // The children inherit the bounds fixed by the best solution known.
+    real_t best = incumbent;
+    for (auto& primal : result.primal_solutions)
+      best = std::max(best, primal.bound);
+    FixByReducedCosts(node, reduced_costs, result.bound, best, statistics);
+  }
+  int selected =
+      SelectBranchingVariable(node, candidates, statistics, result);
+  if (selected < 0) {
+    result.result = NOSOLUTION;
+    return;
+  }
+
+  // The optimal solution of this sub problem is better than the optimal so
+  // far, need to split it into more sub-problems.
+  auto branch_var = candidates[selected].first;
+  real_t branch_value = candidates[selected].second;
+  int floor_value = std::floor(branch_value);
+  for (auto up : {false, true}) {
+    BranchAndBoundNode child = {node.bound_changes, result.bound,
+                                result.bound - loss, node.depth + 1};
+    child.basis = node.basis;
+    child.rows = node.rows;
+    child.branch_var = branch_var;
+    child.branch_up = up;
+    child.branch_distance =
+        up ? floor_value + 1 - branch_value : branch_value - floor_value;
+    AddBoundChange(child, branch_var, !up, floor_value + up);
+    child.bound_changes.shrink_to_fit();
+    result.children.push_back(std::move(child));
+  }
+}
+
+void ILPModel::SetBranchAndBoundSolution(
+    Num optimum, const std::map<Variable, Num>& solution) {
+  optimum_ = optimum;
+  solution_.clear();
+  for (auto entry : solution) {
+    auto var = entry.first;
+    var.To(INTEGER);
+    solution_[var] = entry.second;
+  }
+}
+
+/* The branch and bound keeps the open nodes in a NodeQueue. A node is solved
+ * when it is selected: it is pruned if its relaxation is infeasible or not
+ * better than the incumbent, it updates the incumbent if the solution of its
+ * relaxation is integral. Otherwise it branches on a fractional variable x = v
+ * with the children x <= floor(v) and x >= floor(v) + 1. The bounds are those
+ * of the maximization, whatever the type of the objective.
+ */
+Result ILPModel::BranchAndBoundSolve() { return BranchAndBoundSolve(nullptr); }
+
+template <typename T>
+void AtomicMax(std::atomic<T>& value, T candidate) {
+  T current = value.load();
+  while (current < candidate and
+         !value.compare_exchange_weak(current, candidate)) {
+  }
+}
+
+Result ILPModel::BranchAndBoundSolve(
+    std::shared_ptr<std::atomic<real_t>> cutoff) {
+  const real_t kInfinity = std::numeric_limits<real_t>::infinity();
+  auto start = std::chrono::steady_clock::now();
+  CollectIntegerVariables();
+  ComputeLocks();
+  root_relaxation_ = SplitEquations().ToRelaxedModel();
+  variables_ = std::make_shared<VariableDictionary>();
+  root_reduced_costs_.clear();
+  root_bound_ = 0;
+  branch_and_bound_statistics_ = BranchAndBoundStatistics();
+  // The root is propagated once, so that a node only propagates the rows of
+  // its own bound changes. Its integer bounds become rows of the relaxation.
+  auto root = std::make_shared<DomainPropagator>(root_relaxation_,
+                                                 integer_vars_);
+  if (enable_propagation_) {
+    if (!root->Propagate()) {
+      branch_and_bound_statistics_.propagation_cutoffs++;
+      return NOSOLUTION;
+    }
+    for (auto& bound : root->TakeTightenedBounds()) {
+      Constraint constraint(FLOAT);
+      constraint.SetEquationType(std::get<1>(bound) ? Constraint::Type::LE
+                                                    : Constraint::Type::GE);
+      constraint.SetCompare(Num(std::get<2>(bound)));
+      constraint.expression.SetCoeffOf(std::get<0>(bound), Num(1.0));
+      root_relaxation_.constraints.push_back(constraint);
+      branch_and_bound_statistics_.propagated_bounds++;
+    }
+  }
+  propagator_ = root;
+  pseudocosts_ = std::make_shared<Pseudocosts>();
+  // Only a sub problem prunes by the cutoff: the cutoff of the main search
+  // may come from a solution of a sub problem it has not taken yet.
+  bool subproblem = cutoff != nullptr;
+  cutoff_ = subproblem ? cutoff
+                       : std::make_shared<std::atomic<real_t>>(-kInfinity);
+  if (threads_ > 1 and deterministic_)
+    return DeterministicBranchAndBoundSolve(start);
+  if (threads_ > 1) return ParallelBranchAndBoundSolve(start);
+
+  Result result = NOSOLUTION;
+  bool has_incumbent = false, improved = false;
+  real_t incumbent = -kInfinity;
+  std::map<Variable, Num> incumbent_solution;
+  NodeQueue queue(node_selection_);
+  BackgroundHeuristics background(cutoff_);
+  auto update_incumbent = [&](real_t bound, Num optimum,
+                              const std::map<Variable, Num>& solution) {
+    if (bound <= incumbent) return false;
+    incumbent = bound;
+    SetBranchAndBoundSolution(optimum, solution);
+    incumbent_solution = solution;
+    has_incumbent = improved = true;
+    result = SOLVED;
+    AtomicMax(*cutoff_, bound);
+    queue.Prune(incumbent);
+    return true;
+  };
+  auto take_background_solutions = [&]() {
+    for (auto& primal : background.Take()) {
+      if (update_incumbent(primal.bound, primal.optimum, primal.solution))
+        branch_and_bound_statistics_.heuristic_solutions++;
+    }
+  };
+  queue.Push({{}, kInfinity, kInfinity});
+  while (!queue.Empty()) {
+    if (LimitReached(start, branch_and_bound_statistics_.nodes)) {
+      branch_and_bound_statistics_.limit_reached = true;
+      break;
+    }
+    take_background_solutions();
+    if (subproblem) incumbent = std::max(incumbent, cutoff_->load());
+    if (queue.Empty()) break;
+    auto node = queue.Pop(has_incumbent);
+    if (node.bound <= incumbent) continue;
+    NodeResult node_result;
+    ProcessNode(node, incumbent, branch_and_bound_statistics_, node_result);
+    pseudocosts_->Apply(node_result.pseudocost_updates);
+    if (node_result.result == UNBOUNDED) return UNBOUNDED;
+    for (auto& primal : node_result.primal_solutions)
+      update_incumbent(primal.bound, primal.optimum, primal.solution);
+    if (node_result.result != SOLVED or node_result.bound <= incumbent)
+      continue;
+    if (node_result.integral) {
+      update_incumbent(node_result.bound, node_result.optimum,
+                       node_result.solution);
+      continue;
+    }
+    if (improved and StartImprovementHeuristics(background, incumbent_solution,
+                                                node_result.solution)) {
+      improved = false;
+      branch_and_bound_statistics_.improvement_runs++;
+    }
+    for (auto& child : node_result.children) queue.Push(std::move(child));
+    branch_and_bound_statistics_.max_open_nodes =
+        std::max(branch_and_bound_statistics_.max_open_nodes, queue.Size());
+    branch_and_bound_statistics_.max_open_node_bytes = std::max(
+        branch_and_bound_statistics_.max_open_node_bytes, queue.Bytes());
+  }
+  background.Stop();
+  take_background_solutions();
+  return result;
+}
+
+void MergeStatistics(BranchAndBoundStatistics& total,
+                     const BranchAndBoundStatistics& statistics) {
+  total.nodes += statistics.nodes;
+  total.warm_started_nodes += statistics.warm_started_nodes;
+  total.lp_iterations += statistics.lp_iterations;
+  total.steals += statistics.steals;
+  total.strong_branching_lps += statistics.strong_branching_lps;
+  total.heuristic_lps += statistics.heuristic_lps;
+  total.heuristic_solutions += statistics.heuristic_solutions;
+  total.improvement_runs += statistics.improvement_runs;
+  total.propagated_bounds += statistics.propagated_bounds;
+  total.reduced_cost_fixings += statistics.reduced_cost_fixings;
+  total.propagation_cutoffs += statistics.propagation_cutoffs;
+}
+
+bool ILPModel::LimitReached(std::chrono::steady_clock::time_point start,
+                            int nodes) {
+  std::chrono::duration<real_t> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return (node_limit_ > 0 and nodes >= node_limit_) or
+         (time_limit_ > 0 and elapsed.count() >= time_limit_);
+}
+
+// The position in `nodes` of the next node of a thread, selected as by
+// NodeQueue::Pop among the nodes of its own deque. Ties go to the newest.
+size_t SelectLocalNode(const std::deque<BranchAndBoundNode>& nodes,
+                       ILPModel::NodeSelection node_selection,
+                       bool has_incumbent, int pops) {
+  bool best_bound = true;
+  switch (node_selection) {
+    case ILPModel::BEST_BOUND:
+      break;
+    case ILPModel::DEPTH_FIRST:
+      if (!has_incumbent) return nodes.size() - 1;
+      break;
+    case ILPModel::BEST_ESTIMATE:
+      best_bound = pops % kBestBoundFrequency == kBestBoundFrequency - 1;
+      break;
+  }
+  auto priority = [&](size_t i) {
+    return best_bound ? nodes[i].bound : nodes[i].estimate;
+  };
+  size_t best = nodes.size() - 1;
+  for (size_t i = best; i-- > 0;)
+    if (priority(i) > priority(best)) best = i;
+  return best;
+}
+
+/* Each thread selects the next node of its own deque by the node selection,
+ * or steals the oldest node (the closest to the root, so the largest subtree)
+ * of the next non-empty deque. `pending` counts the nodes not processed yet,
+ * the children of a node are counted before the node is done, so the search
+ * is over when it reaches 0. The incumbent is read without locking, the lock
+ * only guards the update of its solution. The limits are checked before each
+ * node, on the nodes of all the threads.
+ */
+Result ILPModel::ParallelBranchAndBoundSolve(
+    std::chrono::steady_clock::time_point start) {
+  struct Worker {
+    std::mutex mutex;
+    std::deque<BranchAndBoundNode> nodes;
+    BranchAndBoundStatistics statistics;
+    // The nodes taken from its own deque.
+    int pops = 0;
+    // The bound of the node in process, -inf if none.
+    std::atomic<real_t> processing;
+    // The best bound of the nodes of the deque and of the node in process.
+    std::atomic<real_t> bound;
+  };
+  const real_t kInfinity = std::numeric_limits<real_t>::infinity();
+  std::vector<Worker> workers(threads_);
+  for (auto& worker : workers) worker.bound = worker.processing = -kInfinity;
+  workers[0].nodes.push_back({{}, kInfinity, kInfinity});
+  workers[0].bound = kInfinity;
+  std::atomic<real_t> incumbent(-kInfinity);
+  std::mutex incumbent_mutex;
+  std::map<Variable, Num> incumbent_solution;
+  std::atomic<int> pending(1), max_pending(1);
+  std::atomic<size_t> open_bytes(workers[0].nodes.front().Bytes()),
+      max_open_bytes(open_bytes.load());
+  std::atomic<bool> unbounded(false), solved(false), improved(false);
+  // The nodes processed by all the threads, checked against the node limit.
+  std::atomic<int> processed(0);
+  std::atomic<bool> stopped(false);
+  BackgroundHeuristics background(cutoff_);
+  // Takes the lock.
+  auto update_incumbent = [&](real_t bound, Num optimum,
+                              const std::map<Variable, Num>& solution) {
+    std::lock_guard<std::mutex> lock(incumbent_mutex);
+    if (bound <= incumbent) return false;
+    SetBranchAndBoundSolution(optimum, solution);
+    incumbent_solution = solution;
+    solved = improved = true;
+    incumbent = bound;
+    AtomicMax(*cutoff_, bound);
+    return true;
+  };
+  // The global bound: no open node can do better.
+  auto global_bound = [&]() {
+    real_t bound = -kInfinity;
+    for (auto& worker : workers) bound = std::max(bound, worker.bound.load());
+    return bound;
+  };
+  // Under the lock of the worker.
+  auto update_bound = [&](Worker& worker) {
+    real_t bound = worker.processing;
+    for (auto& node : worker.nodes) bound = std::max(bound, node.bound);
+    worker.bound = bound;
+  };
+
+#pragma omp parallel num_threads(threads_)
+  {
+    int id = 0;
+#ifdef _OPENMP
+    id = omp_get_thread_num();
+#endif
+    auto& worker = workers[id];
+    while (!unbounded and !stopped and pending > 0 and
+           global_bound() > incumbent) {
+      if (LimitReached(start, processed)) {
+        stopped = true;
+        break;
+      }
+      for (auto& primal : background.Take()) {
+        if (update_incumbent(primal.bound, primal.optimum, primal.solution))
+          worker.statistics.heuristic_solutions++;
+      }
+      BranchAndBoundNode node;
+      bool found = false;
+      {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.nodes.empty()) {
+          auto selected =
+              SelectLocalNode(worker.nodes, node_selection_,
+                              incumbent > -kInfinity, worker.pops++);
+          node = std::move(worker.nodes[selected]);
+          worker.nodes.erase(worker.nodes.begin() + selected);
+          found = true;
+          worker.processing = node.bound;
+          update_bound(worker);
+        }
+      }
+      for (auto k = 1; !found and k < threads_; k++) {
+        auto& victim = workers[(id + k) % threads_];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.nodes.empty()) continue;
+        node = std::move(victim.nodes.front());
+        victim.nodes.pop_front();
+        found = true;
+        worker.statistics.steals++;
+        // The thief publishes the bound before the victim forgets it, the
+        // victim keeps the bound of the node it is processing.
+        worker.processing = node.bound;
+        AtomicMax(worker.bound, real_t(node.bound));
+        update_bound(victim);
+      }
+      if (!found) {
+        std::this_thread::yield();
+        continue;
+      }
+      open_bytes -= node.Bytes();
+
+      NodeResult result;
+      if (node.bound > incumbent) {
+        processed++;
+        ProcessNode(node, incumbent, worker.statistics, result);
+        pseudocosts_->Apply(result.pseudocost_updates);
+        if (result.result == UNBOUNDED) unbounded = true;
+      }
+      if (result.result == SOLVED and result.integral and
+          result.bound > incumbent)
+        update_incumbent(result.bound, result.optimum, result.solution);
+      for (auto& primal : result.primal_solutions)
+        update_incumbent(primal.bound, primal.optimum, primal.solution);
+      if (!result.children.empty() and improved.exchange(false)) {
+        std::map<Variable, Num> center;
+        {
+          std::lock_guard<std::mutex> lock(incumbent_mutex);
+          center = incumbent_solution;
+        }
+        if (StartImprovementHeuristics(background, center, result.solution)) {
+          worker.statistics.improvement_runs++;
+        } else {
+          improved = true;
+        }
+      }
+      {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        for (auto& child : result.children) {
+          open_bytes += child.Bytes();
+          worker.nodes.push_back(std::move(child));
+        }
+        pending += result.children.size();
+        worker.processing = -kInfinity;
+        update_bound(worker);
+      }
+      AtomicMax(max_pending, pending.load());
+      AtomicMax(max_open_bytes, open_bytes.load());
+      pending -= 1;
+    }
+  }
+  background.Stop();
+  for (auto& primal : background.Take()) {
+    if (update_incumbent(primal.bound, primal.optimum, primal.solution))
+      branch_and_bound_statistics_.heuristic_solutions++;
+  }
+  for (auto& worker : workers)
+    MergeStatistics(branch_and_bound_statistics_, worker.statistics);
+  branch_and_bound_statistics_.limit_reached = stopped;
+  branch_and_bound_statistics_.max_open_nodes = max_pending;
+  branch_and_bound_statistics_.max_open_node_bytes = max_open_bytes;
+  if (unbounded) return UNBOUNDED;
+  return solved ? SOLVED : NOSOLUTION;
+}
+
+/* The rounds of the deterministic branch and bound. A round only depends on
+ * the deques and the incumbent at its start, whatever the timing of the
+ * threads. Between the rounds, the best new incumbent wins (the first thread
+ * on ties), and the empty deques take the oldest node of the largest deque
+ * (the first one on ties), which is the deterministic version of stealing.
+ */
+Result ILPModel::DeterministicBranchAndBoundSolve(
+    std::chrono::steady_clock::time_point start) {
+  struct Worker {
+    std::deque<BranchAndBoundNode> nodes;
+    BranchAndBoundStatistics statistics;
+    real_t incumbent;
+    Num optimum;
+    std::map<Variable, Num> solution;
+    std::vector<Pseudocosts::Update> pseudocost_updates;
+    bool unbounded = false;
+    int pops = 0;
+  };
+  const real_t kInfinity = std::numeric_limits<real_t>::infinity();
+  std::vector<Worker> workers(threads_);
+  workers[0].nodes.push_back({{}, kInfinity, kInfinity});
+  real_t incumbent = -kInfinity;
+  bool solved = false, unbounded = false;
+  auto open_nodes = [&]() {
+    int open = 0;
+    for (auto& worker : workers) open += worker.nodes.size();
+    return open;
+  };
+  auto open_bytes = [&]() {
+    size_t bytes = 0;
+    for (auto& worker : workers)
+      for (auto& node : worker.nodes) bytes += node.Bytes();
+    return bytes;
+  };
+
+  while (!unbounded and open_nodes() > 0) {
+    // The limits are checked between the rounds.
+    int processed = 0;
+    for (auto& worker : workers) processed += worker.statistics.nodes;
+    if (LimitReached(start, processed)) {
+      branch_and_bound_statistics_.limit_reached = true;
+      break;
+    }
+    // The work units of the last round share the nodes left to the limit.
+    int work_unit = kWorkUnitNodes;
+    if (node_limit_ > 0)
+      work_unit = std::min(work_unit, (node_limit_ - processed + threads_ - 1) /
+                                          threads_);
+    for (auto& worker : workers) worker.incumbent = incumbent;
+#pragma omp parallel for num_threads(threads_) schedule(static, 1)
+    for (auto id = 0; id < threads_; id++) {
+      auto& worker = workers[id];
+      for (auto k = 0; k < work_unit and !worker.nodes.empty(); k++) {
+        auto selected =
+            SelectLocalNode(worker.nodes, node_selection_,
+                            worker.incumbent > -kInfinity, worker.pops++);
+        auto node = std::move(worker.nodes[selected]);
+        worker.nodes.erase(worker.nodes.begin() + selected);
+        if (node.bound <= worker.incumbent) continue;
+        NodeResult result;
+        ProcessNode(node, worker.incumbent, worker.statistics, result);
+        worker.pseudocost_updates.insert(worker.pseudocost_updates.end(),
+                                         result.pseudocost_updates.begin(),
+                                         result.pseudocost_updates.end());
+        if (result.result == UNBOUNDED) {
+          worker.unbounded = true;
+          break;
+        }
+        for (auto& primal : result.primal_solutions) {
+          if (primal.bound <= worker.incumbent) continue;
+          worker.incumbent = primal.bound;
+          worker.optimum = primal.optimum;
+          worker.solution = primal.solution;
+        }
+        if (result.result != SOLVED or result.bound <= worker.incumbent)
+          continue;
+        if (result.integral) {
+          worker.incumbent = result.bound;
+          worker.optimum = result.optimum;
+          worker.solution = result.solution;
+          continue;
+        }
+        for (auto& child : result.children)
+          worker.nodes.push_back(std::move(child));
+      }
+    }
+
+    for (auto& worker : workers) {
+      pseudocosts_->Apply(worker.pseudocost_updates);
+      worker.pseudocost_updates.clear();
+      unbounded = unbounded or worker.unbounded;
+      if (worker.incumbent > incumbent) {
+        incumbent = worker.incumbent;
+        SetBranchAndBoundSolution(worker.optimum, worker.solution);
+        solved = true;
+      }
+    }
+    branch_and_bound_statistics_.max_open_nodes =
+        std::max(branch_and_bound_statistics_.max_open_nodes, open_nodes());
+    branch_and_bound_statistics_.max_open_node_bytes = std::max(
+        branch_and_bound_statistics_.max_open_node_bytes, open_bytes());
+    for (auto& worker : workers) {
+      if (!worker.nodes.empty()) continue;
+      auto largest = std::max_element(
+          workers.begin(), workers.end(), [](const Worker& a, const Worker& b) {
+            return a.nodes.size() < b.nodes.size();
+          });
+      if (largest->nodes.size() < 2) break;
+      worker.nodes.push_back(std::move(largest->nodes.front()));
+      largest->nodes.pop_front();
+      worker.statistics.steals++;
+    }
+  }
+  for (auto& worker : workers)
+    MergeStatistics(branch_and_bound_statistics_, worker.statistics);
+  if (unbounded) return UNBOUNDED;
+  return solved ? SOLVED : NOSOLUTION;
+}
@@ -0,0 +1,494 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <queue>
+
+#include "ilp.h"
+
+// A column prices out if its reduced cost (of the maximization) is above this,
+// a value above it is non-zero.
+const real_t kPricingTolerance = 1e-6;
+// The cost of the artificial columns of the restricted master, larger than
+// the cost of any solution.
+const real_t kArtificialCost = 1e6;
+// A node stops pricing after this many rounds. Its last restricted master is
+// then not a bound of its relaxation, the node keeps the bound of its parent.
+const int kMaxPricingRounds = 1000;
+// The branch and bound on the columns of the pool stops after this many nodes.
+const int kRestrictedMasterNodeLimit = 1000;
+
+bool IsCompatible(const Column& column,
+                  const std::vector<RowPairBranch>& branches) {
+  auto covers = [&](int row) {
+    auto iter = column.coefficients.find(row);
+    return iter != column.coefficients.end() and iter->second != 0;
+  };
+  for (auto& branch : branches) {
+    bool first = covers(branch.first), second = covers(branch.second);
+    if (branch.together ? first != second : first and second) return false;
+  }
+  return true;
+}
+
+// The coefficients, rounded.
+std::string ColumnPool::Key(const Column& column) {
+  std::string key;
+  for (auto entry : column.coefficients) {
+    if (entry.second == 0) continue;
+    key += std::to_string(entry.first) + " " +
+           std::to_string(std::llround(entry.second * 1e6)) + " ";
+  }
+  return key;
+}
+
+int ColumnPool::Add(Column column, real_t sign) {
+  auto key = Key(column);
+  auto iter = indices_.find(key);
+  if (iter != indices_.end()) {
+    auto& pooled = columns_[iter->second];
+    if (sign * column.cost <= sign * pooled.cost + kPricingTolerance) return -1;
+    pooled.cost = column.cost;
+    return iter->second;
+  }
+  int index = columns_.size();
+  if (column.var.IsUndefined())
+    column.var = Variable("column" + std::to_string(index));
+  column.var.To(INTEGER);
+  indices_[key] = index;
+  columns_.push_back(std::move(column));
+  return index;
+}
+
+// A row of the master as sum_j a_j x_j <= rhs (or = rhs if `equation`), where
+// the rows >= are negated (`sign` is -1). The artificial column of the row has
+// the coefficient `artificial` (0 if x = 0 satisfies the row).
+struct MasterRow {
+  real_t sign;
+  bool equation;
+  real_t rhs;
+  real_t artificial;
+};
+
+std::vector<MasterRow> MasterRows(const Model& model) {
+  std::vector<MasterRow> rows;
+  for (auto& constraint : model.constraints) {
+    MasterRow row;
+    row.sign = constraint.equation_type == Constraint::Type::GE ? -1 : 1;
+    row.equation = constraint.equation_type == Constraint::Type::EQ;
+    row.rhs = row.sign * (ToReal(constraint.compare) -
+                          ToReal(constraint.expression.constant));
+    row.artificial = 0;
+    if (row.rhs < -kPricingTolerance) row.artificial = -1;
+    if (row.equation and row.rhs > kPricingTolerance) row.artificial = 1;
+    rows.push_back(row);
+  }
+  return rows;
+}
+
+Variable ArtificialColumn(int row) {
+  return Variable("master_artificial" + std::to_string(row));
+}
+
+Variable RowDual(int row) {
+  return Variable("master_dual" + std::to_string(row));
+}
+
+/* The restricted master of a node is
+ *    max sum_j c'_j x_j - M sum_i y_i
+ *    s.t. sum_j a'_ij x_j + e_i y_i <= b'_i  (or = b'_i)
+ *      x, y >= 0
+ * with c' = c for a maximization and -c for a minimization, and the rows >=
+ * negated. Its dual
+ *    min sum_i b'_i u_i
+ *    s.t. sum_i a'_ij u_i >= c'_j, e_i u_i >= -M
+ *      u_i >= 0 for the rows <=
+ * gives the duals of the pricing: the reduced cost of a column is
+ * c'_j - sum_i a'_ij u_i. The loop solves the dual, which gains a row per
+ * column priced (so the last basis warm starts it), and the restricted master
+ * once the pricer has no column left.
+ */
+Result ILPModel::SolveMasterRelaxation(
+    const Pricer& pricer, const std::vector<RowPairBranch>& branches,
+    real_t& objective, std::map<int, real_t>& values, bool& converged) {
+  auto& statistics = branch_and_price_statistics_;
+  converged = false;
+  real_t sign = model_.opt_obj.opt_type == OptimizationObject::MIN ? -1 : 1;
+  auto rows = MasterRows(model_);
+  std::vector<int> active;
+  for (auto i = 0; i < column_pool_->Size(); i++)
+    if (IsCompatible(column_pool_->Get(i), branches)) active.push_back(i);
+
+  // The row of the dual of a column, false if the column has no rows and
+  // makes the master unbounded.
+  auto dual_row = [&](const Column& column, Constraint& constraint) {
+    constraint = Constraint(FLOAT);
+    constraint.SetEquationType(Constraint::Type::GE);
+    constraint.SetCompare(Num(sign * column.cost));
+    for (auto entry : column.coefficients) {
+      if (entry.second == 0 or entry.first >= rows.size()) continue;
+      constraint.expression.SetCoeffOf(
+          RowDual(entry.first), Num(rows[entry.first].sign * entry.second));
+    }
+    return !constraint.expression.variable_coeff.empty() or
+           sign * column.cost <= kPricingTolerance;
+  };
+  Model dual = {{}, OptimizationObject(FLOAT)};
+  dual.opt_obj.opt_type = OptimizationObject::MIN;
+  for (auto i = 0; i < rows.size(); i++) {
+    dual.opt_obj.expression.SetCoeffOf(RowDual(i), Num(rows[i].rhs));
+    if (rows[i].artificial != 0) {
+      Constraint constraint(FLOAT);
+      constraint.SetEquationType(Constraint::Type::GE);
+      constraint.SetCompare(Num(-kArtificialCost));
+      constraint.expression.SetCoeffOf(RowDual(i), Num(rows[i].artificial));
+      dual.constraints.push_back(constraint);
+    }
+    if (!rows[i].equation) {
+      Constraint constraint(FLOAT);
+      constraint.SetEquationType(Constraint::Type::GE);
+      constraint.SetCompare(Num(0.0));
+      constraint.expression.SetCoeffOf(RowDual(i), Num(1.0));
+      dual.constraints.push_back(constraint);
+    }
+  }
+  // The row of the dual of each column of the node, by index in the pool.
+  std::map<int, int> dual_rows;
+  auto add_dual_row = [&](int index) {
+    Constraint constraint(FLOAT);
+    if (!dual_row(column_pool_->Get(index), constraint)) return false;
+    if (constraint.expression.variable_coeff.empty()) return true;
+    auto iter = dual_rows.find(index);
+    if (iter != dual_rows.end()) {
+      // A better cost of a column of the node.
+      dual.constraints[iter->second] = constraint;
+      return true;
+    }
+    dual_rows[index] = dual.constraints.size();
+    dual.constraints.push_back(constraint);
+    return true;
+  };
+  for (auto i : active)
+    if (!add_dual_row(i)) return UNBOUNDED;
+
+  std::set<Variable> basis;
+  int basis_rows = 0;
+  for (auto round = 0; round < kMaxPricingRounds; round++) {
+    LPModel model;
+    BranchAndBoundStatistics lp_statistics;
+    auto result = SolveRelaxation(dual, basis, basis_rows, model,
+                                  lp_statistics);
+    statistics.lp_iterations += lp_statistics.lp_iterations;
+    statistics.pricing_rounds++;
+    // The restricted master is feasible, an infeasible dual means it is
+    // unbounded.
+    if (result == NOSOLUTION) return UNBOUNDED;
+    if (result != SOLVED) return NOSOLUTION;
+    auto solution = model.GetTableauDualSimplexSolution();
+    // The duals of the rows of the model, in the sense of its objective.
+    std::vector<real_t> duals(rows.size(), 0);
+    for (auto i = 0; i < rows.size(); i++) {
+      auto iter = solution.find(RowDual(i));
+      if (iter != solution.end())
+        duals[i] = sign * rows[i].sign * ToReal(iter->second);
+    }
+
+    int added = 0;
+    for (auto& column : pricer(duals, branches)) {
+      if (!IsCompatible(column, branches)) continue;
+      real_t reduced_cost = column.cost;
+      for (auto entry : column.coefficients)
+        if (entry.first < rows.size())
+          reduced_cost -= duals[entry.first] * entry.second;
+      if (sign * reduced_cost <= kPricingTolerance) continue;
+      int index = column_pool_->Add(column, sign);
+      if (index < 0) continue;
+      added++;
+      statistics.columns_generated++;
+      if (std::find(active.begin(), active.end(), index) == active.end())
+        active.push_back(index);
+      if (!add_dual_row(index)) return UNBOUNDED;
+    }
+    if (added == 0) {
+      converged = true;
+      break;
+    }
+  }
+
+  Model master = {{}, OptimizationObject(FLOAT)};
+  master.opt_obj.opt_type = OptimizationObject::MAX;
+  std::vector<Constraint> master_rows(rows.size(), Constraint(FLOAT));
+  auto non_negative = [&](Variable var) {
+    Constraint constraint(FLOAT);
+    constraint.SetEquationType(Constraint::Type::GE);
+    constraint.SetCompare(Num(0.0));
+    constraint.expression.SetCoeffOf(var, Num(1.0));
+    master.constraints.push_back(constraint);
+  };
+  for (auto i = 0; i < rows.size(); i++) {
+    master_rows[i].SetEquationType(rows[i].equation ? Constraint::Type::EQ
+                                                    : Constraint::Type::LE);
+    master_rows[i].SetCompare(Num(rows[i].rhs));
+    if (rows[i].artificial == 0) continue;
+    auto var = ArtificialColumn(i);
+    master.opt_obj.expression.SetCoeffOf(var, Num(-kArtificialCost));
+    master_rows[i].expression.SetCoeffOf(var, Num(rows[i].artificial));
+    non_negative(var);
+  }
+  for (auto i : active) {
+    auto& column = column_pool_->Get(i);
+    auto var = column.var;
+    var.To(FLOAT);
+    master.opt_obj.expression.SetCoeffOf(var, Num(sign * column.cost));
+    for (auto entry : column.coefficients) {
+      if (entry.second == 0 or entry.first >= rows.size()) continue;
+      master_rows[entry.first].expression.SetCoeffOf(
+          var, Num(rows[entry.first].sign * entry.second));
+    }
+    non_negative(var);
+  }
+  // The rows that no column covers are satisfied by x = 0, or have an
+  // artificial column.
+  for (auto& row : master_rows)
+    if (!row.expression.variable_coeff.empty())
+      master.constraints.push_back(row);
+
+  LPModel model;
+  std::set<Variable> master_basis;
+  int master_basis_rows = 0;
+  BranchAndBoundStatistics lp_statistics;
+  auto result = SolveRelaxation(master, master_basis, master_basis_rows, model,
+                                lp_statistics);
+  statistics.lp_iterations += lp_statistics.lp_iterations;
+  if (result != SOLVED) return result;
+  auto solution = model.GetTableauDualSimplexSolution();
+  for (auto i = 0; i < rows.size(); i++) {
+    auto iter = solution.find(ArtificialColumn(i));
+    if (iter != solution.end() and ToReal(iter->second) > kPricingTolerance)
+      return NOSOLUTION;
+  }
+  objective = ToReal(model.GetTableauDualSimplexOptimum()) +
+              sign * ToReal(model_.opt_obj.expression.constant);
+  values.clear();
+  for (auto i : active) {
+    auto var = column_pool_->Get(i).var;
+    var.To(FLOAT);
+    auto iter = solution.find(var);
+    values[i] = iter == solution.end() ? 0 : ToReal(iter->second);
+  }
+  return SOLVED;
+}
+
+bool ILPModel::SolveRestrictedMaster(const std::vector<RowPairBranch>& branches,
+                                     real_t& bound,
+                                     std::map<int, real_t>& values) {
+  real_t sign = model_.opt_obj.opt_type == OptimizationObject::MIN ? -1 : 1;
+  OptimizationObject objective(FLOAT);
+  objective.opt_type = model_.opt_obj.opt_type;
+  objective.expression.constant = model_.opt_obj.expression.constant;
+  std::vector<Constraint> rows;
+  for (auto& constraint : model_.constraints) {
+    Constraint row(FLOAT);
+    row.SetEquationType(constraint.equation_type);
+    row.SetCompare(Num(ToReal(constraint.compare) -
+                       ToReal(constraint.expression.constant)));
+    rows.push_back(row);
+  }
+  std::map<Variable, int> indices;
+  ILPModel restricted;
+  for (auto i = 0; i < column_pool_->Size(); i++) {
+    auto& column = column_pool_->Get(i);
+    if (!IsCompatible(column, branches)) continue;
+    indices[column.var] = i;
+    objective.expression.SetCoeffOf(column.var, Num(column.cost));
+    for (auto entry : column.coefficients) {
+      if (entry.second == 0 or entry.first >= rows.size()) continue;
+      rows[entry.first].expression.SetCoeffOf(column.var, Num(entry.second));
+    }
+    Constraint non_negative(FLOAT);
+    non_negative.SetEquationType(Constraint::Type::GE);
+    non_negative.SetCompare(Num(0.0));
+    non_negative.expression.SetCoeffOf(column.var, Num(1.0));
+    restricted.AddConstraint(non_negative);
+  }
+  for (auto& row : rows) {
+    if (!row.expression.variable_coeff.empty()) {
+      restricted.AddConstraint(row);
+      continue;
+    }
+    // A row without columns is satisfied by x = 0 or by nothing.
+    real_t rhs = ToReal(row.compare);
+    if ((row.equation_type != Constraint::Type::GE and rhs < 0) or
+        (row.equation_type != Constraint::Type::LE and rhs > 0))
+      return false;
+  }
+  if (indices.empty()) return false;
+  restricted.SetOptimizationObject(objective);
+  restricted.SetNodeLimit(kRestrictedMasterNodeLimit);
+  branch_and_price_statistics_.restricted_master_solves++;
+  if (restricted.BranchAndBoundSolve() != SOLVED) return false;
+  bound = sign * ToReal(restricted.GetOptimum());
+  values.clear();
+  for (auto entry : restricted.GetSolution()) {
+    auto iter = indices.find(entry.first);
+    if (iter != indices.end()) values[iter->second] = ToReal(entry.second);
+  }
+  return true;
+}
+
+bool ILPModel::FindRyanFosterPair(const std::map<int, real_t>& values,
+                                  int& first, int& second) {
+  // The amount of the columns covering each pair of rows.
+  std::map<std::pair<int, int>, real_t> together;
+  for (auto entry : values) {
+    if (entry.second < kPricingTolerance) continue;
+    std::vector<int> covered;
+    for (auto coeff : column_pool_->Get(entry.first).coefficients)
+      if (coeff.second != 0) covered.push_back(coeff.first);
+    for (auto i = 0; i < covered.size(); i++)
+      for (auto j = i + 1; j < covered.size(); j++)
+        together[{covered[i], covered[j]}] += entry.second;
+  }
+  real_t best = 1;
+  for (auto entry : together) {
+    if (IsIntegral(entry.second)) continue;
+    real_t fraction = entry.second - std::floor(entry.second);
+    real_t distance = std::abs(fraction - 0.5);
+    if (distance >= best) continue;
+    best = distance;
+    first = entry.first.first;
+    second = entry.first.second;
+  }
+  return best < 1;
+}
+
+// Whether the rows of `model` are sum_j a_j x_j = 1 with 0/1 coefficients.
+bool IsSetPartitioning(const Model& model) {
+  for (auto& constraint : model.constraints) {
+    if (constraint.equation_type != Constraint::Type::EQ) return false;
+    real_t rhs = ToReal(constraint.compare) -
+                 ToReal(constraint.expression.constant);
+    if (std::abs(rhs - 1) > kPricingTolerance) return false;
+    for (auto entry : constraint.expression.variable_coeff)
+      if (!entry.second.IsZero() and
+          std::abs(ToReal(entry.second) - 1) > kPricingTolerance)
+        return false;
+  }
+  return true;
+}
+
+/* Best-first search on the nodes, each a list of Ryan-Foster branches from the
+ * root. The pool of columns grows along the search, so a node gets the
+ * columns priced by all the nodes before it. The bounds are those of the
+ * maximization, whatever the type of the objective.
+ */
+Result ILPModel::BranchAndPriceSolve(Pricer pricer) {
+  const real_t kInfinity = std::numeric_limits<real_t>::infinity();
+  auto start = std::chrono::steady_clock::now();
+  real_t sign = model_.opt_obj.opt_type == OptimizationObject::MIN ? -1 : 1;
+  branch_and_price_statistics_ = BranchAndPriceStatistics();
+  column_pool_ = std::make_shared<ColumnPool>();
+  // The Ryan-Foster children of another master may both exclude its optimum,
+  // say two columns {r, s} and {s, t} of a covering.
+  bool partitioning = IsSetPartitioning(model_);
+  // The variables of the model are the initial columns.
+  std::map<Variable, Column> initial;
+  for (auto i = 0; i < model_.constraints.size(); i++) {
+    for (auto entry : model_.constraints[i].expression.variable_coeff)
+      if (!entry.second.IsZero())
+        initial[entry.first].coefficients[i] = ToReal(entry.second);
+  }
+  for (auto entry : model_.opt_obj.expression.variable_coeff)
+    initial[entry.first].cost = ToReal(entry.second);
+  for (auto& entry : initial) {
+    entry.second.var = entry.first;
+    column_pool_->Add(entry.second, sign);
+  }
+
+  struct PriceNode {
+    real_t bound;
+    std::vector<RowPairBranch> branches;
+  };
+  auto worse = [](const PriceNode& a, const PriceNode& b) {
+    return a.bound < b.bound;
+  };
+  std::priority_queue<PriceNode, std::vector<PriceNode>, decltype(worse)>
+      queue(worse);
+  queue.push({kInfinity, {}});
+  real_t incumbent = -kInfinity;
+  std::map<int, real_t> incumbent_values;
+  auto update_incumbent = [&](real_t bound,
+                              const std::map<int, real_t>& values) {
+    if (bound <= incumbent) return;
+    incumbent = bound;
+    incumbent_values = values;
+  };
+
+  while (!queue.empty()) {
+    auto node = queue.top();
+    queue.pop();
+    if (node.bound <= incumbent + kPricingTolerance) continue;
+    std::chrono::duration<real_t> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if ((node_limit_ > 0 and
+         branch_and_price_statistics_.nodes >= node_limit_) or
+        (time_limit_ > 0 and elapsed.count() >= time_limit_)) {
+      branch_and_price_statistics_.limit_reached = true;
+      break;
+    }
+    branch_and_price_statistics_.nodes++;
+    real_t objective;
+    std::map<int, real_t> values;
+    bool converged;
+    auto result = SolveMasterRelaxation(pricer, node.branches, objective,
+                                        values, converged);
+    if (result == UNBOUNDED) return UNBOUNDED;
+    if (result != SOLVED) continue;
+    // Before the pricing converges, the objective of the restricted master is
+    // only that of a solution of the node, its bound is still the parent's.
+    if (!converged) branch_and_price_statistics_.unconverged_nodes++;
+    real_t bound = converged ? objective : node.bound;
+    if (bound <= incumbent + kPricingTolerance) continue;
+    bool integral = true;
+    for (auto entry : values) integral = integral and IsIntegral(entry.second);
+    if (integral) {
+      update_incumbent(objective, values);
+      continue;
+    }
+    real_t restricted_bound;
+    std::map<int, real_t> restricted_values;
+    int first, second;
+    if (!partitioning or !FindRyanFosterPair(values, first, second)) {
+      // The node does not branch, the columns of the node give its best
+      // solution.
+      if (SolveRestrictedMaster(node.branches, restricted_bound,
+                                restricted_values))
+        update_incumbent(restricted_bound, restricted_values);
+      continue;
+    }
+    if (node.branches.empty() and
+        SolveRestrictedMaster(node.branches, restricted_bound,
+                              restricted_values))
+      update_incumbent(restricted_bound, restricted_values);
+    branch_and_price_statistics_.branchings++;
+    for (auto together : {true, false}) {
+      PriceNode child = {bound, node.branches};
+      child.branches.push_back({first, second, together});
+      queue.push(std::move(child));
+    }
+  }
+  if (incumbent == -kInfinity) return NOSOLUTION;
+
+  // The costs of the pool only improve, the optimum is that of the columns.
+  real_t optimum = ToReal(model_.opt_obj.expression.constant);
+  std::map<Variable, Num> solution;
+  for (auto i = 0; i < column_pool_->Size(); i++) {
+    auto& column = column_pool_->Get(i);
+    auto iter = incumbent_values.find(i);
+    real_t value =
+        iter == incumbent_values.end() ? 0 : std::round(iter->second);
+    optimum += column.cost * value;
+    solution[column.var] = Num(value);
+  }
+  SetBranchAndBoundSolution(Num(optimum), solution);
+  return SOLVED;
+}
@@ -0,0 +1,385 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ilp.h"
+
+// The cut rounds stop after this many rounds, or when the bound moved by less
+// than kCutStallTolerance (relatively) during the last kCutStallRounds rounds.
+const int kMaxCutRounds = 20;
+const int kCutStallRounds = 3;
+const real_t kCutStallTolerance = 1e-6;
+// The best cuts of a round that are efficient enough and not too parallel to
+// the cuts taken before them in the round.
+const int kMaxCutsPerRound = 20;
+const real_t kMinCutEfficacy = 1e-4;
+const real_t kMaxCutParallelism = 0.95;
+// An active cut that is slack for this many rounds leaves the relaxation.
+const int kMaxCutAge = 3;
+// The rows whose basic variable is too close to an integer, and the cuts whose
+// coefficients span too many orders of magnitude, are numerically unsafe.
+const real_t kMinCutFractionality = 1e-3;
+const real_t kMaxCutDynamism = 1e6;
+// The right-hand side of a cut is relaxed by this much (relatively) so that
+// the rounding errors never cut off an integral solution.
+const real_t kCutRelaxation = 1e-9;
+
+real_t Cut::Violation(const std::map<Variable, Num>& solution) const {
+  real_t activity = 0;
+  for (auto entry : coeffs) {
+    auto iter = solution.find(entry.first);
+    if (iter != solution.end()) activity += entry.second * ToReal(iter->second);
+  }
+  return rhs - activity;
+}
+
+real_t Cut::Efficacy(const std::map<Variable, Num>& solution) const {
+  real_t norm = 0;
+  for (auto entry : coeffs) norm += entry.second * entry.second;
+  return norm > 0 ? Violation(solution) / std::sqrt(norm) : 0;
+}
+
+real_t Cut::Parallelism(const Cut& other) const {
+  real_t dot = 0, norm = 0, other_norm = 0;
+  for (auto entry : coeffs) {
+    norm += entry.second * entry.second;
+    auto iter = other.coeffs.find(entry.first);
+    if (iter != other.coeffs.end()) dot += entry.second * iter->second;
+  }
+  for (auto entry : other.coeffs) other_norm += entry.second * entry.second;
+  if (norm == 0 or other_norm == 0) return 0;
+  return std::abs(dot) / std::sqrt(norm * other_norm);
+}
+
+// The coefficients and the right-hand side divided by the largest coefficient,
+// rounded.
+std::string CutPool::Key(const Cut& cut) {
+  real_t scale = 0;
+  for (auto entry : cut.coeffs) scale = std::max(scale, std::abs(entry.second));
+  if (scale == 0) scale = 1;
+  std::string key;
+  auto append = [&](real_t value) {
+    key += std::to_string(std::llround(value / scale * 1e6)) + " ";
+  };
+  for (auto entry : cut.coeffs) {
+    key += entry.first.ToString() + " ";
+    append(entry.second);
+  }
+  append(cut.rhs);
+  return key;
+}
+
+int CutPool::Add(Cut cut) {
+  if (!keys_.insert(Key(cut)).second) return -1;
+  cuts_.push_back(std::move(cut));
+  return cuts_.size() - 1;
+}
+
+std::vector<int> CutPool::Age(const std::map<Variable, Num>& solution,
+                              int max_age) {
+  std::vector<int> removed;
+  for (auto i = 0; i < cuts_.size(); i++) {
+    auto& cut = cuts_[i];
+    if (!cut.active) continue;
+    if (_IsNegative(cut.Violation(solution))) {
+      cut.age++;
+    } else {
+      cut.age = 0;
+    }
+    if (cut.age > max_age) {
+      cut.active = false;
+      cut.age = 0;
+      removed.push_back(i);
+    }
+  }
+  return removed;
+}
+
+/* A row of the optimal tableau reads x_B + sum_{j in N} a_j x_j = b, where
+ * each non-base variable at its upper bound u_j is complemented (x_j = u_j -
+ * x'_j), so that all the non-base variables are 0 and b is the value of x_B.
+ * With f_0 and f_j the fractional parts of b and a_j, the Gomory mixed-integer
+ * cut of a row with an integral x_B is
+ *    sum_{j integral, f_j <= f_0} f_j / f_0 x_j
+ *  + sum_{j integral, f_j > f_0} (1 - f_j) / (1 - f_0) x_j
+ *  + sum_{j continuous, a_j > 0} a_j / f_0 x_j
+ *  + sum_{j continuous, a_j < 0} -a_j / (1 - f_0) x_j >= 1.
+ * The slack variables are then replaced by their rows, so that the cut is over
+ * the variables of the relaxation. A slack is integral if its row only has
+ * integral coefficients on integral variables.
+ */
+std::vector<Cut> ILPModel::SeparateGomoryCuts(LPModel& model) {
+  auto is_slack = [](Variable var) {
+    return var.variable_name.find(kBase) == 0;
+  };
+  // s_i = b_i - sum_k a_ik x_k, from the row b_i - sum_k a_ik x_k - s_i = 0,
+  // as the constant b_i and the coefficients -a_ik.
+  std::map<Variable, Cut> slack_rows;
+  std::set<Variable> integral;
+  for (auto& constraint : model.model_.constraints) {
+    Variable slack;
+    Cut row;
+    row.rhs = ToReal(constraint.expression.constant);
+    bool integral_row = IsIntegral(row.rhs);
+    for (auto entry : constraint.expression.variable_coeff) {
+      if (is_slack(entry.first)) {
+        slack = entry.first;
+        continue;
+      }
+      real_t coeff = ToReal(entry.second);
+      auto var = entry.first;
+      var.To(INTEGER);
+      integral_row = integral_row and IsIntegral(coeff) and
+                     integer_vars_.find(var) != integer_vars_.end();
+      row.coeffs[entry.first] = coeff;
+    }
+    slack_rows[slack] = row;
+    if (integral_row) integral.insert(slack);
+  }
+  for (auto entry : model.variable_to_index_) {
+    auto var = entry.first;
+    var.To(INTEGER);
+    if (integer_vars_.find(var) == integer_vars_.end()) continue;
+    auto upper = model.upper_bounds_.find(entry.first);
+    if (upper == model.upper_bounds_.end() or IsIntegral(upper->second))
+      integral.insert(entry.first);
+  }
+
+  std::vector<Cut> cuts;
+  for (auto r = 0; r < model.base_variables_.size(); r++) {
+    auto basic = model.index_to_variable_[model.basis_indices[r]];
+    if (!integral.count(basic)) continue;
+    real_t value = model.basic_feasible_solution->At(r);
+    real_t f0 = value - std::floor(value);
+    if (f0 < kMinCutFractionality or f0 > 1 - kMinCutFractionality) continue;
+
+    // The tableau stores -A, its row rho_r^T T is -(B^{-1} A)_r.
+    auto row = model.TableauRevisedSimplexPriceRow(
+        model.basis_inverse->Row(r));
+    Cut cut;
+    cut.rhs = 1;
+    for (auto col = 0; col < model.constant_index_; col++) {
+      if (model.tableau_is_base_variable_[col]) continue;
+      real_t a = -row->At(col);
+      bool at_upper = model.TableauAtUpperBound(col);
+      if (at_upper) a = -a;
+      if (std::abs(a) < kEpsilonF) continue;
+      auto var = model.index_to_variable_[col];
+      real_t gamma;
+      if (integral.count(var)) {
+        real_t f = a - std::floor(a);
+        gamma = f <= f0 ? f / f0 : (1 - f) / (1 - f0);
+      } else {
+        gamma = a > 0 ? a / f0 : -a / (1 - f0);
+      }
+      if (gamma == 0) continue;
+      // gamma (u - x) for a complemented variable.
+      if (at_upper) {
+        cut.rhs -= gamma * model.TableauUpperBound(col);
+        gamma = -gamma;
+      }
+      auto slack_row = slack_rows.find(var);
+      if (slack_row == slack_rows.end()) {
+        cut.coeffs[var] += gamma;
+        continue;
+      }
+      cut.rhs -= gamma * slack_row->second.rhs;
+      for (auto term : slack_row->second.coeffs)
+        cut.coeffs[term.first] += gamma * term.second;
+    }
+    delete row;
+
+    // Drops the cancelled coefficients, and the cuts on the variables of the
+    // standard form that are not in the model.
+    real_t min_coeff = std::numeric_limits<real_t>::infinity(), max_coeff = 0;
+    bool valid = true;
+    for (auto iter = cut.coeffs.begin(); iter != cut.coeffs.end();) {
+      if (std::abs(iter->second) < kEpsilonF) {
+        iter = cut.coeffs.erase(iter);
+        continue;
+      }
+      if (iter->first.variable_name.find(kSubstitution) == 0) valid = false;
+      min_coeff = std::min(min_coeff, std::abs(iter->second));
+      max_coeff = std::max(max_coeff, std::abs(iter->second));
+      iter++;
+    }
+    // A cut on a single variable is a bound, it would not stay a row.
+    if (!valid or cut.coeffs.size() < 2 or
+        max_coeff > kMaxCutDynamism * min_coeff)
+      continue;
+    for (auto& entry : cut.coeffs) entry.second /= max_coeff;
+    cut.rhs /= max_coeff;
+    cut.rhs -= kCutRelaxation * std::max(real_t(1), std::abs(cut.rhs));
+    cuts.push_back(std::move(cut));
+  }
+  return cuts;
+}
+
+/* The relaxation of the cut rounds is the model followed by the active cuts,
+ * in the order they were added. The rows of the model stay the first rows, so
+ * the optimal basis of a round warm starts the next one: the new cuts add
+ * their slack variables to it, and a cut that leaves the relaxation takes its
+ * (basic, as the cut is slack) slack variable with it, and renames the slack
+ * variables of the rows after it.
+ */
+Result ILPModel::CuttingPlaneSolve() {
+  real_t sign = model_.opt_obj.opt_type == OptimizationObject::MIN ? -1 : 1;
+  CollectIntegerVariables();
+  cutting_plane_statistics_ = CuttingPlaneStatistics();
+  auto& statistics = cutting_plane_statistics_;
+  // The variables of the model, by their variable in the relaxation.
+  std::map<Variable, Variable> model_vars;
+  auto add_model_vars = [&](const Expression& expression) {
+    for (auto entry : expression.variable_coeff) {
+      auto var = entry.first;
+      var.To(FLOAT);
+      model_vars[var] = entry.first;
+    }
+  };
+  add_model_vars(model_.opt_obj.expression);
+  for (auto constraint : model_.constraints)
+    add_model_vars(constraint.expression);
+  auto to_constraint = [&](const Cut& cut) {
+    Constraint constraint(FLOAT);
+    constraint.equation_type = Constraint::Type::GE;
+    constraint.compare = Num(cut.rhs);
+    for (auto entry : cut.coeffs)
+      constraint.expression.SetCoeffOf(model_vars[entry.first],
+                                       Num(entry.second));
+    return constraint;
+  };
+
+  ILPModel root = SplitEquations();
+  CutPool pool;
+  // The active cuts, in the order of their rows.
+  std::vector<int> rows;
+  // The optimal basis of the last relaxation, and its rows.
+  std::set<Variable> basis;
+  int basis_rows = 0;
+  BranchAndBoundStatistics lp_statistics;
+  LPModel model;
+  std::vector<real_t> bounds;
+  Num optimum;
+  std::map<Variable, Num> solution;
+  bool integral = false;
+  while (true) {
+    ILPModel problem = root;
+    for (auto index : rows)
+      problem.AddConstraint(to_constraint(pool.Get(index)));
+    auto result = SolveRelaxation(problem.ToRelaxedModel(), basis, basis_rows,
+                                  model, lp_statistics);
+    if (result != SOLVED) return result;
+    optimum = model.GetTableauDualSimplexOptimum();
+    solution = model.GetTableauDualSimplexSolution();
+    bounds.push_back(sign * ToReal(optimum));
+    if (statistics.rounds == 0) statistics.initial_bound = ToReal(optimum);
+    statistics.final_bound = ToReal(optimum);
+
+    integral = true;
+    for (auto entry : solution) {
+      auto var = entry.first;
+      var.To(INTEGER);
+      if (integer_vars_.find(var) != integer_vars_.end() and
+          !IsIntegral(ToReal(entry.second)))
+        integral = false;
+    }
+    int round = bounds.size() - 1;
+    if (integral or round >= kMaxCutRounds) break;
+    if (round >= kCutStallRounds and
+        bounds[round - kCutStallRounds] - bounds[round] <=
+            kCutStallTolerance * std::max(real_t(1), std::abs(bounds[round])))
+      break;
+
+    // The cuts that left the relaxation, the slack variable of row
+    // `first_cut_row + k` belongs to the k-th active cut.
+    int first_cut_row = basis_rows - rows.size();
+    auto slack = [&](int k) {
+      return Variable(kBase + std::to_string(first_cut_row + k));
+    };
+    auto removed = pool.Age(solution, kMaxCutAge);
+    if (!removed.empty()) {
+      std::set<int> removed_set(removed.begin(), removed.end());
+      std::map<Variable, Variable> renamed;
+      std::vector<int> kept;
+      for (auto k = 0; k < rows.size(); k++) {
+        if (removed_set.count(rows[k])) {
+          renamed[slack(k)] = Variable();
+          continue;
+        }
+        renamed[slack(k)] = slack(kept.size());
+        kept.push_back(rows[k]);
+      }
+      std::set<Variable> renamed_basis;
+      for (auto var : basis) {
+        auto iter = renamed.find(var);
+        if (iter == renamed.end()) {
+          renamed_basis.insert(var);
+        } else if (!iter->second.IsUndefined()) {
+          renamed_basis.insert(iter->second);
+        }
+      }
+      basis = renamed_basis;
+      basis_rows = first_cut_row + kept.size();
+      statistics.cuts_removed += rows.size() - kept.size();
+      rows = kept;
+    }
+
+    // The new cuts and the violated cuts of the pool, the most efficient
+    // first.
+    std::vector<Cut> candidates;
+    std::vector<int> candidate_index;
+    for (auto& cut : SeparateGomoryCuts(model)) {
+      if (pool.Contains(cut)) continue;
+      candidates.push_back(cut);
+      candidate_index.push_back(-1);
+    }
+    for (auto i = 0; i < pool.Size(); i++) {
+      if (pool.Get(i).active or !_IsPositive(pool.Get(i).Violation(solution)))
+        continue;
+      candidates.push_back(pool.Get(i));
+      candidate_index.push_back(i);
+    }
+    std::vector<int> order(candidates.size());
+    std::vector<real_t> efficacy(candidates.size());
+    for (auto i = 0; i < candidates.size(); i++) {
+      order[i] = i;
+      efficacy[i] = candidates[i].Efficacy(solution);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](int a, int b) { return efficacy[a] > efficacy[b]; });
+    std::vector<int> selected;
+    for (auto i : order) {
+      if (selected.size() >= kMaxCutsPerRound or efficacy[i] < kMinCutEfficacy)
+        break;
+      bool parallel = false;
+      for (auto j : selected) {
+        if (candidates[i].Parallelism(candidates[j]) > kMaxCutParallelism) {
+          parallel = true;
+          break;
+        }
+      }
+      if (parallel) continue;
+      selected.push_back(i);
+      int index = candidate_index[i];
+      if (index < 0) index = pool.Add(candidates[i]);
+      if (index < 0) continue;
+      pool.Get(index).active = true;
+      pool.Get(index).age = 0;
+      rows.push_back(index);
+    }
+    if (selected.empty()) break;
+    statistics.cuts_added += selected.size();
+    statistics.rounds++;
+  }
+  statistics.lp_iterations = lp_statistics.lp_iterations;
+
+  if (integral) {
+    SetBranchAndBoundSolution(optimum, solution);
+    return SOLVED;
+  }
+  // The branch and bound finishes on the model strengthened by the cuts.
+  auto original = model_;
+  for (auto index : rows) AddConstraint(to_constraint(pool.Get(index)));
+  auto result = BranchAndBoundSolve();
+  model_ = original;
+  return result;
+}
@@ -0,0 +1,455 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ilp.h"
+
+// A row of the model is satisfied up to this tolerance (relative to its
+// right-hand side).
+const real_t kFeasibilityTolerance = 1e-6;
+// A dive bounds at most this many variables.
+const int kMaxDiveDepth = 50;
+// RENS only runs if at least this fraction of the integer variables is
+// integral in the relaxation, its branch and bound stops after this many
+// nodes.
+const real_t kRensMinFixingRate = 0.5;
+const int kRensNodeLimit = 200;
+// RINS only runs if at least this fraction of the integer variables agree
+// between the incumbent and the relaxation.
+const real_t kRinsMinFixingRate = 0.3;
+// Local branching searches the solutions at this distance from the incumbent.
+const int kLocalBranchingRadius = 10;
+// The limits of the sub problems of RINS and local branching.
+const int kSubproblemNodeLimit = 500;
+const real_t kSubproblemTimeLimit = 10;
+// The feasibility pump stops after this many LPs, and moves this many
+// variables of the rounded point when it cycles.
+const int kMaxPumpIterations = 20;
+const int kPumpFlips = 10;
+
+// Whether the variable of the relaxation `var` is an integer variable.
+bool IsIntegerVariable(const std::set<Variable>& integer_vars, Variable var) {
+  var.To(INTEGER);
+  return integer_vars.find(var) != integer_vars.end();
+}
+
+// The constraint x <= value, or x >= value if `up`, on the variable of the
+// relaxation `var`.
+Constraint BoundConstraint(Variable var, int value, bool up) {
+  var.To(INTEGER);
+  Constraint constraint(INTEGER);
+  constraint.expression = var - Num(value);
+  constraint.equation_type = up ? Constraint::Type::GE : Constraint::Type::LE;
+  return constraint;
+}
+
+// The locks of `var`, read without inserting so that the threads of the
+// branch and bound can share them.
+std::pair<int, int> GetLocks(
+    const std::map<Variable, std::pair<int, int>>& locks, Variable var) {
+  auto iter = locks.find(var);
+  return iter == locks.end() ? std::make_pair(0, 0) : iter->second;
+}
+
+// Rows on a single variable are bounds, rounding within the two nearest
+// integers never violates an integral bound.
+void ILPModel::ComputeLocks() {
+  locks_.clear();
+  auto add = [&](Variable var, int down, int up) {
+    var.To(FLOAT);
+    locks_[var].first += down;
+    locks_[var].second += up;
+  };
+  for (auto entry : model_.opt_obj.expression.variable_coeff)
+    add(entry.first, 0, 0);
+  for (auto& constraint : model_.constraints) {
+    auto& coeffs = constraint.expression.variable_coeff;
+    for (auto entry : coeffs) {
+      if (coeffs.size() < 2 or entry.second.IsZero()) {
+        add(entry.first, 0, 0);
+        continue;
+      }
+      bool positive = entry.second.IsPositive();
+      switch (constraint.equation_type) {
+        case Constraint::Type::LE:
+          add(entry.first, !positive, positive);
+          break;
+        case Constraint::Type::GE:
+          add(entry.first, positive, !positive);
+          break;
+        default:
+          add(entry.first, 1, 1);
+          break;
+      }
+    }
+  }
+}
+
+bool ILPModel::ToPrimalSolution(const std::map<Variable, Num>& solution,
+                                PrimalSolution& primal) {
+  std::map<Variable, Num> point;
+  for (auto entry : locks_) {
+    auto iter = solution.find(entry.first);
+    real_t value = iter == solution.end() ? 0 : ToReal(iter->second);
+    if (IsIntegerVariable(integer_vars_, entry.first)) {
+      if (!IsIntegral(value)) return false;
+      value = std::round(value);
+    }
+    point[entry.first] = Num(value);
+  }
+  auto evaluate = [&](const Expression& expression) {
+    real_t value = ToReal(expression.constant);
+    for (auto entry : expression.variable_coeff) {
+      auto var = entry.first;
+      var.To(FLOAT);
+      value += ToReal(entry.second) * ToReal(point[var]);
+    }
+    return value;
+  };
+  for (auto& constraint : model_.constraints) {
+    real_t lhs = evaluate(constraint.expression);
+    real_t rhs = ToReal(constraint.compare);
+    real_t tolerance = kFeasibilityTolerance * std::max(real_t(1), std::abs(rhs));
+    if (constraint.equation_type != Constraint::Type::GE and
+        lhs > rhs + tolerance)
+      return false;
+    if (constraint.equation_type != Constraint::Type::LE and
+        lhs < rhs - tolerance)
+      return false;
+  }
+  real_t objective = evaluate(model_.opt_obj.expression);
+  real_t sign = model_.opt_obj.opt_type == OptimizationObject::MIN ? -1 : 1;
+  primal = {sign * objective, Num(objective), point};
+  return true;
+}
+
+bool ILPModel::SimpleRounding(const std::map<Variable, Num>& solution,
+                              PrimalSolution& primal) {
+  auto rounded = solution;
+  for (auto& entry : rounded) {
+    if (!IsIntegerVariable(integer_vars_, entry.first)) continue;
+    real_t value = ToReal(entry.second);
+    auto locks = GetLocks(locks_, entry.first);
+    if (locks.first == 0) {
+      value = std::floor(value);
+    } else if (locks.second == 0) {
+      value = std::ceil(value);
+    } else {
+      value = std::round(value);
+    }
+    entry.second = Num(value);
+  }
+  return ToPrimalSolution(rounded, primal);
+}
+
+/* A dive goes down a single path of the tree: it bounds a variable, resolves
+ * the relaxation from the basis of the previous one, and tries the other
+ * direction once if the relaxation is infeasible. It gives up when the bound
+ * of the relaxation is not better than the incumbent.
+ */
+bool ILPModel::Dive(BranchAndBoundNode node, std::map<Variable, Num> solution,
+                    bool coefficient, real_t incumbent,
+                    BranchAndBoundStatistics& statistics,
+                    PrimalSolution& primal) {
+  real_t sign = model_.opt_obj.opt_type == OptimizationObject::MIN ? -1 : 1;
+  for (auto depth = 0; depth < kMaxDiveDepth; depth++) {
+    if (ToPrimalSolution(solution, primal) or
+        SimpleRounding(solution, primal))
+      return primal.bound > incumbent;
+
+    // The least fractional variable, or the one with the fewest locks in its
+    // direction (the least fractional on ties).
+    Variable dive_var;
+    real_t dive_value = 0, best_score = std::numeric_limits<real_t>::infinity();
+    bool dive_up = false;
+    for (auto entry : solution) {
+      if (!IsIntegerVariable(integer_vars_, entry.first)) continue;
+      real_t value = ToReal(entry.second);
+      if (IsIntegral(value)) continue;
+      real_t fraction = value - std::floor(value);
+      bool up = fraction >= 0.5;
+      real_t score = std::min(fraction, 1 - fraction);
+      if (coefficient) {
+        auto locks = GetLocks(locks_, entry.first);
+        if (locks.first != locks.second) up = locks.second < locks.first;
+        score = std::min(locks.first, locks.second) +
+                (up ? 1 - fraction : fraction);
+      }
+      if (score < best_score) {
+        best_score = score;
+        dive_var = entry.first;
+        dive_value = value;
+        dive_up = up;
+      }
+    }
+    if (dive_var.IsUndefined()) return false;
+
+    bool feasible = false;
+    for (auto up : {dive_up, !dive_up}) {
+      BranchAndBoundNode child = node;
+      AddBoundChange(child, dive_var, !up,
+                     up ? std::ceil(dive_value) : std::floor(dive_value));
+      Num optimum;
+      std::map<Variable, Num> child_solution;
+      BranchAndBoundStatistics lp_statistics;
+      auto result =
+          SolveNodeRelaxation(child, optimum, child_solution, lp_statistics);
+      statistics.heuristic_lps++;
+      statistics.lp_iterations += lp_statistics.lp_iterations;
+      if (result != SOLVED) continue;
+      if (sign * ToReal(optimum) <= incumbent) return false;
+      node = std::move(child);
+      solution = std::move(child_solution);
+      feasible = true;
+      break;
+    }
+    if (!feasible) return false;
+  }
+  return false;
+}
+
+bool ILPModel::RensRounding(const std::map<Variable, Num>& solution,
+                            PrimalSolution& primal) {
+  ILPModel sub(model_);
+  int integers = 0, fixed = 0;
+  for (auto entry : solution) {
+    if (!IsIntegerVariable(integer_vars_, entry.first)) continue;
+    real_t value = ToReal(entry.second);
+    integers++;
+    if (IsIntegral(value)) {
+      fixed++;
+      value = std::round(value);
+    }
+    sub.AddConstraint(BoundConstraint(entry.first, std::floor(value), true));
+    sub.AddConstraint(BoundConstraint(entry.first, std::ceil(value), false));
+  }
+  if (integers == 0 or fixed < kRensMinFixingRate * integers) return false;
+  return SolveSubproblem(sub, kRensNodeLimit, primal);
+}
+
+bool ILPModel::SolveSubproblem(ILPModel& sub, int node_limit,
+                               PrimalSolution& primal) {
+  // The sub problems only run the heuristics that do not solve sub problems.
+  sub.SetPrimalHeuristics(heuristics_ & (SIMPLE_ROUNDING | FRACTIONAL_DIVING |
+                                         COEFFICIENT_DIVING));
+  sub.SetNodeLimit(node_limit);
+  sub.SetTimeLimit(kSubproblemTimeLimit);
+  if (sub.BranchAndBoundSolve(cutoff_) != SOLVED) return false;
+  std::map<Variable, Num> sub_solution;
+  for (auto entry : sub.GetSolution()) {
+    auto var = entry.first;
+    var.To(FLOAT);
+    sub_solution[var] = entry.second;
+  }
+  return ToPrimalSolution(sub_solution, primal);
+}
+
+// Adds to `problem` the rows d_j >= x_j - t_j, d_j >= t_j - x_j and d_j >= 0
+// of the integer variables x_j of `target`, and returns sum_j d_j.
+Expression AddDistanceRows(ILPModel& problem,
+                           const std::map<Variable, real_t>& target) {
+  Expression distance(kFloatZero);
+  for (auto entry : target) {
+    auto var = entry.first;
+    var.To(INTEGER);
+    Variable d("distance_" + entry.first.ToString());
+    distance.SetCoeffOf(d, Num(1.0));
+    for (auto up : {false, true}) {
+      Constraint constraint(FLOAT);
+      constraint.SetEquationType(up ? Constraint::Type::GE
+                                    : Constraint::Type::LE);
+      constraint.SetCompare(Num(entry.second));
+      constraint.expression.SetCoeffOf(var, Num(1.0));
+      constraint.expression.SetCoeffOf(d, Num(up ? 1.0 : -1.0));
+      problem.AddConstraint(constraint);
+    }
+    Constraint non_negative(FLOAT);
+    non_negative.SetEquationType(Constraint::Type::GE);
+    non_negative.SetCompare(Num(0.0));
+    non_negative.expression.SetCoeffOf(d, Num(1.0));
+    problem.AddConstraint(non_negative);
+  }
+  return distance;
+}
+
+bool ILPModel::Rins(const std::map<Variable, Num>& incumbent,
+                    const std::map<Variable, Num>& relaxation,
+                    PrimalSolution& primal) {
+  ILPModel sub(model_);
+  int integers = 0, fixed = 0;
+  for (auto entry : incumbent) {
+    if (!IsIntegerVariable(integer_vars_, entry.first)) continue;
+    integers++;
+    auto iter = relaxation.find(entry.first);
+    real_t value = ToReal(entry.second);
+    real_t lp_value = iter == relaxation.end() ? 0 : ToReal(iter->second);
+    if (std::abs(lp_value - value) >= kFeasibilityTolerance) continue;
+    fixed++;
+    sub.AddConstraint(BoundConstraint(entry.first, std::round(value), true));
+    sub.AddConstraint(BoundConstraint(entry.first, std::round(value), false));
+  }
+  if (integers == 0 or fixed < kRinsMinFixingRate * integers or
+      fixed == integers)
+    return false;
+  return SolveSubproblem(sub, kSubproblemNodeLimit, primal);
+}
+
+bool ILPModel::LocalBranching(const std::map<Variable, Num>& incumbent,
+                              PrimalSolution& primal) {
+  ILPModel sub(model_);
+  std::map<Variable, real_t> target;
+  for (auto entry : incumbent)
+    if (IsIntegerVariable(integer_vars_, entry.first))
+      target[entry.first] = std::round(ToReal(entry.second));
+  if (target.empty()) return false;
+  Constraint ball(FLOAT);
+  ball.SetEquationType(Constraint::Type::LE);
+  ball.SetCompare(Num(real_t(kLocalBranchingRadius)));
+  ball.expression = AddDistanceRows(sub, target);
+  sub.AddConstraint(ball);
+  return SolveSubproblem(sub, kSubproblemNodeLimit, primal);
+}
+
+bool ILPModel::StartImprovementHeuristics(
+    BackgroundHeuristics& background, const std::map<Variable, Num>& incumbent,
+    const std::map<Variable, Num>& relaxation) {
+  if (!(heuristics_ & (RINS | LOCAL_BRANCHING))) return false;
+  // The run reads the model and the locks, which do not change during the
+  // search, and copies the solutions.
+  return background.Start([this, incumbent, relaxation]() {
+    std::vector<PrimalSolution> solutions;
+    PrimalSolution primal;
+    if ((heuristics_ & RINS) and Rins(incumbent, relaxation, primal))
+      solutions.push_back(primal);
+    // Local branching around the best solution.
+    auto center = solutions.empty() ? incumbent : solutions.back().solution;
+    if ((heuristics_ & LOCAL_BRANCHING) and LocalBranching(center, primal))
+      solutions.push_back(primal);
+    return solutions;
+  });
+}
+
+bool BackgroundHeuristics::Start(
+    std::function<std::vector<PrimalSolution>()> run) {
+  // Several threads of the search may start runs: the thread is only joined
+  // and assigned under the lock.
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool running = false;
+  if (!running_.compare_exchange_strong(running, true)) return false;
+  // The previous run is over, and no longer takes the lock.
+  if (thread_.joinable()) thread_.join();
+  started_ = true;
+  thread_ = std::thread([this, run]() {
+    auto solutions = run();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      solutions_.insert(solutions_.end(), solutions.begin(), solutions.end());
+    }
+    running_ = false;
+  });
+  return true;
+}
+
+std::vector<PrimalSolution> BackgroundHeuristics::Take() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<PrimalSolution> solutions;
+  solutions.swap(solutions_);
+  return solutions;
+}
+
+void BackgroundHeuristics::Stop() {
+  if (!started_) return;
+  cutoff_->store(std::numeric_limits<real_t>::infinity());
+  if (thread_.joinable()) thread_.join();
+}
+
+/* The pump rounds the relaxation to a point t, and solves
+ *    min sum_j d_j  st  the rows and bounds of the node,
+ *                       d_j >= x_j - t_j, d_j >= t_j - x_j
+ * over the integer variables x_j, until the rounded point is feasible. The
+ * LPs only differ in t, each starts from the basis of the previous one. If
+ * the rounding gives t again, the variables the farthest from t are moved by
+ * one toward the LP solution.
+ */
+bool ILPModel::FeasibilityPump(const BranchAndBoundNode& node,
+                               std::map<Variable, Num> solution,
+                               BranchAndBoundStatistics& statistics,
+                               PrimalSolution& primal) {
+  std::map<Variable, real_t> target;
+  auto round = [&]() {
+    for (auto entry : solution)
+      if (IsIntegerVariable(integer_vars_, entry.first))
+        target[entry.first] = std::round(ToReal(entry.second));
+  };
+  round();
+  BranchAndBoundNode pump = node;
+  for (auto iter = 0; iter < kMaxPumpIterations; iter++) {
+    auto rounded = solution;
+    for (auto entry : target) rounded[entry.first] = Num(entry.second);
+    if (ToPrimalSolution(rounded, primal)) return true;
+
+    ILPModel problem(root_relaxation_);
+    OptimizationObject distance(FLOAT);
+    distance.opt_type = OptimizationObject::MIN;
+    distance.expression = AddDistanceRows(problem, target);
+    problem.SetOptimizationObject(distance);
+    auto relaxation = problem.ToRelaxedModel();
+
+    Num optimum;
+    BranchAndBoundStatistics lp_statistics;
+    auto result = SolveNodeRelaxation(pump, optimum, solution, lp_statistics,
+                                      &relaxation);
+    statistics.heuristic_lps++;
+    statistics.lp_iterations += lp_statistics.lp_iterations;
+    if (result != SOLVED) return false;
+
+    auto previous = target;
+    round();
+    if (target != previous) continue;
+    std::vector<std::pair<real_t, Variable>> distances;
+    for (auto entry : target) {
+      real_t gap = ToReal(solution[entry.first]) - entry.second;
+      if (std::abs(gap) > kFeasibilityTolerance)
+        distances.push_back({-std::abs(gap), entry.first});
+    }
+    if (distances.empty()) return false;
+    std::sort(distances.begin(), distances.end());
+    if (distances.size() > kPumpFlips) distances.resize(kPumpFlips);
+    for (auto entry : distances) {
+      auto var = entry.second;
+      target[var] += ToReal(solution[var]) > target[var] ? 1 : -1;
+    }
+  }
+  return false;
+}
+
+void ILPModel::RunPrimalHeuristics(BranchAndBoundNode& node,
+                                   NodeResult& result, real_t incumbent,
+                                   BranchAndBoundStatistics& statistics) {
+  real_t best = incumbent;
+  PrimalSolution primal;
+  auto keep = [&]() {
+    if (primal.bound <= best) return;
+    best = primal.bound;
+    result.primal_solutions.push_back(primal);
+    statistics.heuristic_solutions++;
+  };
+  bool root = node.depth == 0;
+  if ((heuristics_ & SIMPLE_ROUNDING) and
+      SimpleRounding(result.solution, primal))
+    keep();
+  if (root or statistics.nodes % heuristic_frequency_ == 0) {
+    if ((heuristics_ & FRACTIONAL_DIVING) and
+        Dive(node, result.solution, false, best, statistics, primal))
+      keep();
+    if ((heuristics_ & COEFFICIENT_DIVING) and
+        Dive(node, result.solution, true, best, statistics, primal))
+      keep();
+  }
+  if (!root) return;
+  if ((heuristics_ & RENS) and RensRounding(result.solution, primal)) keep();
+  // The pump looks for a first solution, regardless of the objective.
+  if ((heuristics_ & FEASIBILITY_PUMP) and result.primal_solutions.empty() and
+      incumbent == -std::numeric_limits<real_t>::infinity() and
+      FeasibilityPump(node, result.solution, statistics, primal))
+    keep();
+}
@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ilp.h"
+
+// A row is violated, and a domain is empty, beyond this tolerance.
+const real_t kPropagationTolerance = 1e-6;
+// The bound of a continuous variable is only tightened by this fraction of
+// its magnitude (at least 1) or more, so that the propagation does not creep.
+const real_t kMinBoundImprovement = 1e-3;
+// The propagation of a node visits at most this many rows per row of the
+// model.
+const int kMaxRowVisits = 10;
+
+DomainPropagator::DomainPropagator(const Model& relaxation,
+                                   const std::set<Variable>& integer_vars) {
+  const real_t kInfinity = std::numeric_limits<real_t>::infinity();
+  auto rows = std::make_shared<Rows>();
+  auto index = [&](Variable var) {
+    auto iter = rows->indices.find(var);
+    if (iter != rows->indices.end()) return iter->second;
+    int i = rows->vars.size();
+    rows->indices[var] = i;
+    rows->vars.push_back(var);
+    var.To(INTEGER);
+    rows->integer.push_back(integer_vars.count(var) > 0);
+    rows->columns.emplace_back();
+    lower_.push_back(-kInfinity);
+    upper_.push_back(kInfinity);
+    return i;
+  };
+  // The rows on a single variable, applied once the domains exist.
+  std::vector<std::tuple<int, bool, real_t>> bounds;
+  for (auto& constraint : relaxation.constraints) {
+    Row row;
+    for (auto entry : constraint.expression.variable_coeff) {
+      if (entry.second.IsZero()) continue;
+      row.entries.push_back({index(entry.first), ToReal(entry.second)});
+    }
+    real_t compare = ToReal(constraint.compare) -
+                     ToReal(constraint.expression.constant);
+    row.lhs = constraint.equation_type == Constraint::Type::LE ? -kInfinity
+                                                               : compare;
+    row.rhs = constraint.equation_type == Constraint::Type::GE ? kInfinity
+                                                               : compare;
+    if (row.entries.size() == 1) {
+      auto var = row.entries[0].first;
+      real_t coeff = row.entries[0].second;
+      // lhs <= coeff * x <= rhs.
+      real_t low = (coeff > 0 ? row.lhs : row.rhs) / coeff;
+      real_t high = (coeff > 0 ? row.rhs : row.lhs) / coeff;
+      if (low > -kInfinity) bounds.push_back({var, false, low});
+      if (high < kInfinity) bounds.push_back({var, true, high});
+      continue;
+    }
+    if (row.entries.empty()) continue;
+    for (auto entry : row.entries)
+      rows->columns[entry.first].push_back({int(rows->rows.size()),
+                                            entry.second});
+    rows->rows.push_back(row);
+  }
+  rows_ = rows;
+  min_activity_.resize(rows_->rows.size());
+  max_activity_.resize(rows_->rows.size());
+  queued_.assign(rows_->rows.size(), false);
+  for (auto i = 0; i < rows_->rows.size(); i++) {
+    for (auto entry : rows_->rows[i].entries) {
+      AddTerm(min_activity_[i], Term(entry.first, entry.second, false), 1);
+      AddTerm(max_activity_[i], Term(entry.first, entry.second, true), 1);
+    }
+    queued_[i] = true;
+    queue_.push_back(i);
+  }
+  for (auto& bound : bounds)
+    Tighten(std::get<0>(bound), std::get<1>(bound), std::get<2>(bound));
+  tightened_.clear();
+}
+
+// The term a * x at the bound x = `bound`.
+real_t BoundTerm(real_t coeff, real_t bound) {
+  if (std::isinf(bound)) return coeff > 0 ? bound : -bound;
+  return coeff * bound;
+}
+
+real_t DomainPropagator::Term(int var, real_t coeff, bool max) {
+  // The maximal activity takes the upper bound of a positive coefficient.
+  bool upper = (coeff > 0) == max;
+  return BoundTerm(coeff, upper ? upper_[var] : lower_[var]);
+}
+
+void DomainPropagator::AddTerm(Activity& activity, real_t term, real_t sign) {
+  if (std::isinf(term)) {
+    activity.infinite += sign;
+  } else {
+    activity.finite += sign * term;
+  }
+}
+
+bool DomainPropagator::Tighten(Variable var, bool upper, real_t value) {
+  auto iter = rows_->indices.find(var);
+  // A variable of no row is only bounded by the LP.
+  if (iter == rows_->indices.end()) return true;
+  return Tighten(iter->second, upper, value);
+}
+
+bool DomainPropagator::Tighten(int var, bool upper, real_t value) {
+  if (rows_->integer[var]) {
+    value = upper ? std::floor(value + kPropagationTolerance)
+                  : std::ceil(value - kPropagationTolerance);
+  }
+  real_t& bound = upper ? upper_[var] : lower_[var];
+  if (upper ? value >= bound : value <= bound) return true;
+  if (!rows_->integer[var] and !std::isinf(bound) and
+      std::abs(value - bound) <
+          kMinBoundImprovement * std::max(real_t(1), std::abs(bound)))
+    return true;
+
+  for (auto entry : rows_->columns[var]) {
+    int row = entry.first;
+    real_t coeff = entry.second;
+    // The bound is a term of the maximal activity if it is the upper bound of
+    // a positive coefficient or the lower bound of a negative one.
+    bool max = upper == (coeff > 0);
+    auto& activity = max ? max_activity_[row] : min_activity_[row];
+    AddTerm(activity, BoundTerm(coeff, bound), -1);
+    AddTerm(activity, BoundTerm(coeff, value), 1);
+    if (!queued_[row]) {
+      queued_[row] = true;
+      queue_.push_back(row);
+    }
+  }
+  bound = value;
+  tightened_.insert({var, upper});
+  return lower_[var] <= upper_[var] + kPropagationTolerance;
+}
+
+bool DomainPropagator::PropagateRow(int i) {
+  auto& row = rows_->rows[i];
+  auto& min_activity = min_activity_[i];
+  auto& max_activity = max_activity_[i];
+  auto tolerance = [](real_t value) {
+    return kPropagationTolerance * std::max(real_t(1), std::abs(value));
+  };
+  if (min_activity.infinite == 0 and
+      min_activity.finite > row.rhs + tolerance(row.rhs))
+    return false;
+  if (max_activity.infinite == 0 and
+      max_activity.finite < row.lhs - tolerance(row.lhs))
+    return false;
+
+  for (auto entry : row.entries) {
+    int var = entry.first;
+    real_t coeff = entry.second;
+    // sum_{k != j} a_k x_k >= the minimal activity of the others, so
+    // a_j x_j <= rhs - that activity.
+    real_t term = Term(var, coeff, false);
+    if (!std::isinf(row.rhs) and
+        min_activity.infinite == (std::isinf(term) ? 1 : 0)) {
+      real_t others = min_activity.finite - (std::isinf(term) ? 0 : term);
+      if (!Tighten(var, coeff > 0, (row.rhs - others) / coeff)) return false;
+    }
+    term = Term(var, coeff, true);
+    if (!std::isinf(row.lhs) and
+        max_activity.infinite == (std::isinf(term) ? 1 : 0)) {
+      real_t others = max_activity.finite - (std::isinf(term) ? 0 : term);
+      if (!Tighten(var, coeff < 0, (row.lhs - others) / coeff)) return false;
+    }
+  }
+  return true;
+}
+
+bool DomainPropagator::Propagate() {
+  int visits = kMaxRowVisits * rows_->rows.size();
+  for (auto var = 0; var < lower_.size(); var++)
+    if (lower_[var] > upper_[var] + kPropagationTolerance) return false;
+  while (!queue_.empty()) {
+    int row = queue_.front();
+    queue_.pop_front();
+    queued_[row] = false;
+    if (visits-- <= 0) continue;
+    if (!PropagateRow(row)) return false;
+  }
+  return true;
+}
+
+std::vector<std::tuple<Variable, bool, real_t>>
+DomainPropagator::TakeTightenedBounds() {
+  std::vector<std::tuple<Variable, bool, real_t>> bounds;
+  for (auto entry : tightened_) {
+    int var = entry.first;
+    if (!rows_->integer[var]) continue;
+    bool upper = entry.second;
+    bounds.push_back(
+        {rows_->vars[var], upper, upper ? upper_[var] : lower_[var]});
+  }
+  tightened_.clear();
+  return bounds;
+}
+
+real_t DomainPropagator::Lower(Variable var) {
+  auto iter = rows_->indices.find(var);
+  if (iter == rows_->indices.end())
+    return -std::numeric_limits<real_t>::infinity();
+  return lower_[iter->second];
+}
+
+real_t DomainPropagator::Upper(Variable var) {
+  auto iter = rows_->indices.find(var);
+  if (iter == rows_->indices.end())
+    return std::numeric_limits<real_t>::infinity();
+  return upper_[iter->second];
+}
+
+/* The bound of a node drops by at least cost * t when a non-basic variable
+ * moves by t away from its bound, so no solution better than the incumbent
+ * moves it by more than (bound - incumbent) / cost.
+ */
+void ILPModel::FixByReducedCosts(BranchAndBoundNode& node,
+                                 const std::vector<ReducedCost>& reduced_costs,
+                                 real_t bound, real_t incumbent,
+                                 BranchAndBoundStatistics& statistics) {
+  if (std::isinf(incumbent) or bound <= incumbent) return;
+  real_t gap = bound - incumbent;
+  for (auto& reduced_cost : reduced_costs) {
+    if (reduced_cost.cost < kPropagationTolerance) continue;
+    real_t distance =
+        std::floor(gap / reduced_cost.cost + kPropagationTolerance);
+    if (distance >= reduced_cost.range) continue;
+    real_t value = reduced_cost.at_upper ? reduced_cost.value - distance
+                                         : reduced_cost.value + distance;
+    AddBoundChange(node, reduced_cost.var, !reduced_cost.at_upper, value);
+    statistics.reduced_cost_fixings++;
+  }
+}
+
+bool ILPModel::PropagateNode(BranchAndBoundNode& node, real_t incumbent,
+                             BranchAndBoundStatistics& statistics) {
+  DomainPropagator domain = *propagator_;
+  for (auto& change : node.bound_changes) {
+    auto var = variables_->Get(change.var);
+    var.To(FLOAT);
+    if (!domain.Tighten(var, change.upper, change.value)) return false;
+  }
+  domain.TakeTightenedBounds();
+  if (!std::isinf(incumbent) and root_bound_ > incumbent) {
+    real_t gap = root_bound_ - incumbent;
+    for (auto& reduced_cost : root_reduced_costs_) {
+      if (reduced_cost.cost < kPropagationTolerance) continue;
+      real_t distance = gap / reduced_cost.cost;
+      real_t value = reduced_cost.at_upper ? reduced_cost.value - distance
+                                           : reduced_cost.value + distance;
+      if (!domain.Tighten(reduced_cost.var, !reduced_cost.at_upper, value))
+        return false;
+    }
+  }
+  if (!domain.Propagate()) return false;
+  for (auto& bound : domain.TakeTightenedBounds()) {
+    AddBoundChange(node, std::get<0>(bound), std::get<1>(bound),
+                   std::get<2>(bound));
+    statistics.propagated_bounds++;
+  }
+  return true;
+}
@@ -65,4 +65,465 @@ TEST(ILPModel, BranchAndBoundSolve) {
     EXPECT_LE(entry.second - actual_sol[entry.first], 1e-6f);
     EXPECT_GE(entry.second - actual_sol[entry.first], -1e-6f);
   }
-}
\ No newline at end of file
+}
+
+TEST(ILPModel, BranchAndBoundNodeSelection) {
+  Parser parser;
+  Variable a("a", INTEGER), b("b", INTEGER), c("c", INTEGER), d("d", INTEGER);
+  for (auto node_selection :
+       {ILPModel::BEST_BOUND, ILPModel::DEPTH_FIRST, ILPModel::BEST_ESTIMATE}) {
+    ILPModel ilp_model = parser.Parse(
+        "max 8 * a + 11 * b + 6 * c + 4 * d\n"
+        "st\n"
+        "5 * a + 7 * b + 4 * c + 3 * d <= 14\n"
+        "a <= 1\n"
+        "b <= 1\n"
+        "c <= 1\n"
+        "d <= 1\n"
+        "a >= 0\n"
+        "b >= 0\n"
+        "c >= 0\n"
+        "d >= 0\n"
+        "a, b, c, d");
+    ilp_model.SetNodeSelection(node_selection);
+
+    EXPECT_EQ(ilp_model.BranchAndBoundSolve(), SOLVED);
+    EXPECT_EQ(ilp_model.GetOptimum(), Num(21.0f));
+    auto solution = ilp_model.GetSolution();
+    EXPECT_NEAR(solution[a].float_value, 0, 1e-6);
+    for (auto var : {b, c, d}) EXPECT_NEAR(solution[var].float_value, 1, 1e-6);
+    EXPECT_GE(ilp_model.GetBranchAndBoundStatistics().nodes, 1);
+  }
+}
+
+TEST(ILPModel, BranchAndBoundMinimize) {
+  Parser parser;
+  ILPModel ilp_model = parser.Parse(
+      "min 3 * x + 2 * y\n"
+      "st\n"
+      "x + y >= 3.5\n"
+      "y <= 2.5\n"
+      "x >= 0\n"
+      "y >= 0\n"
+      "x, y");
+  Variable x("x", INTEGER), y("y", INTEGER);
+
+  EXPECT_EQ(ilp_model.BranchAndBoundSolve(), SOLVED);
+  EXPECT_EQ(ilp_model.GetOptimum(), Num(10.0f));
+  auto solution = ilp_model.GetSolution();
+  EXPECT_NEAR(solution[x].float_value, 2, 1e-6);
+  EXPECT_NEAR(solution[y].float_value, 2, 1e-6);
+}
+
+TEST(ILPModel, BranchAndBoundWarmStart) {
+  Parser parser;
+  std::ifstream file("tests/test22.txt");
+  Model model = parser.Parse(file);
+  ILPModel warm(model), cold(model);
+  cold.SetEnableWarmStart(false);
+
+  EXPECT_EQ(warm.BranchAndBoundSolve(), SOLVED);
+  EXPECT_EQ(cold.BranchAndBoundSolve(), SOLVED);
+  EXPECT_NEAR(warm.GetOptimum().float_value, 100, 1e-6);
+  EXPECT_NEAR(cold.GetOptimum().float_value, 100, 1e-6);
+  auto& warm_statistics = warm.GetBranchAndBoundStatistics();
+  auto& cold_statistics = cold.GetBranchAndBoundStatistics();
+  EXPECT_GT(warm_statistics.nodes, 1);
+  // All the nodes but the root start from the basis of their parent.
+  EXPECT_EQ(warm_statistics.warm_started_nodes, warm_statistics.nodes - 1);
+  EXPECT_EQ(cold_statistics.warm_started_nodes, 0);
+  EXPECT_LT(warm_statistics.lp_iterations, cold_statistics.lp_iterations);
+}
+
+TEST(ILPModel, BranchAndBoundBranchingRule) {
+  Parser parser;
+  std::ifstream file("tests/test23.txt");
+  Model model = parser.Parse(file);
+
+  std::vector<BranchAndBoundStatistics> statistics;
+  for (auto rule : {ILPModel::FIRST_FRACTIONAL, ILPModel::PSEUDOCOST,
+                    ILPModel::RELIABILITY}) {
+    ILPModel ilp_model(model);
+    ilp_model.SetNodeSelection(ILPModel::BEST_BOUND);
+    ilp_model.SetBranchingRule(rule);
+    EXPECT_EQ(ilp_model.BranchAndBoundSolve(), SOLVED);
+    EXPECT_NEAR(ilp_model.GetOptimum().float_value, 110, 1e-6);
+    statistics.push_back(ilp_model.GetBranchAndBoundStatistics());
+  }
+  // The pseudocosts pick the variables that move the bound the most.
+  EXPECT_LT(statistics[1].nodes, statistics[0].nodes);
+  EXPECT_LT(statistics[2].nodes, statistics[0].nodes);
+  EXPECT_EQ(statistics[1].strong_branching_lps, 0);
+  EXPECT_GT(statistics[2].strong_branching_lps, 0);
+}
+
+TEST(ILPModel, ParallelBranchAndBound) {
+  Parser parser;
+  std::ifstream file("tests/test22.txt");
+  Model model = parser.Parse(file);
+
+  ILPModel parallel(model);
+  parallel.SetNumThreads(4);
+  EXPECT_EQ(parallel.BranchAndBoundSolve(), SOLVED);
+  EXPECT_NEAR(parallel.GetOptimum().float_value, 100, 1e-6);
+
+  // The deterministic runs explore the same tree.
+  std::vector<BranchAndBoundStatistics> statistics;
+  std::vector<std::map<Variable, Num>> solutions;
+  for (auto run = 0; run < 2; run++) {
+    ILPModel deterministic(model);
+    deterministic.SetNumThreads(4);
+    deterministic.SetDeterministic(true);
+    EXPECT_EQ(deterministic.BranchAndBoundSolve(), SOLVED);
+    EXPECT_NEAR(deterministic.GetOptimum().float_value, 100, 1e-6);
+    statistics.push_back(deterministic.GetBranchAndBoundStatistics());
+    solutions.push_back(deterministic.GetSolution());
+  }
+  EXPECT_EQ(statistics[0].nodes, statistics[1].nodes);
+  EXPECT_EQ(statistics[0].lp_iterations, statistics[1].lp_iterations);
+  EXPECT_EQ(statistics[0].steals, statistics[1].steals);
+  EXPECT_EQ(solutions[0], solutions[1]);
+}
+
+TEST(ILPModel, BranchAndBoundPrimalHeuristics) {
+  Parser parser;
+  std::ifstream file("tests/test23.txt");
+  Model model = parser.Parse(file);
+
+  // The root alone finds no incumbent without the heuristics.
+  ILPModel none(model);
+  none.SetPrimalHeuristics(0);
+  none.SetNodeLimit(1);
+  EXPECT_EQ(none.BranchAndBoundSolve(), NOSOLUTION);
+  EXPECT_TRUE(none.GetBranchAndBoundStatistics().limit_reached);
+
+  for (auto heuristics :
+       {int(ILPModel::SIMPLE_ROUNDING), int(ILPModel::FRACTIONAL_DIVING),
+        int(ILPModel::COEFFICIENT_DIVING), int(ILPModel::ALL_HEURISTICS)}) {
+    ILPModel ilp_model(model);
+    ilp_model.SetPrimalHeuristics(heuristics);
+    ilp_model.SetNodeLimit(1);
+    EXPECT_EQ(ilp_model.BranchAndBoundSolve(), SOLVED);
+    EXPECT_LE(ilp_model.GetOptimum().float_value, 110 + 1e-6);
+    EXPECT_GT(ilp_model.GetBranchAndBoundStatistics().heuristic_solutions, 0);
+  }
+
+  ILPModel all(model);
+  EXPECT_EQ(all.BranchAndBoundSolve(), SOLVED);
+  EXPECT_NEAR(all.GetOptimum().float_value, 110, 1e-6);
+  EXPECT_FALSE(all.GetBranchAndBoundStatistics().limit_reached);
+}
+
+TEST(ILPModel, BranchAndBoundCompactNodes) {
+  Parser parser;
+  std::ifstream file("tests/test23.txt");
+  ILPModel ilp_model = parser.Parse(file);
+  ilp_model.SetNodeSelection(ILPModel::BEST_BOUND);
+  ilp_model.SetPrimalHeuristics(0);
+
+  EXPECT_EQ(ilp_model.BranchAndBoundSolve(), SOLVED);
+  EXPECT_NEAR(ilp_model.GetOptimum().float_value, 110, 1e-6);
+  auto& statistics = ilp_model.GetBranchAndBoundStatistics();
+  // A node stores a few bounds and a bitset of its basis, whatever the size of
+  // the rows of the model.
+  EXPECT_GT(statistics.max_open_node_bytes, 0);
+  EXPECT_LE(statistics.max_open_node_bytes,
+            statistics.max_open_nodes * (sizeof(BranchAndBoundNode) + 512));
+  // The bounds add no rows, the parent's basis fits every node.
+  EXPECT_EQ(statistics.warm_started_nodes, statistics.nodes - 1);
+}
+
+TEST(ILPModel, BranchAndBoundImprovementHeuristics) {
+  Parser parser;
+  std::ifstream file("tests/test23.txt");
+  Model model = parser.Parse(file);
+
+  // The rounding of the root gives the first incumbent, RINS and local
+  // branching start from it.
+  ILPModel ilp_model(model);
+  ilp_model.SetPrimalHeuristics(ILPModel::SIMPLE_ROUNDING | ILPModel::RINS |
+                                ILPModel::LOCAL_BRANCHING);
+  EXPECT_EQ(ilp_model.BranchAndBoundSolve(), SOLVED);
+  EXPECT_NEAR(ilp_model.GetOptimum().float_value, 110, 1e-6);
+  EXPECT_GT(ilp_model.GetBranchAndBoundStatistics().improvement_runs, 0);
+
+  ILPModel parallel(model);
+  parallel.SetNumThreads(4);
+  EXPECT_EQ(parallel.BranchAndBoundSolve(), SOLVED);
+  EXPECT_NEAR(parallel.GetOptimum().float_value, 110, 1e-6);
+
+  ILPModel limited(model);
+  limited.SetTimeLimit(1e-9);
+  limited.BranchAndBoundSolve();
+  EXPECT_TRUE(limited.GetBranchAndBoundStatistics().limit_reached);
+
+  // The limits apply to the multi-threaded searches too.
+  for (auto deterministic : {false, true}) {
+    ILPModel timed(model);
+    timed.SetNumThreads(4);
+    timed.SetDeterministic(deterministic);
+    timed.SetTimeLimit(1e-9);
+    timed.BranchAndBoundSolve();
+    EXPECT_TRUE(timed.GetBranchAndBoundStatistics().limit_reached);
+
+    ILPModel counted(model);
+    counted.SetNumThreads(4);
+    counted.SetDeterministic(deterministic);
+    counted.SetPrimalHeuristics(0);
+    counted.SetNodeLimit(1);
+    counted.BranchAndBoundSolve();
+    auto& statistics = counted.GetBranchAndBoundStatistics();
+    EXPECT_TRUE(statistics.limit_reached);
+    EXPECT_LE(statistics.nodes, 4);
+  }
+}
+
+TEST(ILPModel, BranchAndBoundPropagation) {
+  Parser parser;
+  std::ifstream file("tests/test23.txt");
+  Model model = parser.Parse(file);
+
+  ILPModel propagated(model);
+  EXPECT_EQ(propagated.BranchAndBoundSolve(), SOLVED);
+  EXPECT_NEAR(propagated.GetOptimum().float_value, 110, 1e-6);
+  // The third row alone bounds x2 <= 2 and x6 <= 1, once at the root.
+  EXPECT_GT(propagated.GetBranchAndBoundStatistics().propagated_bounds, 0);
+
+  ILPModel plain(model);
+  plain.SetEnablePropagation(false);
+  EXPECT_EQ(plain.BranchAndBoundSolve(), SOLVED);
+  EXPECT_NEAR(plain.GetOptimum().float_value, 110, 1e-6);
+  auto& statistics = plain.GetBranchAndBoundStatistics();
+  EXPECT_EQ(statistics.propagated_bounds, 0);
+  EXPECT_EQ(statistics.reduced_cost_fixings, 0);
+}
+
+TEST(ILPModel, CuttingPlaneSolve) {
+  Parser parser;
+  std::ifstream file("tests/test22.txt");
+  ILPModel ilp_model = parser.Parse(file);
+
+  EXPECT_EQ(ilp_model.CuttingPlaneSolve(), SOLVED);
+  EXPECT_NEAR(ilp_model.GetOptimum().float_value, 100, 1e-6);
+  auto& statistics = ilp_model.GetCuttingPlaneStatistics();
+  EXPECT_GT(statistics.rounds, 0);
+  EXPECT_GE(statistics.cuts_added, statistics.rounds);
+  // The cuts tighten the relaxation without cutting off the optimum.
+  EXPECT_LT(statistics.final_bound, statistics.initial_bound);
+  EXPECT_GE(statistics.final_bound, 100 - 1e-6);
+}
+
+TEST(ILPModel, CuttingPlaneMinimize) {
+  Parser parser;
+  ILPModel ilp_model = parser.Parse(
+      "min 3 * x + 2 * y\n"
+      "st\n"
+      "x + y >= 3.5\n"
+      "y <= 2.5\n"
+      "x >= 0\n"
+      "y >= 0\n"
+      "x, y");
+  Variable x("x", INTEGER), y("y", INTEGER);
+
+  EXPECT_EQ(ilp_model.CuttingPlaneSolve(), SOLVED);
+  EXPECT_NEAR(ilp_model.GetOptimum().float_value, 10, 1e-6);
+  auto solution = ilp_model.GetSolution();
+  EXPECT_NEAR(solution[x].float_value, 2, 1e-6);
+  EXPECT_NEAR(solution[y].float_value, 2, 1e-6);
+}
+
+TEST(ILPModel, BranchAndPriceSolve) {
+  // Partitions 3 items: a single item costs 1.5, a pair 1 and the three 3.
+  // The relaxation takes each pair by 1/2 (1.5), the best partition is a pair
+  // and a single item (2.5).
+  ILPModel master;
+  OptimizationObject objective(INTEGER);
+  objective.SetOptType(OptimizationObject::MIN);
+  master.SetOptimizationObject(objective);
+  for (auto i = 0; i < 3; i++) {
+    Constraint row(INTEGER);
+    row.SetEquationType(Constraint::Type::EQ);
+    row.SetCompare(Num(1));
+    master.AddConstraint(row);
+  }
+  const real_t kCosts[] = {0, 1.5, 1, 3};
+  auto pricer = [&](const std::vector<real_t>& duals,
+                    const std::vector<RowPairBranch>& branches) {
+    std::vector<Column> best;
+    real_t best_reduced_cost = -1e-9;
+    for (auto mask = 1; mask < 8; mask++) {
+      Column column;
+      for (auto i = 0; i < 3; i++)
+        if (mask >> i & 1) column.coefficients[i] = 1;
+      column.cost = kCosts[column.coefficients.size()];
+      if (!IsCompatible(column, branches)) continue;
+      real_t reduced_cost = column.cost;
+      for (auto entry : column.coefficients) reduced_cost -= duals[entry.first];
+      if (reduced_cost >= best_reduced_cost) continue;
+      best_reduced_cost = reduced_cost;
+      best = {column};
+    }
+    return best;
+  };
+
+  EXPECT_EQ(master.BranchAndPriceSolve(pricer), SOLVED);
+  EXPECT_NEAR(master.GetOptimum().float_value, 2.5, 1e-6);
+  auto& statistics = master.GetBranchAndPriceStatistics();
+  EXPECT_GT(statistics.columns_generated, 0);
+  EXPECT_GE(statistics.branchings, 1);
+  EXPECT_EQ(statistics.unconverged_nodes, 0);
+  // Each item is in exactly one column of the solution.
+  auto solution = master.GetSolution();
+  std::vector<real_t> covered(3, 0);
+  for (auto& column : master.GetColumns())
+    for (auto entry : column.coefficients)
+      covered[entry.first] += solution[column.var].float_value;
+  EXPECT_THAT(covered, testing::ElementsAre(1, 1, 1));
+}
+
+TEST(ILPModel, BranchAndPriceCovering) {
+  // Covers 3 items: a single item costs 1.2, a pair 1 and the three 3. The
+  // best cover is two overlapping pairs (2), which no Ryan-Foster child keeps.
+  ILPModel master;
+  OptimizationObject objective(INTEGER);
+  objective.SetOptType(OptimizationObject::MIN);
+  master.SetOptimizationObject(objective);
+  for (auto i = 0; i < 3; i++) {
+    Constraint row(INTEGER);
+    row.SetEquationType(Constraint::Type::GE);
+    row.SetCompare(Num(1));
+    master.AddConstraint(row);
+  }
+  const real_t kCosts[] = {0, 1.2, 1, 3};
+  auto pricer = [&](const std::vector<real_t>& duals,
+                    const std::vector<RowPairBranch>& branches) {
+    std::vector<Column> best;
+    real_t best_reduced_cost = -1e-9;
+    for (auto mask = 1; mask < 8; mask++) {
+      Column column;
+      for (auto i = 0; i < 3; i++)
+        if (mask >> i & 1) column.coefficients[i] = 1;
+      column.cost = kCosts[column.coefficients.size()];
+      real_t reduced_cost = column.cost;
+      for (auto entry : column.coefficients) reduced_cost -= duals[entry.first];
+      if (reduced_cost >= best_reduced_cost) continue;
+      best_reduced_cost = reduced_cost;
+      best = {column};
+    }
+    return best;
+  };
+
+  EXPECT_EQ(master.BranchAndPriceSolve(pricer), SOLVED);
+  EXPECT_NEAR(master.GetOptimum().float_value, 2, 1e-6);
+  auto& statistics = master.GetBranchAndPriceStatistics();
+  EXPECT_EQ(statistics.branchings, 0);
+  EXPECT_GE(statistics.restricted_master_solves, 1);
+}
+
+TEST(RowPairBranch, Compatibility) {
+  Column pair, single;
+  pair.coefficients = {{0, 1}, {1, 1}};
+  single.coefficients = {{0, 1}};
+  std::vector<RowPairBranch> together = {{0, 1, true}};
+  std::vector<RowPairBranch> apart = {{0, 1, false}};
+  EXPECT_TRUE(IsCompatible(pair, together));
+  EXPECT_FALSE(IsCompatible(single, together));
+  EXPECT_FALSE(IsCompatible(pair, apart));
+  EXPECT_TRUE(IsCompatible(single, apart));
+}
+
+TEST(CutPool, DeduplicationAndAging) {
+  Variable x("x"), y("y");
+  CutPool pool;
+  Cut cut;
+  cut.coeffs = {{x, 1}, {y, 2}};
+  cut.rhs = 3;
+  EXPECT_EQ(pool.Add(cut), 0);
+  // The same cut, scaled.
+  Cut scaled = cut;
+  scaled.coeffs = {{x, 2}, {y, 4}};
+  scaled.rhs = 6;
+  EXPECT_TRUE(pool.Contains(scaled));
+  EXPECT_EQ(pool.Add(scaled), -1);
+  EXPECT_NEAR(scaled.Parallelism(cut), 1, 1e-12);
+
+  pool.Get(0).active = true;
+  std::map<Variable, Num> slack = {{x, Num(2.0)}, {y, Num(2.0)}};
+  std::map<Variable, Num> tight = {{x, Num(1.0)}, {y, Num(1.0)}};
+  EXPECT_NEAR(pool.Get(0).Violation(slack), -3, 1e-12);
+  EXPECT_TRUE(pool.Age(slack, 1).empty());
+  // A tight cut gets young again.
+  EXPECT_TRUE(pool.Age(tight, 1).empty());
+  EXPECT_TRUE(pool.Age(slack, 1).empty());
+  EXPECT_THAT(pool.Age(slack, 1), testing::ElementsAre(0));
+  EXPECT_FALSE(pool.Get(0).active);
+}
+
+TEST(NodeQueue, Selection) {
+  auto pop_order = [](ILPModel::NodeSelection node_selection,
+                      bool has_incumbent) {
+    NodeQueue queue(node_selection);
+    // (bound, estimate, depth)
+    queue.Push({{}, 5, 1, 1});
+    queue.Push({{}, 3, 3, 3});
+    queue.Push({{}, 4, 2, 2});
+    std::vector<real_t> bounds;
+    while (!queue.Empty()) bounds.push_back(queue.Pop(has_incumbent).bound);
+    return bounds;
+  };
+  EXPECT_THAT(pop_order(ILPModel::BEST_BOUND, false),
+              testing::ElementsAre(5, 4, 3));
+  EXPECT_THAT(pop_order(ILPModel::DEPTH_FIRST, false),
+              testing::ElementsAre(3, 4, 5));
+  EXPECT_THAT(pop_order(ILPModel::DEPTH_FIRST, true),
+              testing::ElementsAre(5, 4, 3));
+  EXPECT_THAT(pop_order(ILPModel::BEST_ESTIMATE, false),
+              testing::ElementsAre(3, 4, 5));
+
+  NodeQueue queue(ILPModel::BEST_BOUND);
+  for (auto bound : {1, 2, 3}) queue.Push({{}, real_t(bound), 0});
+  EXPECT_EQ(queue.Bytes(), 3 * sizeof(BranchAndBoundNode));
+  queue.Prune(2);
+  EXPECT_EQ(queue.Size(), 1);
+  EXPECT_EQ(queue.Bound(), 3);
+  EXPECT_EQ(queue.Bytes(), sizeof(BranchAndBoundNode));
+  queue.Pop(false);
+  EXPECT_EQ(queue.Bytes(), 0);
+}
+
+TEST(DomainPropagator, Propagate) {
+  Parser parser;
+  Model model =
+      parser.Parse("max x + y\nst\nx + y <= 3.5\nx >= 2\ny >= 0\n");
+  Variable x("x"), y("y");
+  DomainPropagator propagator(
+      model, {Variable("x", INTEGER), Variable("y", INTEGER)});
+  EXPECT_EQ(propagator.Lower(x), 2);
+
+  DomainPropagator domain = propagator;
+  EXPECT_TRUE(domain.Propagate());
+  // y <= 3.5 - 2 and x <= 3.5, rounded down.
+  EXPECT_EQ(domain.Upper(y), 1);
+  EXPECT_EQ(domain.Upper(x), 3);
+  EXPECT_EQ(domain.TakeTightenedBounds().size(), 2);
+  EXPECT_FALSE(domain.Tighten(y, false, 2));
+
+  domain = propagator;
+  EXPECT_TRUE(domain.Tighten(x, false, 3));
+  EXPECT_TRUE(domain.Tighten(y, false, 1));
+  EXPECT_FALSE(domain.Propagate());
+}
+
+TEST(VariableDictionary, CompressBasis) {
+  VariableDictionary dictionary;
+  Variable x("x"), y("y"), base("base70");
+  EXPECT_EQ(dictionary.Index(x), 0);
+  EXPECT_EQ(dictionary.Index(y), 1);
+  EXPECT_EQ(dictionary.Index(x), 0);
+
+  std::set<Variable> basis = {y, base};
+  auto bits = dictionary.Compress(basis);
+  EXPECT_EQ(bits.size(), 1);
+  EXPECT_EQ(dictionary.Decompress(bits), basis);
+  EXPECT_EQ(dictionary.Get(2), base);
+}
@@ -128,6 +128,36 @@ void LPModel::ToStandardForm() {
   }
 }
 
+// Takes the rows x <= b (b >= 0) of the standard form as upper bounds.
+void LPModel::ExtractUpperBounds() {
+  assert(StandardFormSanityCheck(*this) == true);
+  std::vector<Constraint> constraints;
+  for (auto constraint : model_.constraints) {
+    Variable var;
+    Num coeff(FLOAT);
+    int nonzeros = 0;
+    for (auto entry : constraint.expression.variable_coeff) {
+      if (entry.second.IsZero()) continue;
+      var = entry.first;
+      coeff = entry.second;
+      nonzeros++;
+    }
+    if (nonzeros == 1 and coeff.IsPositive()) {
+      real_t bound = (constraint.compare.float_value -
+                      constraint.expression.constant.float_value) /
+                     coeff.float_value;
+      if (_IsNonNegative(bound)) {
+        if (upper_bounds_.find(var) == upper_bounds_.end() or
+            upper_bounds_[var] > bound)
+          upper_bounds_[var] = bound;
+        continue;
+      }
+    }
+    constraints.push_back(constraint);
+  }
+  model_.constraints = constraints;
+}
+
 /* Suppose the linear programming problem has been formulated in the standard
  * form, its slack form is in the format of: s = b_i - \sum_{j=1}^{n} a_{ij} xj,
  * where s is the slack variable.
@@ -165,6 +195,12 @@ void LPModel::ToTableau(TableauStorageFormat format) {
     entry.second = next_id++;
   }
   constant_index_ = next_id;
+  if (!upper_bounds_.empty()) {
+    tableau_upper_bound_.assign(constant_index_,
+                                std::numeric_limits<real_t>::infinity());
+    for (auto entry : upper_bounds_)
+      tableau_upper_bound_[variable_to_index_[entry.first]] = entry.second;
+  }
 
   tableau_ = new Tableau<real_t>(model_.constraints.size(),
                                  variable_to_index_.size() + 1, format);
@@ -384,62 +420,77 @@ LPModel::MatrixForm LPModel::ToMatrixForm() {
   };
 }
 
+LPModel::SparseMatrixForm LPModel::ToSparseMatrixForm() {
+  int variable_num = non_base_variables_.size();
+  int constraint_num = model_.constraints.size();
+  std::map<Variable, int> variable_index;
+  for (auto var : non_base_variables_) {
+    int col = variable_index.size();
+    variable_index[var] = col;
+  }
+  std::vector<Eigen::Triplet<real_t>> triplets;
+  Eigen::VectorXd b(constraint_num);
+  int row = 0;
+  for (auto con : model_.constraints) {
+    for (auto entry : con.expression.variable_coeff) {
+      if (entry.second.IsZero()) continue;
+      auto iter = variable_index.find(entry.first);
+      if (iter == variable_index.end()) continue;
+      triplets.push_back({row, iter->second, entry.second.float_value});
+    }
+    b(row) = -con.expression.constant.float_value;
+    row += 1;
+  }
+  Eigen::SparseMatrix<real_t> A(constraint_num, variable_num);
+  A.setFromTriplets(triplets.begin(), triplets.end());
+  Eigen::VectorXd c = Eigen::VectorXd::Zero(variable_num);
+  for (auto entry : model_.opt_obj.expression.variable_coeff) {
+    auto iter = variable_index.find(entry.first);
+    if (iter == variable_index.end()) continue;
+    c(iter->second) = entry.second.float_value;
+  }
+  return {
+      A,
+      c,
+      b,
+  };
+}
+
 LPModel::RevisedSimplexMatrixForm LPModel::ToRevisedSimplexMatrixForm() {
   if (model_.opt_obj.opt_type != OptimizationObject::MIN) {
     model_.opt_obj.SetOptType(OptimizationObject::MIN);
     model_.opt_obj.expression *= -1;
     opt_reverted_ = !opt_reverted_;
   }
-  int non_basis_variable_num = non_base_variables_.size();
-  int basis_variable_num = base_variables_.size();
-  int constraint_num = model_.constraints.size();
-  Eigen::MatrixXd basis_coefficient_mat(constraint_num, basis_variable_num);
-  Eigen::MatrixXd non_basis_coefficient_mat(constraint_num,
-                                            non_basis_variable_num);
-  Eigen::VectorXd basis_cost_vec(basis_variable_num);
-  Eigen::VectorXd non_basis_cost_vec(non_basis_variable_num);
-  Eigen::VectorXd bound_vec(constraint_num);
-  int col = 0;
+  RevisedSimplexMatrixForm form;
+  std::map<Variable, int> variable_index;
   for (auto var : non_base_variables_) {
-    int row = 0;
-    for (auto con : model_.constraints) {
-      non_basis_coefficient_mat(row, col) =
-          con.expression.GetCoeffOf(var).float_value;
-      row += 1;
-    }
-    col += 1;
+    variable_index[var] = form.variables.size();
+    form.non_basis.push_back(form.variables.size());
+    form.variables.push_back(var);
   }
-  col = 0;
   for (auto var : base_variables_) {
-    int row = 0;
-    for (auto con : model_.constraints) {
-      basis_coefficient_mat(row, col) =
-          con.expression.GetCoeffOf(var).float_value;
-      row += 1;
-    }
-    col += 1;
+    variable_index[var] = form.variables.size();
+    form.basis.push_back(form.variables.size());
+    form.variables.push_back(var);
   }
-  col = 0;
-  for (auto var : non_base_variables_) {
-    non_basis_cost_vec(col) =
-        model_.opt_obj.expression.GetCoeffOf(var).float_value;
-    col += 1;
+  int constraint_num = model_.constraints.size();
+  std::vector<Eigen::Triplet<real_t>> triplets;
+  form.bound_vec = Eigen::VectorXd(constraint_num);
+  for (int row = 0; row < constraint_num; row++) {
+    auto& expression = model_.constraints[row].expression;
+    for (auto& entry : expression.variable_coeff) {
+      triplets.emplace_back(row, variable_index[entry.first],
+                            entry.second.float_value);
+    }
+    form.bound_vec(row) = -expression.constant.float_value;
   }
-  col = 0;
-  for (auto var : base_variables_) {
-    basis_cost_vec(col) = model_.opt_obj.expression.GetCoeffOf(var).float_value;
-    col += 1;
+  form.coefficient_mat =
+      Eigen::SparseMatrix<real_t>(constraint_num, form.variables.size());
+  form.coefficient_mat.setFromTriplets(triplets.begin(), triplets.end());
+  form.cost_vec = Eigen::VectorXd::Zero(form.variables.size());
+  for (auto& entry : model_.opt_obj.expression.variable_coeff) {
+    form.cost_vec(variable_index[entry.first]) = entry.second.float_value;
   }
-  col = 0;
-  for (auto con : model_.constraints) {
-    bound_vec(col) = -con.expression.constant.float_value;
-    col += 1;
-  }
-  return {
-      basis_coefficient_mat,
-      non_basis_coefficient_mat,
-      basis_cost_vec,
-      non_basis_cost_vec,
-      bound_vec,
-  };
-}
\ No newline at end of file
+  return form;
+}
@@ -12,9 +12,11 @@
 #include <assert.h>
 
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
 #include <unsupported/Eigen/MatrixFunctions>
 
 #include "base.h"
+#include "normal_equation.h"
 #include "tableau/tableau.h"
 
 const std::string kBase = "base";
@@ -22,6 +24,10 @@ const std::string kSubstitution = "subst";
 const std::string kDual = "dual";
 const std::string kArtificial = "artificial";
 
+// The smallest acceptable crash pivot, relative to the largest entry of its
+// column.
+const real_t kCrashPivotTolerance = 0.1;
+
 bool IsUserDefined(Variable var);
 
 struct Model {
@@ -56,6 +62,36 @@ class LPModel {
     assert(iters > 0);
     log_every_iters_ = iters;
   }
+  // The revised simplex method updates the basis inverse, the simplex
+  // multipliers and the reduced costs incrementally, and recomputes them from
+  // scratch every `iters` pivots.
+  void SetRefactorizationFrequency(int iters) {
+    assert(iters > 0);
+    refactorization_frequency_ = iters;
+  }
+  // The pivot row rho_r^T A of the revised simplex method is computed row-wise
+  // (from the rows of A in the support of rho_r) when the density of rho_r is
+  // below `density`, and column-wise (a dot product per column) otherwise.
+  void SetRowWisePriceDensity(real_t density) {
+    assert(density >= 0.0);
+    row_wise_price_density_ = density;
+  }
+
+  // The fill-reducing ordering of the normal equations A D A^T factorized by
+  // the interior-point methods. The fill of each ordering is logged, so the
+  // best one can be picked per model.
+  void SetOrdering(OrderingMethod ordering) { ordering_ = ordering; }
+  // How the interior-point methods solve the normal equations: the conjugate
+  // gradient methods only multiply by A and A^T, for the models whose factor
+  // of A D A^T does not fit in memory.
+  void SetNormalEquationMethod(NormalEquationMethod method) {
+    normal_equation_method_ = method;
+  }
+  // The primal-dual hybrid gradient method polishes its solution by solving
+  // the primal and the dual feasibility problems from it.
+  void SetEnableFeasibilityPolishing(bool enable) {
+    enable_feasibility_polishing_ = enable;
+  }
 
   // Transform the LP model to standard form:
   //  1. optimization object: maximization
@@ -63,6 +99,13 @@ class LPModel {
   //      \sum_{i} c_i x_i <= b
   void ToStandardForm();
 
+  // Moves the constraints of the standard form that bound a single variable
+  // from above (a * x <= b, a > 0) into the variable bounds 0 <= x <= b / a, so
+  // the dual simplex method treats the variable as a boxed variable instead of
+  // a row. Must be called between ToStandardForm and ToSlackForm, and is only
+  // honored by TableauDualSimplexSolve.
+  void ExtractUpperBounds();
+
   // Transform the LP model to the slack form.
   void ToSlackForm();
 
@@ -80,6 +123,13 @@ class LPModel {
 
   void SetPivotingStrategy(PivotingStrategy strategy) { strategy_ = strategy; }
 
+  // Phase 1 of the tableau simplex methods starts from a crash basis: it
+  // covers as many infeasible rows as possible with structural variables, so
+  // that only the remaining rows need artificial variables.
+  void SetEnableCrashBasis(bool enable_crash_basis) {
+    enable_crash_basis_ = enable_crash_basis;
+  }
+
   /* The Simplex Method. See: https://en.wikipedia.org/wiki/Simplex_algorithm */
   // The key operation of the simplex method.
   void Pivot(Variable base, Variable non_base);
@@ -93,6 +143,10 @@ class LPModel {
   // The phase 1 of the simplex method for Tableau storage.
   Result TableauSimplexInitialize();
 
+  // Pivots structural variables into the rows with negative constants as long
+  // as all the other rows stay feasible.
+  void TableauSimplexCrash();
+
   // The phase 2 (main step) of the simplex method.
   Result SimplexSolve();
 
@@ -114,8 +168,11 @@ class LPModel {
   struct RevisedSimplexMatrixForm;
 
  public:
-  int RevisedSimplexFindLeavingVariable(RevisedSimplexMatrixForm matrix_form,
-                                        int entering_ind);
+  // Returns the index (in the basis) of the leaving variable given the basic
+  // solution x_B = B^{-1} b and the entering direction d = B^{-1} a_e, or -1
+  // if the problem is unbounded along d.
+  int RevisedSimplexFindLeavingVariable(const Eigen::VectorXd& basic_solution,
+                                        const Eigen::VectorXd& direction);
 
   void RevisedSimplexPivot(int base_ind, int non_base_ind);
 
@@ -140,6 +197,27 @@ class LPModel {
 
   std::map<Variable, Num> GetDualSolveSolution();
 
+  /* The dual simplex method on the column-wise sparse tableau (see
+   * ToTableau(COLUMN_ONLY)), sharing the basis factorization of the revised
+   * simplex method. Starts from `initial_basis` (the slack basis if empty),
+   * selects the leaving row with dual steepest-edge pricing. If the starting
+   * basis is not dual feasible, the costs are shifted and the shifts are
+   * removed with primal simplex iterations at the end.
+   */
+  Result TableauDualSimplexSolve(std::set<Variable> initial_basis = {});
+
+  Num GetTableauDualSimplexOptimum();
+
+  std::map<Variable, Num> GetTableauDualSimplexSolution();
+
+  // The number of pivots of the last TableauDualSimplexSolve, including the
+  // primal simplex pivots that remove the cost shifts.
+  int GetTableauDualSimplexIterations() { return dual_simplex_iterations_; }
+
+  // The basis of the last tableau revised or dual simplex solve, it warm
+  // starts TableauDualSimplexSolve on a model with the same rows.
+  std::set<Variable> GetTableauBasis();
+
   /* Solves the linear programming problem with column generation algorithm:
    * https://en.wikipedia.org/wiki/Column_generation
    */
@@ -206,6 +284,57 @@ class LPModel {
 
   std::map<Variable, Num> GetPrimalDualPathFollowingSolution();
 
+  /* The Mehrotra predictor-corrector primal-dual interior-point method on the
+   * slack form: min c^T x s.t. A x = b, x >= 0. Starts from Mehrotra's
+   * (infeasible) starting point, and in each iteration solves the normal
+   * equations twice with one factorization: the affine scaling (predictor)
+   * direction sets the centering parameter, the corrector adds the second
+   * order term. The primal and dual step lengths are chosen separately. Stops
+   * when the relative primal and dual residuals and the relative duality gap
+   * are all below `epsilon`.
+   */
+  Result MehrotraPredictorCorrectorSolve(Num epsilon = 1e-8);
+
+  Num GetMehrotraPredictorCorrectorOptimum();
+
+  std::map<Variable, Num> GetMehrotraPredictorCorrectorSolution();
+
+  /* Crossover from the interior point found by MehrotraPredictorCorrectorSolve
+   * to an optimal basis of the column-wise tableau:
+   *    1. basis identification: the columns are ranked by x_j / (x_j + s_j)
+   *       and the linearly independent ones are taken greedily;
+   *    2. primal push: every non-basic variable still away from zero is moved
+   *       to zero, or into the basis when a basic variable blocks it;
+   *    3. dual push: every basic variable at zero whose dual slack is non-zero
+   *       is pivoted out with a dual ratio test;
+   *    4. cleanup: the dual simplex method (with cost shifting) finishes from
+   *       the pushed basis, which is usually optimal or close to it.
+   * Must be called right after MehrotraPredictorCorrectorSolve succeeds.
+   */
+  Result CrossoverSolve();
+
+  Num GetCrossoverOptimum();
+
+  std::map<Variable, Num> GetCrossoverSolution();
+
+  /* The restarted primal-dual hybrid gradient method (PDLP) on the slack form:
+   * min c^T x s.t. A x = b, x >= 0, with the saddle point problem
+   *    min_{x >= 0} max_y c^T x - y^T (A x - b).
+   * A is multiplied by (never factorized), after a diagonal preconditioning
+   * (Ruiz equilibration, then Pock-Chambolle). The iterates restart from the
+   * average of the iterates since the last restart (or the last iterate) when
+   * their KKT error has decayed enough, and the primal weight balancing the
+   * primal and the dual step sizes is updated at each restart. Stops when the
+   * relative primal and dual residuals and the relative duality gap are all
+   * below `epsilon`, then polishes the feasibility of the solution. Suited to
+   * the models too large for the factorizations of the other methods.
+   */
+  Result PrimalDualHybridGradientSolve(Num epsilon = 1e-6);
+
+  Num GetPrimalDualHybridGradientOptimum();
+
+  std::map<Variable, Num> GetPrimalDualHybridGradientSolution();
+
   // Mark as virtual for the convenience of testing.
   virtual bool IsBaseVariable(Variable var) {
     return base_variables_.find(var) != base_variables_.end();
@@ -282,10 +411,55 @@ class LPModel {
   List<real_t>* basis_coeff = nullptr;
   Tableau<real_t>* basis_inverse = nullptr;
   tableau_index_t* basis_indices = nullptr;
+  // The simplex multipliers p = c_B^T B^{-1} and the reduced costs c + p^T A of
+  // the current basis, maintained incrementally between refactorizations.
+  List<real_t>* simplex_multipliers = nullptr;
+  List<real_t>* reduced_costs = nullptr;
+  // A row-major copy of `tableau_` (which is stored column-wise) used by the
+  // row-wise PRICE.
+  Tableau<real_t>* row_wise_tableau = nullptr;
+  void TableauRevisedSimplexBuildRowWiseTableau();
+  List<real_t>* TableauRevisedSimplexPriceRow(List<real_t>* rho);
+  void TableauRevisedSimplexSetupBasis();
+  std::vector<tableau_index_t> TableauRevisedSimplexCrash(
+      std::vector<real_t>& residual);
+  void TableauRevisedSimplexRefactorize();
+  void TableauRevisedSimplexComputePricing();
+  void TableauRevisedSimplexUpdatePricing(tableau_index_t leaving_basis,
+                                          tableau_index_t entering_basis,
+                                          List<real_t>* mu,
+                                          List<real_t>* pivot_row = nullptr);
   void TableauRevisedSimplexPivot(tableau_index_t leaving_basis,
                                   tableau_index_t entering_basis,
                                   List<real_t>* mu, real_t min_ratio);
   void TableauRevisedSimplexRemoveRedundantConstraint(tableau_index_t row);
+  Result TableauRevisedSimplexIterate();
+  void TableauRevisedSimplexExtractSolution(Num& optimum,
+                                            std::map<Variable, Num>& solution);
+
+  // The dual steepest-edge weights ||rho_i||^2 of the rows of B^{-1}.
+  std::vector<real_t> dual_steepest_edge_weights_;
+  // The amount added to the cost of each non-basic variable to make the
+  // starting basis dual feasible.
+  std::map<tableau_index_t, real_t> cost_shifts_;
+  void TableauDualSimplexComputeWeights();
+  void TableauDualSimplexUpdateWeights(tableau_index_t leaving_basis,
+                                       List<real_t>* mu);
+  void TableauDualSimplexShiftCosts();
+  void TableauDualSimplexRemoveCostShifts();
+  tableau_index_t TableauDualSimplexRatioTest(tableau_index_t leaving_basis,
+                                              bool leaving_to_upper,
+                                              List<real_t>* pivot_row);
+
+  // The upper bounds of the variables taken out of the constraints by
+  // ExtractUpperBounds, and of the tableau columns (empty without bounds).
+  std::map<Variable, real_t> upper_bounds_;
+  std::vector<real_t> tableau_upper_bound_;
+  // Whether a non-base column sits at its upper bound instead of at zero.
+  std::vector<bool> tableau_at_upper_bound_;
+  real_t TableauUpperBound(tableau_index_t col);
+  bool TableauAtUpperBound(tableau_index_t col);
+  void TableauRevisedSimplexComputeBasicSolution();
 
   // Variables that are overrided as user defined vars (usually used in method
   // ToDualForm).
@@ -305,6 +479,9 @@ class LPModel {
   // The solution of dual simplex method.
   Num dual_simplex_optimum_;
   std::map<Variable, Num> dual_simplex_solution_;
+  int dual_simplex_iterations_ = 0;
+  // The pivots of TableauRevisedSimplexIterate.
+  int tableau_simplex_pivots_ = 0;
 
   // The solution of column generation method.
   Num column_generation_optimum_;
@@ -318,6 +495,25 @@ class LPModel {
   Num primal_dual_path_following_optimum_;
   std::map<Variable, Num> primal_dual_path_following_solution_;
 
+  // The solution of Mehrotra predictor-corrector method.
+  Num mehrotra_predictor_corrector_optimum_;
+  std::map<Variable, Num> mehrotra_predictor_corrector_solution_;
+  // The last iterate of the Mehrotra predictor-corrector method (over all the
+  // variables of the slack form), the starting point of the crossover.
+  std::map<Variable, real_t> interior_point_primal_;
+  std::map<Variable, real_t> interior_point_dual_slack_;
+
+  // The solution of the crossover.
+  Num crossover_optimum_;
+  std::map<Variable, Num> crossover_solution_;
+  std::vector<tableau_index_t> CrossoverIdentifyBasis();
+  void CrossoverPrimalPush(std::vector<real_t>& value);
+  void CrossoverDualPush();
+
+  // The solution of primal-dual hybrid gradient method.
+  Num primal_dual_hybrid_gradient_optimum_;
+  std::map<Variable, Num> primal_dual_hybrid_gradient_solution_;
+
   // The representation of the LP model in matrix form.
   struct MatrixForm {
     Eigen::MatrixXd coefficient_mat;
@@ -326,16 +522,27 @@ class LPModel {
   };
   // Convert the constraints to its matrix form.
   MatrixForm ToMatrixForm();
+  struct SparseMatrixForm {
+    Eigen::SparseMatrix<real_t> coefficient_mat;
+    Eigen::VectorXd cost_vec;
+    Eigen::VectorXd bound_vec;
+  };
+  // The same as ToMatrixForm, but only visits the non-zero coefficients and
+  // stores A sparsely.
+  SparseMatrixForm ToSparseMatrixForm();
   // The representation of the LP model in matrix form for revised simplex
-  // method.
+  // method. The coefficients of all variables are stored column-wise once, the
+  // basis and the non-basis are lists of column indices.
   struct RevisedSimplexMatrixForm {
-    Eigen::MatrixXd basis_coefficient_mat;
-    Eigen::MatrixXd non_basis_coefficient_mat;
-    Eigen::VectorXd basis_cost_vec;
-    Eigen::VectorXd non_basis_cost_vec;
+    Eigen::SparseMatrix<real_t> coefficient_mat;
+    Eigen::VectorXd cost_vec;
     Eigen::VectorXd bound_vec;
+    std::vector<Variable> variables;
+    std::vector<int> basis;
+    std::vector<int> non_basis;
   };
   RevisedSimplexMatrixForm ToRevisedSimplexMatrixForm();
+  RevisedSimplexMatrixForm revised_simplex_matrix_form_;
 
   int base_variable_count_ = 0;
   int substitution_variable_count_ = 0;
@@ -344,8 +551,14 @@ class LPModel {
 
   bool enable_logging_ = false;
   int log_every_iters_ = 1;
+  int refactorization_frequency_ = 100;
+  real_t row_wise_price_density_ = 0.1;
+  OrderingMethod ordering_ = AMD_ORDERING;
+  NormalEquationMethod normal_equation_method_ = CHOLESKY;
+  bool enable_feasibility_polishing_ = true;
 
   PivotingStrategy strategy_ = MAX_COST;
+  bool enable_crash_basis_ = true;
 };
 
 bool StandardFormSanityCheck(LPModel model);
@@ -0,0 +1,202 @@
+#include "lp.h"
+
+template <>
+inline bool _IsZeroT(const real_t& x) {
+  return std::abs(x) < kEpsilonF;
+}
+
+// A column is taken into the crossover basis only if the part of it outside
+// the span of the columns already taken is large enough, relative to its norm,
+// which keeps the starting basis well conditioned.
+const real_t kCrossoverIndependenceTolerance = 1e-3;
+
+/* Ranks the columns by x_j / (x_j + s_j), which tends to 1 for the variables
+ * that are positive at the optimal face and to 0 for the others, and takes them
+ * greedily as long as they are linearly independent of the columns already
+ * taken (checked by a Gram-Schmidt projection). The slack columns span the
+ * whole space, so a full basis is always found. Returns the basic columns.
+ */
+std::vector<tableau_index_t> LPModel::CrossoverIdentifyBasis() {
+  tableau_size_t rows = tableau_->Rows();
+  std::vector<tableau_index_t> candidates;
+  std::vector<real_t> score(constant_index_, 0);
+  for (auto col = 0; col < constant_index_; col++) {
+    auto var = index_to_variable_[col];
+    real_t x = std::max(interior_point_primal_[var], real_t(0));
+    real_t s = std::max(interior_point_dual_slack_[var], real_t(0));
+    if (x + s > 0) score[col] = x / (x + s);
+    candidates.push_back(col);
+  }
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [&](tableau_index_t a, tableau_index_t b) {
+                     return score[a] > score[b];
+                   });
+
+  std::vector<tableau_index_t> basis;
+  Eigen::MatrixXd orthonormal(rows, rows);
+  for (auto col : candidates) {
+    if (basis.size() == rows) break;
+    Eigen::VectorXd v = Eigen::VectorXd::Zero(rows);
+    for (auto iter = tableau_->Col(col)->Begin(); !iter->IsEnd();
+         iter = iter->Next())
+      v(iter->Index()) = iter->Data();
+    real_t norm = v.norm();
+    if (norm == 0) continue;
+    auto taken = orthonormal.leftCols(basis.size());
+    // Projected twice against the loss of orthogonality.
+    for (auto k = 0; k < 2; k++) v -= taken * (taken.transpose() * v);
+    if (v.norm() < kCrossoverIndependenceTolerance * norm) continue;
+    orthonormal.col(basis.size()) = v / v.norm();
+    basis.push_back(col);
+  }
+  assert(basis.size() == rows);
+  return basis;
+}
+
+/* Moves every non-basic variable with a positive value `value[j]` (a
+ * superbasic variable) to zero, keeping A x = b by moving x_B along -mu, where
+ * mu = B^{-1} A_j. If a basic variable reaches zero first, x_j takes its place
+ * in the basis. On entry the basic solution already accounts for the values of
+ * the superbasic variables.
+ */
+void LPModel::CrossoverPrimalPush(std::vector<real_t>& value) {
+  std::vector<tableau_index_t> superbasics;
+  for (auto col = 0; col < constant_index_; col++)
+    if (!tableau_is_base_variable_[col] and _IsPositive(value[col]))
+      superbasics.push_back(col);
+  std::stable_sort(superbasics.begin(), superbasics.end(),
+                   [&](tableau_index_t a, tableau_index_t b) {
+                     return value[a] > value[b];
+                   });
+
+  for (auto col : superbasics) {
+    List<real_t>* mu = basis_inverse->Times(tableau_->Col(col));
+    tableau_index_t leaving_basis = -1;
+    real_t min_ratio = value[col];
+    for (auto iter = mu->Begin(); !iter->IsEnd(); iter = iter->Next()) {
+      if (!_IsPositive(iter->Data())) continue;
+      real_t basic_value =
+          std::max(basic_feasible_solution->At(iter->Index()), real_t(0));
+      if (basic_value / iter->Data() < min_ratio) {
+        min_ratio = basic_value / iter->Data();
+        leaving_basis = iter->Index();
+      }
+    }
+    if (leaving_basis < 0) {
+      basic_feasible_solution->AddScaled(mu, -min_ratio, true);
+    } else {
+      TableauRevisedSimplexPivot(leaving_basis, col, mu, -min_ratio);
+      basic_feasible_solution->Set(leaving_basis, value[col] - min_ratio);
+    }
+    value[col] = 0;
+    delete mu;
+  }
+}
+
+/* Pivots out every basic variable at zero that the interior point marks as
+ * non-basic (its dual slack is positive). The entering variable is chosen by
+ * the dual ratio test, so that the reduced costs keep their signs, and the
+ * pivot is degenerate, so that x stays the same.
+ */
+void LPModel::CrossoverDualPush() {
+  tableau_size_t basis_number = base_variables_.size();
+  for (auto i = 0; i < basis_number; i++) {
+    auto var = index_to_variable_[basis_indices[i]];
+    if (!_IsZero(basic_feasible_solution->At(i))) continue;
+    if (!_IsPositive(interior_point_dual_slack_[var])) continue;
+
+    auto pivot_row = TableauRevisedSimplexPriceRow(basis_inverse->Row(i));
+    tableau_index_t entering_non_basis = -1;
+    real_t min_ratio = std::numeric_limits<real_t>::infinity();
+    for (auto iter = pivot_row->Begin(); !iter->IsEnd(); iter = iter->Next()) {
+      auto col = iter->Index();
+      if (col == constant_index_) continue;
+      if (tableau_is_base_variable_[col]) continue;
+      if (!_IsPositive(iter->Data())) continue;
+      real_t ratio =
+          std::max(reduced_costs->At(col), real_t(0)) / iter->Data();
+      if (ratio < min_ratio) {
+        min_ratio = ratio;
+        entering_non_basis = col;
+      }
+    }
+    if (entering_non_basis < 0) {
+      delete pivot_row;
+      continue;
+    }
+
+    List<real_t>* mu = basis_inverse->Times(tableau_->Col(entering_non_basis));
+    TableauRevisedSimplexUpdatePricing(i, entering_non_basis, mu, pivot_row);
+    TableauRevisedSimplexPivot(
+        i, entering_non_basis, mu,
+        -basic_feasible_solution->At(i) / mu->At(i));
+    delete pivot_row;
+    delete mu;
+  }
+}
+
+Result LPModel::CrossoverSolve() {
+  assert(!interior_point_primal_.empty());
+  // Back to the maximization form the tableau methods expect.
+  if (model_.opt_obj.opt_type == OptimizationObject::MIN) {
+    model_.opt_obj.SetOptType(OptimizationObject::MAX);
+    model_.opt_obj.expression *= -1.0;
+    opt_reverted_ = !opt_reverted_;
+  }
+  ToTableau(COLUMN_ONLY);
+  // Phase 1 of the cleanup does not handle boxed variables.
+  assert(tableau_upper_bound_.empty());
+  opt_obj_tableau_->Scale(-1.0);
+  opt_reverted_ = !opt_reverted_;
+
+  non_base_variables_.insert(base_variables_.begin(), base_variables_.end());
+  base_variables_.clear();
+  for (auto i = 0; i < constant_index_; i++)
+    tableau_is_base_variable_[i] = false;
+  for (auto col : CrossoverIdentifyBasis()) {
+    auto var = index_to_variable_[col];
+    non_base_variables_.erase(var);
+    base_variables_.insert(var);
+    tableau_is_base_variable_[col] = true;
+  }
+  TableauRevisedSimplexSetupBasis();
+  TableauRevisedSimplexBuildRowWiseTableau();
+
+  // x_B = B^{-1} (b + A_S x_S), where S are the superbasic variables.
+  std::vector<real_t> value(constant_index_, 0);
+  auto constant = new List<real_t>(tableau_->Col(constant_index_));
+  for (auto col = 0; col < constant_index_; col++) {
+    if (tableau_is_base_variable_[col]) continue;
+    value[col] = interior_point_primal_[index_to_variable_[col]];
+    if (_IsPositive(value[col]))
+      constant->AddScaled(tableau_->Col(col), value[col], true);
+  }
+  auto solution = basis_inverse->Times(constant);
+  for (auto i = 0; i < base_variables_.size(); i++)
+    basic_feasible_solution->Set(i, solution->At(i));
+  delete solution;
+  delete constant;
+
+  CrossoverPrimalPush(value);
+  TableauRevisedSimplexRefactorize();
+  TableauRevisedSimplexComputePricing();
+  CrossoverDualPush();
+
+  // The pushes changed the basis only, the cleanup starts from it. The pivots
+  // update `basis_indices` but not `base_variables_`, the basis is read from
+  // the former.
+  auto pushed_basis = GetTableauBasis();
+  opt_obj_tableau_->Scale(-1.0);
+  opt_reverted_ = !opt_reverted_;
+  auto result = TableauDualSimplexSolve(pushed_basis);
+  if (result != SOLVED) return result;
+  crossover_optimum_ = GetTableauDualSimplexOptimum();
+  crossover_solution_ = GetTableauDualSimplexSolution();
+  return SOLVED;
+}
+
+Num LPModel::GetCrossoverOptimum() { return crossover_optimum_; }
+
+std::map<Variable, Num> LPModel::GetCrossoverSolution() {
+  return crossover_solution_;
+}
@@ -0,0 +1,63 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "lp.h"
+#include "parser.h"
+
+TEST(LPModel, CrossoverSolve) {
+  Parser parser;
+  std::ifstream file("tests/test4.txt");
+  LPModel model = parser.Parse(file);
+  Variable x1("x1"), x2("x2");
+  model.ToStandardForm();
+  model.ToSlackForm();
+  auto constraint_num = model.GetBaseVariables().size();
+
+  EXPECT_EQ(model.MehrotraPredictorCorrectorSolve(), SOLVED);
+  EXPECT_EQ(model.CrossoverSolve(), SOLVED);
+
+  EXPECT_EQ(model.GetCrossoverOptimum(), 5.0f);
+  auto expected_sol = std::map<Variable, Num>({{x1, 2.0 / 3}, {x2, 1.0 / 3}});
+  auto actual_sol = model.GetCrossoverSolution();
+  for (auto entry : expected_sol) {
+    EXPECT_LE(entry.second - actual_sol[entry.first], 1e-5f);
+    EXPECT_GE(entry.second - actual_sol[entry.first], -1e-5f);
+  }
+  // The pushes end at an optimal basis, the cleanup starts from it and does
+  // not pivot.
+  EXPECT_EQ(model.GetBaseVariables().size(), constraint_num);
+  EXPECT_EQ(model.GetTableauDualSimplexIterations(), 0);
+  EXPECT_EQ(model.GetBaseVariables(), model.GetTableauBasis());
+}
+
+TEST(LPModel, CrossoverSolve2) {
+  Parser parser;
+  std::ifstream file("tests/test9.txt");
+  LPModel model = parser.Parse(file);
+  model.ToStandardForm();
+  model.ToSlackForm();
+
+  EXPECT_EQ(model.MehrotraPredictorCorrectorSolve(), SOLVED);
+  EXPECT_EQ(model.CrossoverSolve(), SOLVED);
+
+  EXPECT_LE(1.685733f - model.GetCrossoverOptimum(), 1e-5f);
+  EXPECT_GE(1.685733f - model.GetCrossoverOptimum(), -1e-5f);
+}
+
+TEST(LPModel, CrossoverSolveDegenerate) {
+  // The optimal face of test15 is not a single vertex, the crossover ends at
+  // one of its vertices.
+  Parser parser;
+  std::ifstream file("tests/test15.txt");
+  LPModel model = parser.Parse(file);
+  model.ToStandardForm();
+  model.ToSlackForm();
+
+  EXPECT_EQ(model.MehrotraPredictorCorrectorSolve(), SOLVED);
+  EXPECT_EQ(model.CrossoverSolve(), SOLVED);
+
+  EXPECT_LE(26113.5f - model.GetCrossoverOptimum(), 1e-3f);
+  EXPECT_GE(26113.5f - model.GetCrossoverOptimum(), -1e-3f);
+  for (auto entry : model.GetCrossoverSolution())
+    EXPECT_GE(entry.second, Num(0.0f));
+}
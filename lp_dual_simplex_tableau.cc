@@ -0,0 +1,281 @@
+#include "lp.h"
+
+template <>
+inline bool _IsZeroT(const real_t& x) {
+  return std::abs(x) < kEpsilonF;
+}
+
+// The reduced cost of a shifted non-basic variable, slightly positive so that
+// it does not tie with the other candidates of the dual ratio test.
+const real_t kDualFeasibilityShift = 1e-5;
+// Guards the updated dual steepest-edge weights against cancellation.
+const real_t kMinDualSteepestEdgeWeight = 1e-4;
+
+void LPModel::TableauDualSimplexComputeWeights() {
+  tableau_size_t basis_number = base_variables_.size();
+  dual_steepest_edge_weights_.assign(basis_number, 0);
+  for (auto i = 0; i < basis_number; i++) {
+    for (auto iter = basis_inverse->Row(i)->Begin(); !iter->IsEnd();
+         iter = iter->Next())
+      dual_steepest_edge_weights_[i] += iter->Data() * iter->Data();
+  }
+}
+
+/* Updates the weights w_i = ||rho_i||^2 for the pivot (leaving_basis, q), must
+ * be called before the basis inverse is updated. With alpha_q = B^{-1} A_q =
+ * -mu, the rows of B^{-1} change as:
+ *    rho_r' = rho_r / alpha_rq
+ *    rho_i' = rho_i - (alpha_iq / alpha_rq) * rho_r
+ * so that (Forrest and Goldfarb, 1992), with tau = B^{-1} rho_r:
+ *    w_r' = w_r / alpha_rq^2
+ *    w_i' = w_i - 2 * (alpha_iq / alpha_rq) * tau_i
+ *               + (alpha_iq / alpha_rq)^2 * w_r
+ */
+void LPModel::TableauDualSimplexUpdateWeights(tableau_index_t leaving_basis,
+                                              List<real_t>* mu) {
+  auto tau = basis_inverse->Times(basis_inverse->Row(leaving_basis));
+  real_t pivot = mu->At(leaving_basis);
+  real_t leaving_weight = dual_steepest_edge_weights_[leaving_basis];
+  for (auto iter = mu->Begin(); !iter->IsEnd(); iter = iter->Next()) {
+    if (iter->Index() == leaving_basis) continue;
+    if (_IsZero(iter->Data())) continue;
+    real_t ratio = iter->Data() / pivot;
+    real_t& weight = dual_steepest_edge_weights_[iter->Index()];
+    weight = std::max(weight - 2 * ratio * tau->At(iter->Index()) +
+                          ratio * ratio * leaving_weight,
+                      kMinDualSteepestEdgeWeight);
+  }
+  dual_steepest_edge_weights_[leaving_basis] = std::max(
+      leaving_weight / (pivot * pivot), kMinDualSteepestEdgeWeight);
+  delete tau;
+}
+
+/* Makes the current basis dual feasible. A boxed non-basic variable is dual
+ * feasible at one of its bounds, so it is moved to the bound that matches the
+ * sign of its reduced cost, while the cost of any other non-basic variable
+ * with a negative reduced cost is raised.
+ */
+void LPModel::TableauDualSimplexShiftCosts() {
+  cost_shifts_.clear();
+  bool flipped = false;
+  for (auto i = 0; i < reduced_costs->Size(); i++) {
+    if (i == constant_index_) continue;
+    if (tableau_is_base_variable_[i]) continue;
+    real_t cost = reduced_costs->At(i);
+    if (TableauUpperBound(i) < std::numeric_limits<real_t>::infinity()) {
+      if (TableauAtUpperBound(i) ? _IsPositive(cost) : _IsNegative(cost)) {
+        tableau_at_upper_bound_[i] = !tableau_at_upper_bound_[i];
+        flipped = true;
+      }
+      continue;
+    }
+    if (!_IsNegative(cost)) continue;
+    real_t shift = kDualFeasibilityShift - cost;
+    cost_shifts_[i] = shift;
+    opt_obj_tableau_->Set(i, opt_obj_tableau_->At(i) + shift);
+    reduced_costs->Set(i, kDualFeasibilityShift);
+  }
+  if (flipped) TableauRevisedSimplexComputeBasicSolution();
+}
+
+/* The bound-flipping (long-step) ratio test. Moving the dual along the leaving
+ * row r, the dual objective rises at the rate of the primal infeasibility of
+ * x_{B_r} and every breakpoint t_j = |d_j / alpha_rj| passed lowers the rate by
+ * |alpha_rj| * u_j, since x_j has to flip to its other bound to keep d_j of the
+ * right sign. The breakpoints of boxed variables are passed as long as the rate
+ * stays positive, the variable of the breakpoint where it stops enters the
+ * basis, and the variables passed over are flipped with a single update of x_B.
+ */
+tableau_index_t LPModel::TableauDualSimplexRatioTest(
+    tableau_index_t leaving_basis, bool leaving_to_upper,
+    List<real_t>* pivot_row) {
+  struct Breakpoint {
+    tableau_index_t col;
+    real_t ratio;
+    real_t pivot;
+  };
+  // The tableau stores -A, x_{B_r} rises with the non-base variables whose
+  // entry in the pivot row is positive.
+  real_t sign = leaving_to_upper ? -1 : 1;
+  std::vector<Breakpoint> breakpoints;
+  for (auto iter = pivot_row->Begin(); !iter->IsEnd(); iter = iter->Next()) {
+    auto col = iter->Index();
+    if (col == constant_index_) continue;
+    if (tableau_is_base_variable_[col]) continue;
+    bool at_upper = TableauAtUpperBound(col);
+    real_t rate = sign * iter->Data();
+    if (at_upper ? !_IsNegative(rate) : !_IsPositive(rate)) continue;
+    real_t cost = reduced_costs->At(col);
+    breakpoints.push_back(
+        {col, std::max(at_upper ? -cost : cost, real_t(0)) / std::abs(rate),
+         std::abs(rate)});
+  }
+  if (breakpoints.empty()) return -1;
+  std::sort(breakpoints.begin(), breakpoints.end(),
+            [](const Breakpoint& a, const Breakpoint& b) {
+              if (std::abs(a.ratio - b.ratio) > kEpsilonF)
+                return a.ratio < b.ratio;
+              return a.pivot > b.pivot;
+            });
+
+  real_t value = basic_feasible_solution->At(leaving_basis);
+  real_t slope = leaving_to_upper
+                     ? value - TableauUpperBound(basis_indices[leaving_basis])
+                     : -value;
+  std::vector<tableau_index_t> flipped;
+  tableau_index_t entering_non_basis = breakpoints.back().col;
+  for (auto k = 0; k + 1 < breakpoints.size(); k++) {
+    real_t upper = TableauUpperBound(breakpoints[k].col);
+    if (upper == std::numeric_limits<real_t>::infinity() or
+        !_IsPositive(slope - breakpoints[k].pivot * upper)) {
+      entering_non_basis = breakpoints[k].col;
+      break;
+    }
+    slope -= breakpoints[k].pivot * upper;
+    flipped.push_back(breakpoints[k].col);
+  }
+
+  if (!flipped.empty()) {
+    auto delta = new List<real_t>(tableau_->Rows(), DENSE);
+    for (auto col : flipped) {
+      real_t upper = tableau_upper_bound_[col];
+      delta->AddScaled(tableau_->Col(col),
+                       tableau_at_upper_bound_[col] ? -upper : upper, true);
+      tableau_at_upper_bound_[col] = !tableau_at_upper_bound_[col];
+    }
+    auto delta_basic = basis_inverse->Times(delta);
+    basic_feasible_solution->AddScaled(delta_basic, 1.0, true);
+    delete delta_basic;
+    delete delta;
+  }
+  return entering_non_basis;
+}
+
+void LPModel::TableauDualSimplexRemoveCostShifts() {
+  if (cost_shifts_.empty()) return;
+  for (auto entry : cost_shifts_)
+    opt_obj_tableau_->Set(entry.first,
+                          opt_obj_tableau_->At(entry.first) - entry.second);
+  cost_shifts_.clear();
+  for (auto i = 0; i < base_variables_.size(); i++)
+    basis_coeff->Set(i, opt_obj_tableau_->At(basis_indices[i]));
+  TableauRevisedSimplexComputePricing();
+}
+
+Result LPModel::TableauDualSimplexSolve(std::set<Variable> initial_basis) {
+  assert(model_.opt_obj.opt_type == OptimizationObject::MAX);
+  assert(tableau_->StorageFormat() == COLUMN_ONLY);
+  opt_obj_tableau_->Scale(-1.0);
+  opt_reverted_ = !opt_reverted_;
+
+  if (!initial_basis.empty()) {
+    assert(initial_basis.size() == tableau_->Rows());
+    non_base_variables_.insert(base_variables_.begin(), base_variables_.end());
+    base_variables_.clear();
+    for (auto i = 0; i < constant_index_; i++)
+      tableau_is_base_variable_[i] = false;
+    for (auto var : initial_basis) {
+      assert(non_base_variables_.find(var) != non_base_variables_.end());
+      non_base_variables_.erase(var);
+      base_variables_.insert(var);
+      tableau_is_base_variable_[variable_to_index_[var]] = true;
+    }
+  }
+  tableau_size_t basis_number = base_variables_.size();
+  dual_simplex_iterations_ = 0;
+  tableau_at_upper_bound_.assign(constant_index_, false);
+  TableauRevisedSimplexSetupBasis();
+  TableauRevisedSimplexBuildRowWiseTableau();
+  TableauRevisedSimplexComputePricing();
+  TableauDualSimplexComputeWeights();
+  TableauDualSimplexShiftCosts();
+
+  int iter = 0;
+  while (true) {
+    if (iter > 0 and iter % refactorization_frequency_ == 0) {
+      TableauRevisedSimplexRefactorize();
+      TableauRevisedSimplexComputePricing();
+      TableauDualSimplexComputeWeights();
+    }
+    iter += 1;
+
+    // Dual steepest-edge pricing: the basic variable with the largest
+    // infeasibility relative to the norm of its row of B^{-1} leaves.
+    tableau_index_t leaving_basis = -1;
+    bool leaving_to_upper = false;
+    real_t max_infeasibility = 0;
+    for (auto i = 0; i < basis_number; i++) {
+      real_t value = basic_feasible_solution->At(i);
+      real_t upper = TableauUpperBound(basis_indices[i]);
+      real_t violation = 0;
+      if (_IsNegative(value)) violation = -value;
+      if (_IsPositive(value - upper)) violation = value - upper;
+      if (violation == 0) continue;
+      real_t infeasibility =
+          violation * violation / dual_steepest_edge_weights_[i];
+      if (infeasibility > max_infeasibility) {
+        max_infeasibility = infeasibility;
+        leaving_basis = i;
+        leaving_to_upper = value > upper;
+      }
+    }
+    // The basis is primal feasible, hence optimal.
+    if (leaving_basis < 0) break;
+    dual_simplex_iterations_ = iter;
+
+    auto pivot_row =
+        TableauRevisedSimplexPriceRow(basis_inverse->Row(leaving_basis));
+    tableau_index_t entering_non_basis =
+        TableauDualSimplexRatioTest(leaving_basis, leaving_to_upper, pivot_row);
+    if (entering_non_basis < 0) {
+      // The dual is unbounded, x_{B_r} can never be brought within its bounds.
+      delete pivot_row;
+      return NOSOLUTION;
+    }
+
+    List<real_t>* mu = basis_inverse->Times(tableau_->Col(entering_non_basis));
+    TableauDualSimplexUpdateWeights(leaving_basis, mu);
+    TableauRevisedSimplexUpdatePricing(leaving_basis, entering_non_basis, mu,
+                                       pivot_row);
+    tableau_index_t leaving_col = basis_indices[leaving_basis];
+    real_t target = leaving_to_upper ? TableauUpperBound(leaving_col) : 0;
+    real_t step = (target - basic_feasible_solution->At(leaving_basis)) /
+                  mu->At(leaving_basis);
+    real_t entering_value = (TableauAtUpperBound(entering_non_basis)
+                                 ? TableauUpperBound(entering_non_basis)
+                                 : 0) +
+                            step;
+    TableauRevisedSimplexPivot(leaving_basis, entering_non_basis, mu, step);
+    basic_feasible_solution->Set(leaving_basis, entering_value);
+    tableau_at_upper_bound_[entering_non_basis] = false;
+    tableau_at_upper_bound_[leaving_col] = leaving_to_upper;
+    delete pivot_row;
+    delete mu;
+  }
+
+  if (!cost_shifts_.empty()) {
+    // Optimal for the shifted costs only, the primal simplex method finishes
+    // from the (primal feasible) basis.
+    TableauDualSimplexRemoveCostShifts();
+    int pivots = tableau_simplex_pivots_;
+    auto result = TableauRevisedSimplexIterate();
+    dual_simplex_iterations_ += tableau_simplex_pivots_ - pivots;
+    if (result != SOLVED) return result;
+  }
+  TableauRevisedSimplexExtractSolution(dual_simplex_optimum_,
+                                       dual_simplex_solution_);
+  return SOLVED;
+}
+
+Num LPModel::GetTableauDualSimplexOptimum() { return dual_simplex_optimum_; }
+
+std::map<Variable, Num> LPModel::GetTableauDualSimplexSolution() {
+  return dual_simplex_solution_;
+}
+
+std::set<Variable> LPModel::GetTableauBasis() {
+  std::set<Variable> basis;
+  for (auto i = 0; i < base_variables_.size(); i++)
+    basis.insert(index_to_variable_[basis_indices[i]]);
+  return basis;
+}
@@ -0,0 +1,98 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "lp.h"
+#include "parser.h"
+
+TEST(LPModel, TableauDualSimplexSolve) {
+  // The slack basis of test4 is dual feasible but not primal feasible.
+  Parser parser;
+  std::ifstream file("tests/test4.txt");
+  LPModel model = parser.Parse(file);
+  Variable x1("x1"), x2("x2");
+  model.ToStandardForm();
+  model.ToSlackForm();
+  model.ToTableau(COLUMN_ONLY);
+
+  EXPECT_EQ(model.TableauDualSimplexSolve(), Result::SOLVED);
+
+  EXPECT_LE(model.GetTableauDualSimplexOptimum() - 5.0f, 1e-6f);
+  EXPECT_GE(model.GetTableauDualSimplexOptimum() - 5.0f, -1e-6f);
+
+  auto expected_sol = std::map<Variable, Num>({{x1, 2.0f / 3}, {x2, 1.0f / 3}});
+  auto actual_sol = model.GetTableauDualSimplexSolution();
+  EXPECT_EQ(expected_sol.size(), actual_sol.size());
+  for (auto entry : expected_sol) {
+    EXPECT_EQ(actual_sol.find(entry.first) != actual_sol.end(), true);
+    EXPECT_LE(actual_sol[entry.first] - entry.second, 1e-6f);
+    EXPECT_GE(actual_sol[entry.first] - entry.second, -1e-6f);
+  }
+}
+
+TEST(LPModel, TableauDualSimplexSolve2) {
+  Parser parser;
+  std::ifstream file("tests/test9.txt");
+  LPModel model = parser.Parse(file);
+
+  Variable x1("x1"), x2("x2"), x3("x3"), x4("x4");
+  Variable b0("base0"), b1("base1"), b2("base2");
+
+  model.ToStandardForm();
+  model.ToSlackForm();
+  model.ToTableau(COLUMN_ONLY);
+
+  EXPECT_EQ(model.TableauDualSimplexSolve({b0, b1, b2}), Result::SOLVED);
+  EXPECT_LE(model.GetTableauDualSimplexOptimum() - Num(1.685733f), 1e-6f);
+  EXPECT_GE(model.GetTableauDualSimplexOptimum() - Num(1.685733f), -1e-6f);
+
+  auto expected_sol = std::map<Variable, Num>(
+      {{x1, 0.704872f}, {x2, 2.074765f}, {x3, 0.0f}, {x4, 0.056302f}});
+  auto actual_sol = model.GetTableauDualSimplexSolution();
+  for (auto entry : expected_sol) {
+    EXPECT_EQ(actual_sol.find(entry.first) != actual_sol.end(), true);
+    EXPECT_LE(entry.second - actual_sol[entry.first], 1e-6f);
+    EXPECT_GE(entry.second - actual_sol[entry.first], -1e-6f);
+  }
+}
+
+TEST(LPModel, TableauDualSimplexCostShifting) {
+  // The slack basis of test15 is neither primal nor dual feasible, the costs
+  // are shifted and then restored by the primal simplex method.
+  Parser parser;
+  std::ifstream file("tests/test15.txt");
+  LPModel model = parser.Parse(file);
+  model.ToStandardForm();
+  model.ToSlackForm();
+  model.ToTableau(COLUMN_ONLY);
+
+  EXPECT_EQ(model.TableauDualSimplexSolve(), Result::SOLVED);
+
+  EXPECT_LE(model.GetTableauDualSimplexOptimum() - 26113.5f, 1e-3f);
+  EXPECT_GE(model.GetTableauDualSimplexOptimum() - 26113.5f, -1e-3f);
+}
+
+TEST(LPModel, TableauDualSimplexBoundFlipping) {
+  // x1 <= 1000 and x2 <= 1500 of test13 are treated as variable bounds.
+  Parser parser;
+  std::ifstream file("tests/test13.txt");
+  LPModel model = parser.Parse(file);
+  Variable x1("x1"), x2("x2");
+  model.ToStandardForm();
+  model.ExtractUpperBounds();
+  model.ToSlackForm();
+  model.ToTableau(COLUMN_ONLY);
+
+  EXPECT_EQ(model.TableauDualSimplexSolve(), Result::SOLVED);
+
+  EXPECT_LE(model.GetTableauDualSimplexOptimum() - 17700.0f, 1e-3f);
+  EXPECT_GE(model.GetTableauDualSimplexOptimum() - 17700.0f, -1e-3f);
+
+  auto expected_sol = std::map<Variable, Num>({{x1, 650.0f}, {x2, 1100.0f}});
+  auto actual_sol = model.GetTableauDualSimplexSolution();
+  EXPECT_EQ(expected_sol.size(), actual_sol.size());
+  for (auto entry : expected_sol) {
+    EXPECT_EQ(actual_sol.find(entry.first) != actual_sol.end(), true);
+    EXPECT_LE(actual_sol[entry.first] - entry.second, 1e-3f);
+    EXPECT_GE(actual_sol[entry.first] - entry.second, -1e-3f);
+  }
+}
@@ -0,0 +1,169 @@
+#include "lp.h"
+
+const int kMaxInteriorPointIterations = 200;
+// The fraction of the step to the boundary of the positive orthant taken in
+// each iteration, it approaches 1 as the iterates approach optimality.
+const real_t kMinStepToBoundary = 0.9;
+const real_t kMaxStepToBoundary = 0.995;
+// A D A^T becomes singular when the iterates approach a degenerate optimum,
+// e.g. the two inequalities an equality constraint is split into have
+// dependent rows once their slacks vanish. Its factorization is then retried
+// with a growing regularization, relative to the largest entry of D.
+const real_t kMinNormalEquationRegularization = 1e-14;
+const real_t kMaxNormalEquationRegularization = 1e-4;
+
+// The largest step length in [0, 1] that keeps v + alpha * dv >= 0.
+real_t MaxStepToBoundary(const Eigen::VectorXd& v, const Eigen::VectorXd& dv) {
+  real_t alpha = 1.0;
+  for (auto i = 0; i < v.size(); i++) {
+    if (dv(i) < 0) alpha = std::min(alpha, -v(i) / dv(i));
+  }
+  return alpha;
+}
+
+Result LPModel::MehrotraPredictorCorrectorSolve(Num epsilon) {
+  // The slack variables are columns of A too.
+  auto non_base_variables = non_base_variables_;
+  non_base_variables_.insert(base_variables_.begin(), base_variables_.end());
+  std::vector<Variable> columns(non_base_variables_.begin(),
+                                non_base_variables_.end());
+  // Minimization form.
+  if (model_.opt_obj.opt_type == OptimizationObject::MAX) {
+    model_.opt_obj.SetOptType(OptimizationObject::MIN);
+    model_.opt_obj.expression *= -1.0;
+    opt_reverted_ = !opt_reverted_;
+  }
+  auto matrix_form = ToSparseMatrixForm();
+  non_base_variables_ = non_base_variables;
+  NormalEquationSolver normal_equation(matrix_form.coefficient_mat, 0.0,
+                                       ordering_, normal_equation_method_);
+  if (enable_logging_ and normal_equation_method_ == CHOLESKY)
+    std::cout << normal_equation.GetFillStatistics().ToString()
+              << ", dense columns " << normal_equation.GetDenseColumns().size()
+              << "\n";
+  auto& A = normal_equation.A();
+  auto& At = normal_equation.At();
+  Eigen::VectorXd b = matrix_form.bound_vec;
+  Eigen::VectorXd c = matrix_form.cost_vec;
+  int variable_num = A.cols();
+
+  // Solves the Newton system
+  //    A dx = r_p, A^T dy + ds = r_d, S dx + X ds = r_xs
+  // by eliminating dx and ds:
+  //    (A D A^T) dy = r_p - A S^{-1} (r_xs - X r_d), where D = X S^{-1}
+  auto newton_direction = [&](const Eigen::VectorXd& x,
+                              const Eigen::VectorXd& s,
+                              const Eigen::VectorXd& r_p,
+                              const Eigen::VectorXd& r_d,
+                              const Eigen::VectorXd& r_xs, Eigen::VectorXd& dx,
+                              Eigen::VectorXd& dy, Eigen::VectorXd& ds) {
+    Eigen::VectorXd w = (r_xs - x.cwiseProduct(r_d)).cwiseQuotient(s);
+    dy = normal_equation.Solve(r_p - A * w);
+    ds = r_d - At * dy;
+    dx = w + x.cwiseProduct(At * dy).cwiseQuotient(s);
+  };
+
+  // Mehrotra's starting point: the least squares solutions of A x = b and
+  // A^T y + s = c, shifted into the positive orthant.
+  bool factorized =
+      normal_equation.Factorize(Eigen::VectorXd::Ones(variable_num));
+  assert(factorized);
+  Eigen::VectorXd x = At * normal_equation.Solve(b);
+  Eigen::VectorXd y = normal_equation.Solve(A * c);
+  Eigen::VectorXd s = c - At * y;
+  x.array() += std::max(-1.5 * x.minCoeff(), 0.0);
+  s.array() += std::max(-1.5 * s.minCoeff(), 0.0);
+  real_t xs = x.dot(s);
+  if (xs <= 0) {
+    // x = 0 or s = 0, e.g. b = 0 or c = 0.
+    x.array() += 1.0;
+    s.array() += 1.0;
+    xs = x.dot(s);
+  }
+  real_t x_shift = 0.5 * xs / s.sum(), s_shift = 0.5 * xs / x.sum();
+  x.array() += x_shift;
+  s.array() += s_shift;
+
+  bool converged = false;
+  for (int iter = 0; iter < kMaxInteriorPointIterations; iter++) {
+    Eigen::VectorXd r_p = b - A * x;
+    Eigen::VectorXd r_d = c - At * y - s;
+    real_t mu = x.dot(s) / variable_num;
+    real_t primal_objective = c.dot(x), dual_objective = b.dot(y);
+    if (r_p.norm() / (1.0 + b.norm()) < epsilon.float_value and
+        r_d.norm() / (1.0 + c.norm()) < epsilon.float_value and
+        std::abs(primal_objective - dual_objective) /
+                (1.0 + std::abs(primal_objective)) <
+            epsilon.float_value) {
+      converged = true;
+      break;
+    }
+    if (enable_logging_ and iter % log_every_iters_ == 0)
+      std::cout << "iter " << iter << ", primal objective " << primal_objective
+                << ", dual objective " << dual_objective << ", mu " << mu
+                << "\n";
+
+    Eigen::VectorXd d = x.cwiseQuotient(s);
+    normal_equation.SetRegularization(0.0);
+    for (real_t regularization = kMinNormalEquationRegularization;
+         !normal_equation.Factorize(d); regularization *= 100) {
+      if (regularization > kMaxNormalEquationRegularization) return ERROR;
+      normal_equation.SetRegularization(regularization * d.maxCoeff());
+    }
+
+    // Predictor: the affine scaling direction.
+    Eigen::VectorXd dx, dy, ds;
+    newton_direction(x, s, r_p, r_d, -x.cwiseProduct(s), dx, dy, ds);
+    real_t alpha_primal = MaxStepToBoundary(x, dx);
+    real_t alpha_dual = MaxStepToBoundary(s, ds);
+    real_t mu_affine =
+        (x + alpha_primal * dx).dot(s + alpha_dual * ds) / variable_num;
+    real_t sigma = std::pow(mu_affine / mu, 3);
+
+    // Corrector: centering plus the second order term of the predictor.
+    Eigen::VectorXd r_xs = -x.cwiseProduct(s) - dx.cwiseProduct(ds) +
+                           Eigen::VectorXd::Constant(variable_num, sigma * mu);
+    newton_direction(x, s, r_p, r_d, r_xs, dx, dy, ds);
+
+    real_t eta =
+        std::min(std::max(1.0 - mu, kMinStepToBoundary), kMaxStepToBoundary);
+    alpha_primal = std::min(1.0, eta * MaxStepToBoundary(x, dx));
+    alpha_dual = std::min(1.0, eta * MaxStepToBoundary(s, ds));
+    x += alpha_primal * dx;
+    y += alpha_dual * dy;
+    s += alpha_dual * ds;
+  }
+  if (!converged) return ERROR;
+
+  std::map<Variable, Num> all_sol;
+  int i = 0;
+  for (auto var : columns) {
+    all_sol[var] = x(i);
+    interior_point_primal_[var] = x(i);
+    interior_point_dual_slack_[var] = s(i);
+    if (IsUserDefined(var) or IsOverriddenAsUserDefined(var))
+      mehrotra_predictor_corrector_solution_[var] = x(i);
+    i += 1;
+  }
+  for (auto entry : raw_variable_expression_) {
+    auto raw_var = entry.first;
+    auto exp = entry.second;
+    while (exp.variable_coeff.size() > 0) {
+      auto entry = *exp.variable_coeff.begin();
+      ReplaceVariableWithExpression(exp, entry.first, all_sol[entry.first]);
+    }
+    mehrotra_predictor_corrector_solution_[raw_var] = exp.constant;
+  }
+  mehrotra_predictor_corrector_optimum_ =
+      c.dot(x) + model_.opt_obj.expression.constant.float_value;
+  if (opt_reverted_) mehrotra_predictor_corrector_optimum_ *= -1.0f;
+  return SOLVED;
+}
+
+Num LPModel::GetMehrotraPredictorCorrectorOptimum() {
+  return mehrotra_predictor_corrector_optimum_;
+}
+
+std::map<Variable, Num> LPModel::GetMehrotraPredictorCorrectorSolution() {
+  return mehrotra_predictor_corrector_solution_;
+}
@@ -0,0 +1,326 @@
+#include "lp.h"
+
+const int kMaxPrimalDualHybridGradientIterations = 500000;
+// The restart criteria are checked (and the averages evaluated) every
+// `kRestartCheckFrequency` iterations.
+const int kRestartCheckFrequency = 64;
+// The restart criteria of PDLP (Applegate et al., 2021), on the decay of the
+// normalized KKT error since the last restart.
+const real_t kSufficientRestartDecay = 0.2;
+const real_t kNecessaryRestartDecay = 0.8;
+const real_t kArtificialRestartFraction = 0.36;
+// The smoothing of the primal weight updates at restarts.
+const real_t kPrimalWeightSmoothing = 0.5;
+const int kRuizIterations = 10;
+const int kPowerIterations = 64;
+// tau * sigma * ||A||^2 = kStepSizeFraction^2 < 1.
+const real_t kStepSizeFraction = 0.9;
+// The feasibility problems of the polishing are solved to this fraction of
+// the tolerance, within this many iterations.
+const real_t kPolishingTolerance = 1e-2;
+const int kMaxPolishingIterations = 20000;
+
+typedef Eigen::SparseMatrix<real_t, Eigen::RowMajor> CsrMatrix;
+
+// y = M x over the rows of a CSR matrix, split among the OpenMP threads.
+void ParallelMultiply(const CsrMatrix& mat, const Eigen::VectorXd& x,
+                      Eigen::VectorXd& y) {
+  y.resize(mat.rows());
+  const int* outer = mat.outerIndexPtr();
+  const int* inner = mat.innerIndexPtr();
+  const real_t* value = mat.valuePtr();
+#pragma omp parallel for schedule(static)
+  for (int i = 0; i < mat.rows(); i++) {
+    real_t sum = 0;
+    for (auto k = outer[i]; k < outer[i + 1]; k++)
+      sum += value[k] * x(inner[k]);
+    y(i) = sum;
+  }
+}
+
+/* The restarted primal-dual hybrid gradient method on
+ *    min c^T x s.t. A x = b, x >= 0
+ * after the diagonal preconditioning A' = R A C (x = C x', y = R y'). Only A x
+ * and A^T y are computed, with a CSR copy of A and one of A^T.
+ */
+struct PrimalDualHybridGradient {
+  CsrMatrix A, At;
+  Eigen::VectorXd row_scale, col_scale;
+  real_t step_size = 1.0;
+  real_t primal_weight = 1.0;
+  int iterations = 0;
+  bool logging = false;
+  int log_every = 1;
+
+  PrimalDualHybridGradient(const Eigen::SparseMatrix<real_t>& mat) {
+    Eigen::SparseMatrix<real_t> scaled = mat;
+    row_scale = Eigen::VectorXd::Ones(mat.rows());
+    col_scale = Eigen::VectorXd::Ones(mat.cols());
+    // Ruiz equilibration: the inf-norms of the rows and the columns tend to 1.
+    for (auto iter = 0; iter < kRuizIterations; iter++) {
+      Eigen::VectorXd row_max = Eigen::VectorXd::Zero(mat.rows());
+      Eigen::VectorXd col_max = Eigen::VectorXd::Zero(mat.cols());
+      for (auto j = 0; j < scaled.outerSize(); j++) {
+        for (Eigen::SparseMatrix<real_t>::InnerIterator it(scaled, j); it;
+             ++it) {
+          row_max(it.row()) = std::max(row_max(it.row()), std::abs(it.value()));
+          col_max(j) = std::max(col_max(j), std::abs(it.value()));
+        }
+      }
+      Rescale(scaled, row_max, col_max);
+    }
+    // Pock-Chambolle (alpha = 1): the 1-norms of the rows and the columns.
+    Eigen::VectorXd row_sum = Eigen::VectorXd::Zero(mat.rows());
+    Eigen::VectorXd col_sum = Eigen::VectorXd::Zero(mat.cols());
+    for (auto j = 0; j < scaled.outerSize(); j++) {
+      for (Eigen::SparseMatrix<real_t>::InnerIterator it(scaled, j); it; ++it) {
+        row_sum(it.row()) += std::abs(it.value());
+        col_sum(j) += std::abs(it.value());
+      }
+    }
+    Rescale(scaled, row_sum, col_sum);
+    A = scaled;
+    At = scaled.transpose();
+
+    // ||A'||_2 by power iteration on A'^T A'.
+    Eigen::VectorXd v = Eigen::VectorXd::Ones(A.cols()), Av, AtAv;
+    real_t norm = 0;
+    for (auto iter = 0; iter < kPowerIterations and v.norm() > 0; iter++) {
+      v.normalize();
+      ParallelMultiply(A, v, Av);
+      ParallelMultiply(At, Av, AtAv);
+      norm = std::sqrt(v.dot(AtAv));
+      v = AtAv;
+    }
+    step_size = norm > 0 ? kStepSizeFraction / norm : 1.0;
+  }
+
+  // Divides the rows and the columns by the square roots of their norms.
+  void Rescale(Eigen::SparseMatrix<real_t>& scaled, const Eigen::VectorXd& row,
+               const Eigen::VectorXd& col) {
+    Eigen::VectorXd r = row, c = col;
+    for (auto i = 0; i < r.size(); i++)
+      r(i) = r(i) > 0 ? 1 / std::sqrt(r(i)) : 1;
+    for (auto j = 0; j < c.size(); j++)
+      c(j) = c(j) > 0 ? 1 / std::sqrt(c(j)) : 1;
+    scaled = r.asDiagonal() * scaled * c.asDiagonal();
+    row_scale = row_scale.cwiseProduct(r);
+    col_scale = col_scale.cwiseProduct(c);
+  }
+
+  struct Iterate {
+    Eigen::VectorXd x, y, Ax, Aty;
+  };
+
+  // The relative residuals of the unscaled problem. With lambda = c - A^T y,
+  //    primal: ||A x - b|| / (1 + ||b||)
+  //    dual:   ||min(lambda, 0)|| / (1 + ||c||)
+  //    gap:    |c^T x - b^T y| / (1 + |c^T x| + |b^T y|)
+  struct Error {
+    real_t primal, dual, gap;
+    real_t Max() const { return std::max(primal, std::max(dual, gap)); }
+  };
+  Error RelativeError(const Eigen::VectorXd& c, const Eigen::VectorXd& b,
+                      const Iterate& z) {
+    Eigen::VectorXd primal = (b - z.Ax).cwiseQuotient(row_scale);
+    Eigen::VectorXd dual =
+        (c - z.Aty).cwiseMin(0.0).cwiseQuotient(col_scale);
+    real_t primal_objective = c.dot(z.x), dual_objective = b.dot(z.y);
+    return {
+        primal.norm() / (1 + b.cwiseQuotient(row_scale).norm()),
+        dual.norm() / (1 + c.cwiseQuotient(col_scale).norm()),
+        std::abs(primal_objective - dual_objective) /
+            (1 + std::abs(primal_objective) + std::abs(dual_objective)),
+    };
+  }
+
+  // The KKT error of the scaled problem in the primal weight norm, which
+  // drives the restarts.
+  real_t KktError(const Eigen::VectorXd& c, const Eigen::VectorXd& b,
+                  const Iterate& z) {
+    real_t primal = (b - z.Ax).norm();
+    real_t dual = (c - z.Aty).cwiseMin(0.0).norm();
+    real_t gap = std::abs(c.dot(z.x) - b.dot(z.y));
+    return std::sqrt(primal_weight * primal_weight * primal * primal +
+                     dual * dual / (primal_weight * primal_weight) +
+                     gap * gap);
+  }
+
+  // Runs PDHG from (x, y) until the relative error is below epsilon, returns
+  // false if it is not within `max_iterations`.
+  bool Run(const Eigen::VectorXd& c, const Eigen::VectorXd& b,
+           Eigen::VectorXd& x, Eigen::VectorXd& y, int max_iterations,
+           real_t epsilon) {
+    if (c.norm() > 0 and b.norm() > 0) primal_weight = c.norm() / b.norm();
+    Iterate current = {x, y, Eigen::VectorXd(), Eigen::VectorXd()};
+    ParallelMultiply(A, current.x, current.Ax);
+    ParallelMultiply(At, current.y, current.Aty);
+    Iterate sum = {Eigen::VectorXd::Zero(x.size()),
+                   Eigen::VectorXd::Zero(y.size()),
+                   Eigen::VectorXd::Zero(b.size()),
+                   Eigen::VectorXd::Zero(c.size())};
+    Iterate last_restart = current;
+    real_t last_restart_error = KktError(c, b, current);
+    real_t last_candidate_error = std::numeric_limits<real_t>::infinity();
+    int averaged = 0, since_restart = 0;
+    Eigen::VectorXd next_x, next_Ax;
+
+    for (int iter = 0; iter < max_iterations; iter++) {
+      real_t tau = step_size / primal_weight, sigma = step_size * primal_weight;
+      next_x = (current.x - tau * (c - current.Aty)).cwiseMax(0.0);
+      ParallelMultiply(A, next_x, next_Ax);
+      current.y += sigma * (b - 2 * next_Ax + current.Ax);
+      current.x.swap(next_x);
+      current.Ax.swap(next_Ax);
+      ParallelMultiply(At, current.y, current.Aty);
+      sum.x += current.x;
+      sum.y += current.y;
+      sum.Ax += current.Ax;
+      sum.Aty += current.Aty;
+      averaged += 1;
+      since_restart += 1;
+      iterations += 1;
+
+      if ((iter + 1) % kRestartCheckFrequency != 0) continue;
+      Iterate average = {sum.x / averaged, sum.y / averaged,
+                         sum.Ax / averaged, sum.Aty / averaged};
+      auto current_error = RelativeError(c, b, current);
+      auto average_error = RelativeError(c, b, average);
+      if (logging and (iter + 1) % (kRestartCheckFrequency * log_every) == 0)
+        std::cout << "iter " << iterations << ", primal residual "
+                  << current_error.primal << ", dual residual "
+                  << current_error.dual << ", gap " << current_error.gap
+                  << ", primal weight " << primal_weight << "\n";
+      if (std::min(current_error.Max(), average_error.Max()) < epsilon) {
+        auto& best =
+            current_error.Max() <= average_error.Max() ? current : average;
+        x = best.x;
+        y = best.y;
+        return true;
+      }
+
+      // Restarts to the better of the current and the average iterates.
+      real_t current_kkt = KktError(c, b, current);
+      real_t average_kkt = KktError(c, b, average);
+      bool to_average = average_kkt < current_kkt;
+      real_t candidate_error = std::min(current_kkt, average_kkt);
+      bool restart =
+          candidate_error <= kSufficientRestartDecay * last_restart_error or
+          (candidate_error <= kNecessaryRestartDecay * last_restart_error and
+           candidate_error > last_candidate_error) or
+          since_restart >= kArtificialRestartFraction * iterations;
+      last_candidate_error = candidate_error;
+      if (!restart) continue;
+      if (to_average) current = average;
+      real_t delta_x = (current.x - last_restart.x).norm();
+      real_t delta_y = (current.y - last_restart.y).norm();
+      if (delta_x > kEpsilonF and delta_y > kEpsilonF)
+        primal_weight =
+            std::exp(kPrimalWeightSmoothing * std::log(delta_y / delta_x) +
+                     (1 - kPrimalWeightSmoothing) * std::log(primal_weight));
+      last_restart = current;
+      last_restart_error = candidate_error;
+      last_candidate_error = std::numeric_limits<real_t>::infinity();
+      sum.x.setZero();
+      sum.y.setZero();
+      sum.Ax.setZero();
+      sum.Aty.setZero();
+      averaged = 0;
+      since_restart = 0;
+    }
+    x = current.x;
+    y = current.y;
+    return false;
+  }
+};
+
+Result LPModel::PrimalDualHybridGradientSolve(Num epsilon) {
+  // The slack variables are columns of A too.
+  auto non_base_variables = non_base_variables_;
+  non_base_variables_.insert(base_variables_.begin(), base_variables_.end());
+  std::vector<Variable> columns(non_base_variables_.begin(),
+                                non_base_variables_.end());
+  // Minimization form.
+  if (model_.opt_obj.opt_type == OptimizationObject::MAX) {
+    model_.opt_obj.SetOptType(OptimizationObject::MIN);
+    model_.opt_obj.expression *= -1.0;
+    opt_reverted_ = !opt_reverted_;
+  }
+  auto matrix_form = ToSparseMatrixForm();
+  non_base_variables_ = non_base_variables;
+
+  PrimalDualHybridGradient pdhg(matrix_form.coefficient_mat);
+  pdhg.logging = enable_logging_;
+  pdhg.log_every = log_every_iters_;
+  Eigen::VectorXd c = pdhg.col_scale.cwiseProduct(matrix_form.cost_vec);
+  Eigen::VectorXd b = pdhg.row_scale.cwiseProduct(matrix_form.bound_vec);
+  Eigen::VectorXd x = Eigen::VectorXd::Zero(c.size());
+  Eigen::VectorXd y = Eigen::VectorXd::Zero(b.size());
+  if (!pdhg.Run(c, b, x, y, kMaxPrimalDualHybridGradientIterations,
+                epsilon.float_value))
+    return ERROR;
+
+  if (enable_feasibility_polishing_) {
+    // Feasibility polishing: the feasibility problems (no objective for the
+    // primal, no right-hand side for the dual) are much easier for PDHG, and
+    // started from the optimal iterates they land close to them.
+    Eigen::VectorXd polished_x = x, polished_y = y;
+    Eigen::VectorXd zero_y = Eigen::VectorXd::Zero(b.size());
+    Eigen::VectorXd zero_x = Eigen::VectorXd::Zero(c.size());
+    real_t tolerance = kPolishingTolerance * epsilon.float_value;
+    pdhg.Run(Eigen::VectorXd::Zero(c.size()), b, polished_x, zero_y,
+             kMaxPolishingIterations, tolerance);
+    pdhg.Run(c, Eigen::VectorXd::Zero(b.size()), zero_x, polished_y,
+             kMaxPolishingIterations, tolerance);
+    PrimalDualHybridGradient::Iterate raw = {x, y, Eigen::VectorXd(),
+                                             Eigen::VectorXd()};
+    PrimalDualHybridGradient::Iterate polished = {
+        polished_x, polished_y, Eigen::VectorXd(), Eigen::VectorXd()};
+    for (auto z : {&raw, &polished}) {
+      ParallelMultiply(pdhg.A, z->x, z->Ax);
+      ParallelMultiply(pdhg.At, z->y, z->Aty);
+    }
+    auto raw_error = pdhg.RelativeError(c, b, raw);
+    auto polished_error = pdhg.RelativeError(c, b, polished);
+    // The polished pair is (nearly) exactly feasible, it is kept unless it
+    // moved too far from the optimal face.
+    if (polished_error.gap < epsilon.float_value and
+        std::max(polished_error.primal, polished_error.dual) <
+            std::max(raw_error.primal, raw_error.dual)) {
+      x = polished_x;
+      y = polished_y;
+    }
+  }
+  if (enable_logging_)
+    std::cout << "PDHG iterations " << pdhg.iterations << "\n";
+
+  x = pdhg.col_scale.cwiseProduct(x);
+  std::map<Variable, Num> all_sol;
+  for (auto i = 0; i < columns.size(); i++) {
+    all_sol[columns[i]] = x(i);
+    if (IsUserDefined(columns[i]) or IsOverriddenAsUserDefined(columns[i]))
+      primal_dual_hybrid_gradient_solution_[columns[i]] = x(i);
+  }
+  for (auto entry : raw_variable_expression_) {
+    auto raw_var = entry.first;
+    auto exp = entry.second;
+    while (exp.variable_coeff.size() > 0) {
+      auto entry = *exp.variable_coeff.begin();
+      ReplaceVariableWithExpression(exp, entry.first, all_sol[entry.first]);
+    }
+    primal_dual_hybrid_gradient_solution_[raw_var] = exp.constant;
+  }
+  primal_dual_hybrid_gradient_optimum_ =
+      matrix_form.cost_vec.dot(x) +
+      model_.opt_obj.expression.constant.float_value;
+  if (opt_reverted_) primal_dual_hybrid_gradient_optimum_ *= -1.0f;
+  return SOLVED;
+}
+
+Num LPModel::GetPrimalDualHybridGradientOptimum() {
+  return primal_dual_hybrid_gradient_optimum_;
+}
+
+std::map<Variable, Num> LPModel::GetPrimalDualHybridGradientSolution() {
+  return primal_dual_hybrid_gradient_solution_;
+}
@@ -116,11 +116,17 @@ Result LPModel::PrimalPathFollowingSolve(
   }
   int variable_num = non_base_variables_.size();
   int constraint_num = model_.constraints.size();
-  auto matrix_form = ToMatrixForm();
-  Eigen::MatrixXd A = matrix_form.coefficient_mat;
+  auto matrix_form = ToSparseMatrixForm();
+  NormalEquationSolver normal_equation(matrix_form.coefficient_mat, 0.0,
+                                       ordering_, normal_equation_method_);
+  if (enable_logging_ and normal_equation_method_ == CHOLESKY)
+    std::cout << normal_equation.GetFillStatistics().ToString()
+              << ", dense columns " << normal_equation.GetDenseColumns().size()
+              << "\n";
+  auto& A = normal_equation.A();
+  auto& At = normal_equation.At();
   Eigen::VectorXd e = Eigen::VectorXd::Ones(variable_num);
   Eigen::VectorXd c = matrix_form.cost_vec;
-  Eigen::MatrixXd I = e.asDiagonal().toDenseMatrix();
   auto x = initial_solution.x;
   auto s = initial_solution.s;
   auto p = initial_solution.p;
@@ -128,20 +134,23 @@ Result LPModel::PrimalPathFollowingSolve(
   real_t mu = initial_solution.mu;
   real_t alpha = initial_solution.alpha;
   while (x.dot(s) >= epsilon) {
-    auto X = x.asDiagonal().toDenseMatrix();
-    auto X_square = X * X;
+    Eigen::VectorXd x_square = x.cwiseProduct(x);
     mu = alpha * mu;
-    auto newton_direction =
-        (I - X_square * A.transpose() *
-                 (A * X_square * A.transpose()).inverse() * A) *
-        (X * e - (1.0 / mu) * X_square * c);
-    auto newton_step = (A * X_square * A.transpose()).inverse() * A *
-                       (X_square * c - mu * X * e);
+    // Both steps solve with A X^2 A^T, factorize it once per iteration:
+    //    d = (I - X^2 A^T (A X^2 A^T)^{-1} A) (X e - X^2 c / mu)
+    //    p = (A X^2 A^T)^{-1} A (X^2 c - mu X e)
+    bool factorized = normal_equation.Factorize(x_square);
+    assert(factorized);
+    Eigen::VectorXd v = x - (1.0 / mu) * x_square.cwiseProduct(c);
+    Eigen::VectorXd newton_direction =
+        v - x_square.cwiseProduct(At * normal_equation.Solve(A * v));
+    Eigen::VectorXd newton_step =
+        normal_equation.Solve(A * (x_square.cwiseProduct(c) - mu * x));
     assert(x.size() == newton_direction.size());
     assert(p.size() == newton_step.size());
     x = x + newton_direction;
     p = newton_step;
-    s = c - A.transpose() * newton_step;
+    s = c - At * newton_step;
   }
   int i = 0;
   for (auto var : non_base_variables_) {
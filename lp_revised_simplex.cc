@@ -1,42 +1,18 @@
 #include "lp.h"
 
 void LPModel::RevisedSimplexPivot(int base_ind, int non_base_ind) {
-  auto FindVar = [](std::set<Variable> vars, int ind) -> Variable {
-    for (auto var : vars) {
-      if (ind == 0) return var;
-      ind -= 1;
-    }
-    return Variable();
-  };
-  Variable base = FindVar(base_variables_, base_ind),
-           non_base = FindVar(non_base_variables_, non_base_ind);
-
-  base_variables_.erase(base);
-  non_base_variables_.erase(non_base);
-  base_variables_.insert(non_base);
-  non_base_variables_.insert(base);
+  std::swap(revised_simplex_matrix_form_.basis[base_ind],
+            revised_simplex_matrix_form_.non_basis[non_base_ind]);
 }
 
 int LPModel::RevisedSimplexFindLeavingVariable(
-    RevisedSimplexMatrixForm matrix_form, int entering_ind) {
-  auto entering_vec = matrix_form.non_basis_coefficient_mat.col(entering_ind);
-  auto d = matrix_form.basis_coefficient_mat.inverse() * entering_vec;
-  auto IsNonPositive = [](Eigen::VectorXd vec) -> bool {
-    for (auto i = 0; i < vec.size(); i++) {
-      if (Num(vec(i)).IsPositive()) return false;
-    }
-    return true;
-  };
-  if (IsNonPositive(d)) {
-    return -1;
-  }
-  auto x = matrix_form.basis_coefficient_mat.inverse() * matrix_form.bound_vec;
+    const Eigen::VectorXd& basic_solution, const Eigen::VectorXd& direction) {
   Num min_val = kFloatMax;
   int leaving_ind = -1;
-  for (auto i = 0; i < d.size(); i++) {
-    if (Num(d(i)).IsPositive()) {
-      if (Num(x(i) / d(i)) < min_val) {
-        min_val = Num(x(i) / d(i));
+  for (auto i = 0; i < direction.size(); i++) {
+    if (Num(direction(i)).IsPositive()) {
+      if (Num(basic_solution(i) / direction(i)) < min_val) {
+        min_val = Num(basic_solution(i) / direction(i));
         leaving_ind = i;
       }
     }
@@ -52,31 +28,61 @@ Result LPModel::RevisedSimplexSolve() {
   if (res == NOSOLUTION) return NOSOLUTION;
   assert(res == SOLVED);
 
+  revised_simplex_matrix_form_ = ToRevisedSimplexMatrixForm();
+  auto& form = revised_simplex_matrix_form_;
+  int constraint_num = form.bound_vec.size();
+  // Writes the basis (kept as column indices during the iterations) back to
+  // the variable sets.
+  auto sync_basis = [&]() {
+    base_variables_.clear();
+    non_base_variables_.clear();
+    for (auto ind : form.basis) base_variables_.insert(form.variables[ind]);
+    for (auto ind : form.non_basis)
+      non_base_variables_.insert(form.variables[ind]);
+  };
+
+  Eigen::SparseMatrix<real_t> basis_mat(constraint_num, constraint_num);
+  Eigen::SparseLU<Eigen::SparseMatrix<real_t>, Eigen::COLAMDOrdering<int>>
+      factorization;
   while (true) {
-    auto matrix_form = ToRevisedSimplexMatrixForm();
+    // Factorize the basis once, all the solves of this iteration reuse it.
+    std::vector<Eigen::Triplet<real_t>> triplets;
+    Eigen::VectorXd basis_cost_vec(constraint_num);
+    for (auto i = 0; i < constraint_num; i++) {
+      for (Eigen::SparseMatrix<real_t>::InnerIterator iter(
+               form.coefficient_mat, form.basis[i]);
+           iter; ++iter) {
+        triplets.emplace_back(iter.row(), i, iter.value());
+      }
+      basis_cost_vec(i) = form.cost_vec(form.basis[i]);
+    }
+    basis_mat.setFromTriplets(triplets.begin(), triplets.end());
+    factorization.compute(basis_mat);
+    assert(factorization.info() == Eigen::Success);
+
+    Eigen::VectorXd x = factorization.solve(form.bound_vec);
     // Derive KKT condition.
-    auto lamda = (matrix_form.basis_coefficient_mat.transpose()).inverse() *
-                 matrix_form.basis_cost_vec;
-    auto s_N = matrix_form.non_basis_cost_vec -
-               matrix_form.non_basis_coefficient_mat.transpose() * lamda;
+    Eigen::VectorXd lamda = factorization.transpose().solve(basis_cost_vec);
 
-    auto IsNonNegative = [](Eigen::VectorXd vec) -> bool {
-      for (auto i = 0; i < vec.size(); i++) {
-        if (Num(vec(i)).IsNegative()) return false;
+    Num min_s_N = kFloatMax;
+    int entering_ind = -1;
+    for (auto i = 0; i < form.non_basis.size(); i++) {
+      auto col = form.non_basis[i];
+      Num s_N = form.cost_vec(col) - form.coefficient_mat.col(col).dot(lamda);
+      if (s_N.IsNegative() and s_N < min_s_N) {
+        min_s_N = s_N;
+        entering_ind = i;
       }
-      return true;
-    };
-    if (IsNonNegative(s_N)) {
-      auto x =
-          matrix_form.basis_coefficient_mat.inverse() * matrix_form.bound_vec;
+    }
+    if (entering_ind < 0) {
+      sync_basis();
       std::map<Variable, Num> all_sol;
-      int i = 0;
-      for (auto var : base_variables_) {
-        all_sol[var] = x[i];
+      for (auto i = 0; i < constraint_num; i++) {
+        auto var = form.variables[form.basis[i]];
+        all_sol[var] = x(i);
         if (IsUserDefined(var) or IsOverriddenAsUserDefined(var)) {
-          revised_simplex_solution_[var] = x[i];
+          revised_simplex_solution_[var] = x(i);
         }
-        i += 1;
       }
       for (auto var : non_base_variables_) {
         all_sol[var] = kFloatZero;
@@ -93,23 +99,17 @@ Result LPModel::RevisedSimplexSolve() {
         }
         revised_simplex_solution_[raw_var] = exp.constant;
       }
-      revised_simplex_optimum_ = x.dot(matrix_form.basis_cost_vec) +
-                                 model_.opt_obj.expression.constant;
+      revised_simplex_optimum_ =
+          x.dot(basis_cost_vec) + model_.opt_obj.expression.constant;
       if (opt_reverted_) revised_simplex_optimum_ *= -1;
       return SOLVED;
     }
-    Num min_s_N = kFloatMax;
-    int entering_ind = -1;
-    for (auto i = 0; i < s_N.size(); i++) {
-      if (Num(s_N(i)).IsNegative() and Num(s_N(i)) < min_s_N) {
-        min_s_N = Num(s_N(i));
-        entering_ind = i;
-      }
-    }
-    assert(entering_ind >= 0);
-    auto leaving_ind =
-        RevisedSimplexFindLeavingVariable(matrix_form, entering_ind);
+    Eigen::VectorXd entering_vec =
+        form.coefficient_mat.col(form.non_basis[entering_ind]);
+    Eigen::VectorXd d = factorization.solve(entering_vec);
+    auto leaving_ind = RevisedSimplexFindLeavingVariable(x, d);
     if (leaving_ind < 0) {
+      sync_basis();
       return UNBOUNDED;
     }
     RevisedSimplexPivot(leaving_ind, entering_ind);
@@ -121,4 +121,4 @@ Num LPModel::GetRevisedSimplexOptimum() { return revised_simplex_optimum_; }
 
 std::map<Variable, Num> LPModel::GetRevisedSimplexSolution() {
   return revised_simplex_solution_;
-}
\ No newline at end of file
+}
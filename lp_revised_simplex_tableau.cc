@@ -14,25 +14,40 @@ bool needTableauRevisedInitialization(Tableau<real_t>* tableau,
   return false;
 }
 
+/* Computes B^{-1} (recall B = -T_B) from a sparse LU factorization of B^T with
+ * the column approximate minimum degree ordering: the i-th column of B^{-T} is
+ * the i-th row of B^{-1}, so the rows are solved for one at a time and B is
+ * never densified.
+ */
 Tableau<real_t>* BasisInverse(Tableau<real_t>* tableau,
                               tableau_index_t* basis_indices,
                               tableau_size_t basis_number) {
   assert(tableau->StorageFormat() == COLUMN_ONLY);
-  Eigen::MatrixXd basis_mat = Eigen::MatrixXd::Zero(basis_number, basis_number);
+  std::vector<Eigen::Triplet<real_t>> triplets;
   for (auto i = 0; i < basis_number; i++) {
     for (auto iter = tableau->Col(basis_indices[i])->Begin(); !iter->IsEnd();
          iter = iter->Next()) {
-      basis_mat(iter->Index(), i) = -iter->Data();
+      if (iter->Data() == 0) continue;
+      triplets.push_back({i, (int)iter->Index(), -iter->Data()});
     }
   }
-  auto inverse = basis_mat.inverse();
+  Eigen::SparseMatrix<real_t> basis_transpose(basis_number, basis_number);
+  basis_transpose.setFromTriplets(triplets.begin(), triplets.end());
+  Eigen::SparseLU<Eigen::SparseMatrix<real_t>, Eigen::COLAMDOrdering<int>> lu;
+  lu.compute(basis_transpose);
+  assert(lu.info() == Eigen::Success);
+
   Tableau<real_t>* ret =
       new Tableau<real_t>(basis_number, basis_number, ROW_ONLY);
+  Eigen::VectorXd unit = Eigen::VectorXd::Zero(basis_number);
   for (auto i = 0; i < basis_number; i++) {
+    unit(i) = 1;
+    Eigen::VectorXd inverse_row = lu.solve(unit);
+    unit(i) = 0;
     List<real_t>* row = new List<real_t>();
     for (auto j = 0; j < basis_number; j++) {
-      if (_IsZero(inverse(i, j))) continue;
-      row->Append(j, inverse(i, j));
+      if (_IsZero(inverse_row(j))) continue;
+      row->Append(j, inverse_row(j));
     }
     ret->AppendRow(i, row);
   }
@@ -61,6 +76,109 @@ void LPModel::TableauRevisedSimplexPivot(tableau_index_t leaving_basis,
   basis_inverse->Add(helper_tableau);
 }
 
+real_t LPModel::TableauUpperBound(tableau_index_t col) {
+  if (col >= tableau_upper_bound_.size())
+    return std::numeric_limits<real_t>::infinity();
+  return tableau_upper_bound_[col];
+}
+
+bool LPModel::TableauAtUpperBound(tableau_index_t col) {
+  return col < tableau_at_upper_bound_.size() and tableau_at_upper_bound_[col];
+}
+
+// x_B = B^{-1} (b + A_U u_U), where U are the non-base columns at their upper
+// bounds (recall the tableau stores -A).
+void LPModel::TableauRevisedSimplexComputeBasicSolution() {
+  tableau_size_t basis_number = base_variables_.size();
+  auto constant = new List<real_t>(tableau_->Col(constant_index_));
+  for (auto col = 0; col < tableau_at_upper_bound_.size(); col++) {
+    if (!tableau_at_upper_bound_[col]) continue;
+    constant->AddScaled(tableau_->Col(col), tableau_upper_bound_[col], true);
+  }
+  auto solution = basis_inverse->Times(constant);
+  for (auto i = 0; i < basis_number; i++)
+    basic_feasible_solution->Set(i, solution->At(i));
+  delete solution;
+  delete constant;
+}
+
+void LPModel::TableauRevisedSimplexRefactorize() {
+  tableau_size_t basis_number = base_variables_.size();
+  if (basis_inverse != nullptr) delete basis_inverse;
+  basis_inverse = BasisInverse(tableau_, basis_indices, basis_number);
+  // Recomputed to get rid of the error accumulated by the incremental updates.
+  TableauRevisedSimplexComputeBasicSolution();
+}
+
+void LPModel::TableauRevisedSimplexComputePricing() {
+  if (simplex_multipliers != nullptr) delete simplex_multipliers;
+  if (reduced_costs != nullptr) delete reduced_costs;
+  simplex_multipliers = basis_inverse->SumScaledRows(basis_coeff);
+  reduced_costs = new List<real_t>(opt_obj_tableau_);
+  auto priced = tableau_->SumScaledRows(simplex_multipliers);
+  reduced_costs->Add(priced);
+  delete priced;
+}
+
+void LPModel::TableauRevisedSimplexBuildRowWiseTableau() {
+  if (row_wise_tableau != nullptr) delete row_wise_tableau;
+  row_wise_tableau =
+      new Tableau<real_t>(tableau_->Rows(), tableau_->Cols(), ROW_ONLY);
+  std::vector<List<real_t>*> rows(tableau_->Rows());
+  for (auto& row : rows) row = new List<real_t>();
+  for (auto col = 0; col < tableau_->Cols(); col++) {
+    for (auto iter = tableau_->Col(col)->Begin(); !iter->IsEnd();
+         iter = iter->Next()) {
+      if (_IsZero(iter->Data())) continue;
+      rows[iter->Index()]->Append(col, iter->Data());
+    }
+  }
+  for (auto i = 0; i < tableau_->Rows(); i++)
+    row_wise_tableau->AppendRow(i, rows[i]);
+}
+
+/* Computes rho^T A. The column-wise PRICE takes a dot product with every
+ * column of A, while the row-wise PRICE only accumulates the rows of A where
+ * rho is non-zero, which is much cheaper when rho is sparse.
+ */
+List<real_t>* LPModel::TableauRevisedSimplexPriceRow(List<real_t>* rho) {
+  tableau_size_t rho_nonzeros = 0;
+  for (auto iter = rho->Begin(); !iter->IsEnd(); iter = iter->Next()) {
+    if (!_IsZero(iter->Data())) rho_nonzeros++;
+  }
+  if (rho_nonzeros >= row_wise_price_density_ * tableau_->Rows())
+    return tableau_->SumScaledRows(rho);
+
+  auto pivot_row = new List<real_t>(tableau_->Cols(), DENSE);
+  for (auto iter = rho->Begin(); !iter->IsEnd(); iter = iter->Next()) {
+    if (_IsZero(iter->Data())) continue;
+    pivot_row->AddScaled(row_wise_tableau->Row(iter->Index()), iter->Data(),
+                         true);
+  }
+  return pivot_row;
+}
+
+/* Updates the simplex multipliers and the reduced costs for the pivot
+ * (leaving_basis, entering_basis) from the pivot row alpha_r = rho_r^T A, where
+ * rho_r is the row of B^{-1} of the leaving basis. Must be called before the
+ * basis inverse is updated:
+ *    p' = p + theta * rho_r
+ *    d' = d + theta * rho_r^T A, where theta = -d_q / mu_r
+ * The pivot row is priced here unless the caller already has it.
+ */
+void LPModel::TableauRevisedSimplexUpdatePricing(
+    tableau_index_t leaving_basis, tableau_index_t entering_basis,
+    List<real_t>* mu, List<real_t>* pivot_row) {
+  real_t theta = -reduced_costs->At(entering_basis) / mu->At(leaving_basis);
+  auto rho = basis_inverse->Row(leaving_basis);
+  bool priced = pivot_row == nullptr;
+  if (priced) pivot_row = TableauRevisedSimplexPriceRow(rho);
+  simplex_multipliers->AddScaled(rho, theta, true);
+  reduced_costs->AddScaled(pivot_row, theta, true);
+  reduced_costs->Set(entering_basis, 0);
+  if (priced) delete pivot_row;
+}
+
 void LPModel::TableauRevisedSimplexRemoveRedundantConstraint(
     tableau_index_t leaving_basis) {
   tableau_size_t basis_number = base_variables_.size();
@@ -89,9 +207,115 @@ void LPModel::TableauRevisedSimplexRemoveRedundantConstraint(
   }
 }
 
+void LPModel::TableauRevisedSimplexSetupBasis() {
+  tableau_size_t basis_number = base_variables_.size();
+  assert(basis_number == tableau_->Rows());
+  basic_feasible_solution = new List<real_t>(basis_number, DENSE);
+  basis_coeff = new List<real_t>(basis_number, DENSE);
+  basis_indices = new tableau_index_t[basis_number];
+  int i = 0;
+  for (auto var : base_variables_) {
+    basis_indices[i] = variable_to_index_[var];
+    basis_coeff->Set(i, opt_obj_tableau_->At(basis_indices[i]));
+    i++;
+  }
+  basis_inverse = BasisInverse(tableau_, basis_indices, basis_number);
+  TableauRevisedSimplexComputeBasicSolution();
+}
+
+/* A triangular crash basis (Bixby, 1992). Scans the structural columns from the
+ * sparsest one, and makes a column basic in one of the infeasible rows if:
+ *    1. it has no entry in the rows already taken by the crash, which keeps the
+ *       crash basis triangular (hence non-singular);
+ *    2. its entry in the row is large enough, and gives it a positive value;
+ *    3. it does not make any feasible row infeasible.
+ * Returns the column taken by each row (-1 if none), `residual` is set to
+ * b - A x, where x is the crash solution.
+ */
+std::vector<tableau_index_t> LPModel::TableauRevisedSimplexCrash(
+    std::vector<real_t>& residual) {
+  tableau_size_t rows = tableau_->Rows();
+  residual.assign(rows, 0);
+  for (auto iter = tableau_->Col(constant_index_)->Begin(); !iter->IsEnd();
+       iter = iter->Next())
+    residual[iter->Index()] = iter->Data();
+  std::vector<tableau_index_t> crash(rows, -1);
+  if (!enable_crash_basis_) return crash;
+
+  std::vector<tableau_index_t> candidates;
+  std::vector<tableau_size_t> nonzeros(constant_index_, 0);
+  for (auto col = 0; col < constant_index_; col++) {
+    if (tableau_is_base_variable_[col]) continue;
+    for (auto iter = tableau_->Col(col)->Begin(); !iter->IsEnd();
+         iter = iter->Next())
+      if (!_IsZero(iter->Data())) nonzeros[col]++;
+    if (nonzeros[col] > 0) candidates.push_back(col);
+  }
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [&](tableau_index_t a, tableau_index_t b) {
+                     return nonzeros[a] < nonzeros[b];
+                   });
+
+  // Note the tableau stores -A, so the row i reads
+  // b_i + sum_j T_{i, j} x_j = x_{base_i}.
+  for (auto col : candidates) {
+    tableau_index_t pivot_row = -1;
+    real_t pivot = 0, max_abs = 0;
+    bool triangular = true;
+    for (auto iter = tableau_->Col(col)->Begin(); !iter->IsEnd();
+         iter = iter->Next()) {
+      if (_IsZero(iter->Data())) continue;
+      if (crash[iter->Index()] >= 0) {
+        triangular = false;
+        break;
+      }
+      max_abs = std::max(max_abs, std::abs(iter->Data()));
+      if (_IsNegative(residual[iter->Index()]) and
+          _IsPositive(iter->Data()) and iter->Data() > pivot) {
+        pivot_row = iter->Index();
+        pivot = iter->Data();
+      }
+    }
+    if (!triangular or pivot_row < 0) continue;
+    if (pivot < kCrashPivotTolerance * max_abs) continue;
+
+    real_t value = -residual[pivot_row] / pivot;
+    bool keeps_feasibility = true;
+    for (auto iter = tableau_->Col(col)->Begin(); !iter->IsEnd();
+         iter = iter->Next()) {
+      if (iter->Index() == pivot_row) continue;
+      if (_IsNonNegative(residual[iter->Index()]) and
+          _IsNegative(residual[iter->Index()] + iter->Data() * value)) {
+        keeps_feasibility = false;
+        break;
+      }
+    }
+    if (!keeps_feasibility) continue;
+
+    for (auto iter = tableau_->Col(col)->Begin(); !iter->IsEnd();
+         iter = iter->Next())
+      residual[iter->Index()] += iter->Data() * value;
+    residual[pivot_row] = 0;
+    crash[pivot_row] = col;
+  }
+  return crash;
+}
+
 Result LPModel::TableauRevisedSimplexInitialize() {
   if (!needTableauRevisedInitialization(tableau_, constant_index_))
     return SOLVED;
+  std::vector<real_t> residual;
+  auto crash = TableauRevisedSimplexCrash(residual);
+  std::vector<Variable> slack_of_row(tableau_->Rows());
+  for (auto var : base_variables_) {
+    for (auto iter = tableau_->Col(variable_to_index_[var])->Begin();
+         !iter->IsEnd(); iter = iter->Next()) {
+      if (_IsZero(iter->Data())) continue;
+      slack_of_row[iter->Index()] = var;
+      break;
+    }
+  }
+
   std::vector<tableau_index_t> negative_bound_ind;
   for (auto iter = tableau_->Col(constant_index_)->Begin(); !iter->IsEnd();
        iter = iter->Next()) {
@@ -114,17 +338,40 @@ Result LPModel::TableauRevisedSimplexInitialize() {
   }
   assert(!needTableauRevisedInitialization(tableau_, constant_index_));
 
-  auto raw_opt = opt_obj_tableau_;
-  auto raw_opt_reverted = opt_reverted_;
-  opt_obj_tableau_ = new List<real_t>();
+  // The crash columns are basic in their rows, the slack variables in the rows
+  // the crash solution satisfies, and artificial variables in the rest.
   non_base_variables_.insert(base_variables_.begin(), base_variables_.end());
   base_variables_.clear();
-  if (tableau_is_base_variable_ != nullptr) delete tableau_is_base_variable_;
-  tableau_is_base_variable_ =
-      new bool[non_base_variables_.size() + 1 + tableau_->Rows()];
+  if (tableau_is_base_variable_ != nullptr) delete[] tableau_is_base_variable_;
+  tableau_is_base_variable_ = new bool[tableau_->Cols() + tableau_->Rows()];
   std::memset(tableau_is_base_variable_, 0,
-              sizeof(bool) * non_base_variables_.size() + 1 + tableau_->Rows());
-  for (auto i = 0; i < tableau_->Rows(); i++) {
+              sizeof(bool) * (tableau_->Cols() + tableau_->Rows()));
+  std::vector<tableau_index_t> artificial_rows;
+  for (auto row = 0; row < tableau_->Rows(); row++) {
+    Variable basic;
+    if (crash[row] >= 0) {
+      basic = index_to_variable_[crash[row]];
+    } else if (_IsNonNegative(residual[row])) {
+      basic = slack_of_row[row];
+    } else {
+      artificial_rows.push_back(row);
+      continue;
+    }
+    assert(!basic.IsUndefined());
+    non_base_variables_.erase(basic);
+    base_variables_.insert(basic);
+    tableau_is_base_variable_[variable_to_index_[basic]] = true;
+  }
+  if (artificial_rows.empty()) {
+    // The crash basis is already feasible, no phase 1 needed.
+    TableauRevisedSimplexSetupBasis();
+    return SOLVED;
+  }
+
+  auto raw_opt = opt_obj_tableau_;
+  auto raw_opt_reverted = opt_reverted_;
+  opt_obj_tableau_ = new List<real_t>();
+  for (auto row : artificial_rows) {
     Variable artificial = CreateArtificialVariable();
     opt_obj_tableau_->Append(tableau_->Cols(), -1);
     variable_to_index_[artificial] = tableau_->Cols();
@@ -132,7 +379,7 @@ Result LPModel::TableauRevisedSimplexInitialize() {
     tableau_is_base_variable_[tableau_->Cols()] = true;
     base_variables_.insert(artificial);
     List<real_t>* col = new List<real_t>();
-    col->Append(i, -1);
+    col->Append(row, -1);
     tableau_->AppendExtraCol(col);
   }
 
@@ -143,15 +390,11 @@ Result LPModel::TableauRevisedSimplexInitialize() {
 
   tableau_size_t basis_number = base_variables_.size();
   for (auto i = 0; i < basis_number; i++) {
-    if (basis_indices[i] >= non_base_variables_.size()) {
+    if (basis_indices[i] > constant_index_) {
       // It is an artificial var.
       bool pivoted = false;
-      for (auto col = 0; col < tableau_->Cols(); col++) {
-        if (col == constant_index_) continue;
+      for (auto col = 0; col < constant_index_; col++) {
         if (tableau_is_base_variable_[col]) continue;
-        if (base_variables_.find(index_to_variable_[col]) !=
-            base_variables_.end())
-          continue;
         auto probing = basis_inverse->Times(tableau_->Col(col));
         if (!_IsZero(probing->At(i))) {
           pivoted = true;
@@ -168,7 +411,7 @@ Result LPModel::TableauRevisedSimplexInitialize() {
       /* if (!pivoted) TableauRevisedSimplexRemoveRedundantConstraint(i); */
     }
   }
-  for (auto i = 0; i < basis_number; i++) tableau_->RemoveExtraCol();
+  for (auto i = 0; i < artificial_rows.size(); i++) tableau_->RemoveExtraCol();
 
   non_base_variables_.clear();
   base_variables_.clear();
@@ -198,109 +441,144 @@ Result LPModel::TableauRevisedSimplexInitialize() {
 
 Result LPModel::TableauRevisedSimplexSolve() {
   assert(model_.opt_obj.opt_type == OptimizationObject::MAX);
+  // Phase 1 does not handle boxed variables.
+  assert(tableau_upper_bound_.empty());
   opt_obj_tableau_->Scale(-1.0);
   opt_reverted_ = !opt_reverted_;
 
-  tableau_size_t basis_number = base_variables_.size();
-
   if (needTableauRevisedInitialization(tableau_, constant_index_)) {
     auto result = TableauRevisedSimplexInitialize();
     if (result == NOSOLUTION) return NOSOLUTION;
     assert(result == SOLVED);
   } else {
-    assert(base_variables_.size() == tableau_->Rows());
-    basic_feasible_solution = new List<real_t>(basis_number, DENSE);
-    basis_coeff = new List<real_t>(basis_number, DENSE);
-    basis_indices = new tableau_index_t[basis_number];
-    int i = 0;
-    for (auto var : base_variables_) {
-      basis_indices[i] = variable_to_index_[var];
-      basis_coeff->Set(i, opt_obj_tableau_->At(basis_indices[i]));
-      bool initialized = false;
-      for (auto iter = tableau_->Col(basis_indices[i])->Begin(); !iter->IsEnd();
-           iter = iter->Next()) {
-        if (!_IsZero(iter->Data())) {
-          basic_feasible_solution->Set(
-              i, tableau_->Col(constant_index_)->At(iter->Index()) /
-                     (-iter->Data()));
-          initialized = true;
-          break;
-        }
-      }
-      assert(initialized);
-      i++;
-    }
-    basis_inverse = BasisInverse(tableau_, basis_indices, basis_number);
+    TableauRevisedSimplexSetupBasis();
   }
+  TableauRevisedSimplexBuildRowWiseTableau();
+  TableauRevisedSimplexComputePricing();
+  auto result = TableauRevisedSimplexIterate();
+  if (result != SOLVED) return result;
+  TableauRevisedSimplexExtractSolution(revised_simplex_optimum_,
+                                       revised_simplex_solution_);
+  return SOLVED;
+}
+
+/* The main step of the revised simplex method, starting from a primal feasible
+ * basis whose multipliers and reduced costs are already computed. A non-base
+ * variable with a finite upper bound may sit at either bound, it enters the
+ * basis by moving away from the bound it sits at, and may just move to the
+ * other bound when it is the first to block (a bound flip).
+ */
+Result LPModel::TableauRevisedSimplexIterate() {
+  int iter = 0;
   while (true) {
-    List<real_t>* p = basis_inverse->SumScaledRows(basis_coeff);
-    List<real_t>* cost = new List<real_t>(opt_obj_tableau_);
-    cost->Add(tableau_->SumScaledRows(p));
+    if (iter > 0 and iter % refactorization_frequency_ == 0) {
+      TableauRevisedSimplexRefactorize();
+      TableauRevisedSimplexComputePricing();
+    }
+    iter += 1;
 
     tableau_index_t entering_non_basis = -1;
-    real_t min_cost = std::numeric_limits<real_t>::max();
-    for (auto i = 0; i < cost->Size(); i++) {
+    real_t max_cost = 0;
+    for (auto i = 0; i < reduced_costs->Size(); i++) {
       if (i == constant_index_) continue;
       if (tableau_is_base_variable_[i]) continue;
-      real_t cost_ = cost->At(i);
-      if (_IsNonNegative(cost_)) continue;
-      if (min_cost > cost_) {
-        min_cost = cost_;
+      real_t cost_ = reduced_costs->At(i);
+      if (TableauAtUpperBound(i) ? !_IsPositive(cost_) : _IsNonNegative(cost_))
+        continue;
+      if (max_cost < std::abs(cost_)) {
+        max_cost = std::abs(cost_);
         entering_non_basis = i;
       }
     }
-    if (entering_non_basis < 0) {
-      revised_simplex_optimum_ = opt_obj_tableau_->At(constant_index_);
-      for (auto i = 0; i < basis_number; i++)
-        revised_simplex_optimum_ += opt_obj_tableau_->At(basis_indices[i]) *
-                                    basic_feasible_solution->At(i);
-      if (opt_reverted_) revised_simplex_optimum_ *= -1;
-
-      std::map<Variable, Num> all_sol;
-      for (auto entry : variable_to_index_) all_sol[entry.first] = 0.0f;
-      for (auto i = 0; i < basis_number; i++)
-        all_sol[index_to_variable_[basis_indices[i]]] =
-            basic_feasible_solution->At(i);
-      for (auto entry : variable_to_index_)
-        if (IsUserDefined(entry.first) or
-            IsOverriddenAsUserDefined(entry.first))
-          revised_simplex_solution_[entry.first] = all_sol[entry.first];
-
-      for (auto entry : raw_variable_expression_) {
-        auto raw_var = entry.first;
-        auto exp = entry.second;
-        while (exp.variable_coeff.size() > 0) {
-          auto entry = *exp.variable_coeff.begin();
-          ReplaceVariableWithExpression(exp, entry.first, all_sol[entry.first]);
-        }
-        revised_simplex_solution_[raw_var] = exp.constant;
-      }
-      return SOLVED;
-    }
+    if (entering_non_basis < 0) return SOLVED;
+    tableau_simplex_pivots_ += 1;
+    bool entering_at_upper = TableauAtUpperBound(entering_non_basis);
+    real_t direction = entering_at_upper ? -1 : 1;
     List<real_t>* mu = basis_inverse->Times(tableau_->Col(entering_non_basis));
 
     tableau_index_t leaving_basis = -1;
-    real_t min_ratio = std::numeric_limits<real_t>::max();
+    bool leaving_to_upper = false;
+    real_t min_ratio = TableauUpperBound(entering_non_basis);
     for (auto iter = mu->Begin(); !iter->IsEnd(); iter = iter->Next()) {
-      if (_IsNegative(iter->Data()) and
-          -(basic_feasible_solution->At(iter->Index()) / iter->Data()) <
-              min_ratio) {
-        min_ratio = -basic_feasible_solution->At(iter->Index()) / iter->Data();
+      real_t rate = direction * iter->Data();
+      real_t value = basic_feasible_solution->At(iter->Index());
+      if (_IsNegative(rate) and -(value / rate) < min_ratio) {
+        min_ratio = -value / rate;
+        leaving_basis = iter->Index();
+        leaving_to_upper = false;
+      }
+      real_t upper = TableauUpperBound(basis_indices[iter->Index()]);
+      if (_IsPositive(rate) and (upper - value) / rate < min_ratio) {
+        min_ratio = (upper - value) / rate;
         leaving_basis = iter->Index();
+        leaving_to_upper = true;
       }
     }
 
     if (leaving_basis < 0) {
-      // TODO
-      return UNBOUNDED;
+      if (min_ratio == std::numeric_limits<real_t>::infinity()) {
+        // TODO
+        delete mu;
+        return UNBOUNDED;
+      }
+      // The entering variable reaches its other bound first.
+      basic_feasible_solution->AddScaled(mu, direction * min_ratio, true);
+      tableau_at_upper_bound_[entering_non_basis] = !entering_at_upper;
+      delete mu;
+      continue;
     }
 
+    real_t entering_value = (entering_at_upper
+                                 ? TableauUpperBound(entering_non_basis)
+                                 : 0) +
+                            direction * min_ratio;
+    tableau_index_t leaving_col = basis_indices[leaving_basis];
+    TableauRevisedSimplexUpdatePricing(leaving_basis, entering_non_basis, mu);
     TableauRevisedSimplexPivot(leaving_basis, entering_non_basis, mu,
-                               min_ratio);
+                               direction * min_ratio);
+    basic_feasible_solution->Set(leaving_basis, entering_value);
+    if (entering_at_upper) tableau_at_upper_bound_[entering_non_basis] = false;
+    if (leaving_to_upper) tableau_at_upper_bound_[leaving_col] = true;
+    delete mu;
   }
   return ERROR;
 }
 
+void LPModel::TableauRevisedSimplexExtractSolution(
+    Num& optimum, std::map<Variable, Num>& solution) {
+  tableau_size_t basis_number = base_variables_.size();
+  optimum = opt_obj_tableau_->At(constant_index_);
+  for (auto i = 0; i < basis_number; i++)
+    optimum += opt_obj_tableau_->At(basis_indices[i]) *
+               basic_feasible_solution->At(i);
+  for (auto col = 0; col < tableau_at_upper_bound_.size(); col++)
+    if (tableau_at_upper_bound_[col])
+      optimum += opt_obj_tableau_->At(col) * tableau_upper_bound_[col];
+  if (opt_reverted_) optimum *= -1;
+
+  std::map<Variable, Num> all_sol;
+  for (auto entry : variable_to_index_)
+    all_sol[entry.first] = TableauAtUpperBound(entry.second)
+                               ? TableauUpperBound(entry.second)
+                               : 0.0f;
+  for (auto i = 0; i < basis_number; i++)
+    all_sol[index_to_variable_[basis_indices[i]]] =
+        basic_feasible_solution->At(i);
+  for (auto entry : variable_to_index_)
+    if (IsUserDefined(entry.first) or IsOverriddenAsUserDefined(entry.first))
+      solution[entry.first] = all_sol[entry.first];
+
+  for (auto entry : raw_variable_expression_) {
+    auto raw_var = entry.first;
+    auto exp = entry.second;
+    while (exp.variable_coeff.size() > 0) {
+      auto entry = *exp.variable_coeff.begin();
+      ReplaceVariableWithExpression(exp, entry.first, all_sol[entry.first]);
+    }
+    solution[raw_var] = exp.constant;
+  }
+}
+
 Num LPModel::GetTableauRevisedSimplexOptimum() {
   return revised_simplex_optimum_;
 }
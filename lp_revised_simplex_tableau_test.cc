@@ -96,3 +96,79 @@ TEST(LPModel, TableauRevisedSimplexSolve4) {
     EXPECT_GE(actual_sol[entry.first] - entry.second, -kEpsilon);
   }
 }
+
+TEST(LPModel, TableauRevisedSimplexIncrementalPricing) {
+  // The incrementally updated reduced costs must lead to the same optimum as
+  // recomputing them from scratch at every pivot.
+  Parser parser;
+  std::ifstream file("tests/test15.txt");
+  Model raw_model = parser.Parse(file);
+  LPModel incremental(raw_model), refactorized(raw_model);
+  incremental.ToStandardForm();
+  incremental.ToSlackForm();
+  incremental.ToTableau(COLUMN_ONLY);
+  refactorized.SetRefactorizationFrequency(1);
+  refactorized.ToStandardForm();
+  refactorized.ToSlackForm();
+  refactorized.ToTableau(COLUMN_ONLY);
+
+  EXPECT_EQ(incremental.TableauRevisedSimplexSolve(), Result::SOLVED);
+  EXPECT_EQ(refactorized.TableauRevisedSimplexSolve(), Result::SOLVED);
+
+  EXPECT_LE(incremental.GetTableauRevisedSimplexOptimum() - 26113.5f, 1e-2f);
+  EXPECT_GE(incremental.GetTableauRevisedSimplexOptimum() - 26113.5f, -1e-2f);
+  EXPECT_LE(refactorized.GetTableauRevisedSimplexOptimum() -
+                incremental.GetTableauRevisedSimplexOptimum(),
+            1e-2f);
+  EXPECT_GE(refactorized.GetTableauRevisedSimplexOptimum() -
+                incremental.GetTableauRevisedSimplexOptimum(),
+            -1e-2f);
+}
+
+TEST(LPModel, TableauRevisedSimplexRowWisePrice) {
+  // Always pricing row-wise and always pricing column-wise must reach the
+  // same optimum.
+  Parser parser;
+  std::ifstream file("tests/test17.txt");
+  Model raw_model = parser.Parse(file);
+  LPModel row_wise(raw_model), column_wise(raw_model);
+  row_wise.SetRowWisePriceDensity(2.0);
+  row_wise.ToStandardForm();
+  row_wise.ToSlackForm();
+  row_wise.ToTableau(COLUMN_ONLY);
+  column_wise.SetRowWisePriceDensity(0.0);
+  column_wise.ToStandardForm();
+  column_wise.ToSlackForm();
+  column_wise.ToTableau(COLUMN_ONLY);
+
+  EXPECT_EQ(row_wise.TableauRevisedSimplexSolve(), Result::SOLVED);
+  EXPECT_EQ(column_wise.TableauRevisedSimplexSolve(), Result::SOLVED);
+
+  EXPECT_LE(row_wise.GetTableauRevisedSimplexOptimum() - 150.0f, 1e-3f);
+  EXPECT_GE(row_wise.GetTableauRevisedSimplexOptimum() - 150.0f, -1e-3f);
+  EXPECT_LE(column_wise.GetTableauRevisedSimplexOptimum() - 150.0f, 1e-3f);
+  EXPECT_GE(column_wise.GetTableauRevisedSimplexOptimum() - 150.0f, -1e-3f);
+}
+
+TEST(LPModel, TableauRevisedSimplexCrashBasis) {
+  // Starting phase 1 from the crash basis must not change the optimum.
+  Parser parser;
+  std::ifstream file("tests/test15.txt");
+  Model raw_model = parser.Parse(file);
+  LPModel crash(raw_model), no_crash(raw_model);
+  crash.ToStandardForm();
+  crash.ToSlackForm();
+  crash.ToTableau(COLUMN_ONLY);
+  no_crash.SetEnableCrashBasis(false);
+  no_crash.ToStandardForm();
+  no_crash.ToSlackForm();
+  no_crash.ToTableau(COLUMN_ONLY);
+
+  EXPECT_EQ(crash.TableauRevisedSimplexSolve(), Result::SOLVED);
+  EXPECT_EQ(no_crash.TableauRevisedSimplexSolve(), Result::SOLVED);
+
+  EXPECT_LE(crash.GetTableauRevisedSimplexOptimum() - 26113.5f, 1e-3f);
+  EXPECT_GE(crash.GetTableauRevisedSimplexOptimum() - 26113.5f, -1e-3f);
+  EXPECT_LE(no_crash.GetTableauRevisedSimplexOptimum() - 26113.5f, 1e-3f);
+  EXPECT_GE(no_crash.GetTableauRevisedSimplexOptimum() - 26113.5f, -1e-3f);
+}
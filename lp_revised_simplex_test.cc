@@ -91,4 +91,17 @@ TEST(LPModel, RevisedSimplexSolve4) {
     EXPECT_LE(actual_sol[entry.first] - entry.second, kEpsilon);
     EXPECT_GE(actual_sol[entry.first] - entry.second, -kEpsilon);
   }
-}
\ No newline at end of file
+}
+
+TEST(LPModel, RevisedSimplexSolve5) {
+  Parser parser;
+  std::ifstream file("tests/test15.txt");
+  LPModel model = parser.Parse(file);
+  model.ToStandardForm();
+  model.ToSlackForm();
+
+  EXPECT_EQ(model.RevisedSimplexSolve(), Result::SOLVED);
+
+  EXPECT_LE(model.GetRevisedSimplexOptimum() - 26113.5f, 1e-2f);
+  EXPECT_GE(model.GetRevisedSimplexOptimum() - 26113.5f, -1e-2f);
+}
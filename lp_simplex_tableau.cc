@@ -61,9 +61,75 @@ bool needTableauInitialization(Tableau<real_t>* tableau,
   return false;
 }
 
+void LPModel::TableauSimplexCrash() {
+  if (!enable_crash_basis_) return;
+  for (auto row = 0; row < tableau_->Rows(); row++) {
+    real_t constant = tableau_->Row(row)->At(constant_index_);
+    if (!_IsNegative(constant)) continue;
+
+    Variable base;
+    for (auto iter = tableau_->Row(row)->Begin(); !iter->IsEnd();
+         iter = iter->Next()) {
+      if (iter->Index() == constant_index_) continue;
+      if (_IsZero(iter->Data())) continue;
+      if (tableau_is_base_variable_[iter->Index()]) {
+        base = index_to_variable_[iter->Index()];
+        break;
+      }
+    }
+    assert(!base.IsUndefined());
+
+    // x_{base} = b_{row} + A_{row, j} * x_{j}, so a non-base variable x_{j}
+    // with A_{row, j} > 0 can take the row to zero with a positive value.
+    // Prefer sparse columns, then large pivots.
+    tableau_index_t entering_index = -1;
+    tableau_size_t entering_nonzeros = std::numeric_limits<tableau_size_t>::max();
+    real_t entering_pivot = 0;
+    for (auto iter = tableau_->Row(row)->Begin(); !iter->IsEnd();
+         iter = iter->Next()) {
+      auto col = iter->Index();
+      if (col == constant_index_) continue;
+      if (tableau_is_base_variable_[col]) continue;
+      if (!_IsPositive(iter->Data())) continue;
+
+      real_t value = -constant / iter->Data();
+      real_t max_abs = 0;
+      tableau_size_t nonzeros = 0;
+      bool keeps_feasibility = true;
+      for (auto col_iter = tableau_->Col(col)->Begin(); !col_iter->IsEnd();
+           col_iter = col_iter->Next()) {
+        if (_IsZero(col_iter->Data())) continue;
+        nonzeros++;
+        max_abs = std::max(max_abs, std::abs(col_iter->Data()));
+        if (col_iter->Index() == row) continue;
+        real_t other_constant =
+            tableau_->Row(col_iter->Index())->At(constant_index_);
+        if (_IsNonNegative(other_constant) and
+            _IsNegative(other_constant + col_iter->Data() * value))
+          keeps_feasibility = false;
+      }
+      if (!keeps_feasibility) continue;
+      if (iter->Data() < kCrashPivotTolerance * max_abs) continue;
+      if (nonzeros < entering_nonzeros or
+          (nonzeros == entering_nonzeros and iter->Data() > entering_pivot)) {
+        entering_index = col;
+        entering_nonzeros = nonzeros;
+        entering_pivot = iter->Data();
+      }
+    }
+    if (entering_index < 0) continue;
+    TableauPivot(base, index_to_variable_[entering_index], row);
+  }
+}
+
 Result LPModel::TableauSimplexInitialize() {
   if (!needTableauInitialization(tableau_, constant_index_)) return SOLVED;
 
+  // Cover the infeasible rows with structural variables first, the single
+  // artificial variable is only needed for the rows left over.
+  TableauSimplexCrash();
+  if (!needTableauInitialization(tableau_, constant_index_)) return SOLVED;
+
   Variable artificial_var = CreateArtificialVariable();
   non_base_variables_.insert(artificial_var);
 
@@ -242,6 +242,8 @@ TEST(LPModel, TableauInitialization) {
   LPModel model = parser.Parse(file);
   Variable x1("x1"), x2("x2");
 
+  // Phase 1 with the artificial variable only.
+  model.SetEnableCrashBasis(false);
   model.ToStandardForm();
   model.ToSlackForm();
   model.ToTableau();
@@ -266,6 +268,37 @@ TEST(LPModel, TableauInitialization) {
   }
 }
 
+TEST(LPModel, TableauCrashBasis) {
+  // x1 covers both ">=" rows of test4, so the crash basis is already feasible.
+  Parser parser;
+  std::ifstream file("tests/test4.txt");
+  LPModel model = parser.Parse(file);
+  Variable x1("x1"), x2("x2");
+
+  model.ToStandardForm();
+  model.ToSlackForm();
+  model.ToTableau();
+
+  model.TableauSimplexCrash();
+  EXPECT_EQ(
+      model.PrintTableau(),
+      "-6.000000 * base0 + 3.000000 * x2 + -6.000000\n"
+      "1.000000 * base0 + -1.000000 * x1 + -1.000000 * x2 + 1.000000\n"
+      "2.000000 * base0 + -1.000000 * base1 + -3.000000 * x2 + 1.000000\n"
+      "-1.000000 * base2 + -3.000000 * x2 + 2.000000\n");
+
+  EXPECT_EQ(model.TableauSimplexSolve(), Result::SOLVED);
+  EXPECT_EQ(model.GetTableauSimplexOptimum(), 5.0f);
+  auto expected_sol = std::map<Variable, Num>({{x1, 2.0f / 3}, {x2, 1.0f / 3}});
+  auto actual_sol = model.GetTableauSimplexSolution();
+  EXPECT_EQ(expected_sol.size(), actual_sol.size());
+  for (auto entry : expected_sol) {
+    EXPECT_EQ(actual_sol.find(entry.first) != actual_sol.end(), true);
+    EXPECT_LE(entry.second - actual_sol[entry.first], 1e-6f);
+    EXPECT_GE(entry.second - actual_sol[entry.first], -1e-6f);
+  }
+}
+
 TEST(LPModel, GetSolution) {
   Parser parser;
   std::ifstream file("tests/test5.txt");
@@ -0,0 +1,252 @@
+#include "normal_equation.h"
+
+// The number of columns of A D A^T eliminated exactly by the partial Cholesky
+// preconditioner.
+const int kPartialCholeskyRank = 16;
+// The conjugate gradients stop when ||r|| <= tolerance * ||rhs||.
+const real_t kConjugateGradientTolerance = 1e-12;
+// A column is dense if it has more non-zeros than both bounds below, the
+// second one is relative to the average number of non-zeros per column.
+const int kDenseColumnMinNonzeros = 32;
+const real_t kDenseColumnRatio = 10.0;
+// Without its dense columns, A may not have full row rank. The sparse part is
+// then shifted by this fraction of its largest diagonal entry, and the error
+// of the shift is removed by iterative refinement with the exact A D A^T.
+const real_t kDenseColumnShift = 1e-8;
+const int kDenseColumnRefinementSteps = 3;
+
+NormalEquationSolver::NormalEquationSolver(const Eigen::SparseMatrix<real_t>& A,
+                                           real_t regularization,
+                                           OrderingMethod ordering,
+                                           NormalEquationMethod method)
+    : method_(method),
+      A_(A),
+      At_(A.transpose()),
+      regularization_(A.rows(), A.rows()) {
+  SetRegularization(regularization);
+  if (method_ != CHOLESKY) return;
+  SplitDenseColumns();
+  std::vector<Eigen::Triplet<real_t>> triplets;
+  for (auto k = 0; k < sparse_columns_.size(); k++) {
+    for (Eigen::SparseMatrix<real_t>::InnerIterator it(A_, sparse_columns_[k]);
+         it; ++it)
+      triplets.push_back({(int)it.row(), k, it.value()});
+  }
+  Eigen::SparseMatrix<real_t> sparse_A(A_.rows(), sparse_columns_.size());
+  sparse_A.setFromTriplets(triplets.begin(), triplets.end());
+
+  Eigen::SparseMatrix<real_t> pattern =
+      sparse_A * Eigen::SparseMatrix<real_t>(sparse_A.transpose());
+  auto order = ComputeOrdering(pattern, ordering);
+  fill_statistics_ = ComputeFillStatistics(pattern, order);
+  permutation_.resize(A_.rows());
+  for (auto k = 0; k < order.size(); k++) permutation_.indices()[order[k]] = k;
+  permuted_A_ = permutation_ * sparse_A;
+  permuted_At_ = permuted_A_.transpose();
+  permuted_dense_.resize(A_.rows(), dense_columns_.size());
+  for (auto k = 0; k < dense_columns_.size(); k++)
+    permuted_dense_.col(k) =
+        permutation_ * Eigen::VectorXd(A_.col(dense_columns_[k]));
+}
+
+void NormalEquationSolver::SplitDenseColumns() {
+  real_t average = A_.nonZeros() * 1.0 / std::max<long>(A_.cols(), 1);
+  real_t threshold = std::max(kDenseColumnMinNonzeros * 1.0,
+                              kDenseColumnRatio * average);
+  for (auto j = 0; j < A_.cols(); j++) {
+    if (A_.col(j).nonZeros() > threshold)
+      dense_columns_.push_back(j);
+    else
+      sparse_columns_.push_back(j);
+  }
+}
+
+void NormalEquationSolver::SetRegularization(real_t regularization) {
+  regularization_value_ = regularization;
+  // Always store the diagonal, so that the sparsity pattern of A D A^T stays
+  // the same whatever D (and the regularization) is.
+  regularization_.setIdentity();
+  regularization_ *= regularization;
+}
+
+bool NormalEquationSolver::Factorize(const Eigen::VectorXd& d) {
+  assert(d.size() == A_.cols());
+  if (method_ != CHOLESKY) {
+    d_ = d;
+    diagonal_ = Eigen::VectorXd::Constant(A_.rows(), regularization_value_);
+    for (auto j = 0; j < A_.outerSize(); j++) {
+      for (Eigen::SparseMatrix<real_t>::InnerIterator it(A_, j); it; ++it)
+        diagonal_(it.row()) += it.value() * it.value() * d(j);
+    }
+    pivot_rows_.clear();
+    pivot_position_.assign(A_.rows(), -1);
+    if (method_ == CONJUGATE_GRADIENT_PARTIAL_CHOLESKY) BuildPartialCholesky();
+    for (auto i = 0; i < diagonal_.size(); i++)
+      if (!(diagonal_(i) > 0)) return false;
+    return true;
+  }
+  d_ = d;
+  Eigen::VectorXd sparse_d(sparse_columns_.size());
+  for (auto k = 0; k < sparse_columns_.size(); k++)
+    sparse_d(k) = d(sparse_columns_[k]);
+  Eigen::SparseMatrix<real_t> normal_mat =
+      permuted_A_ * sparse_d.asDiagonal() * permuted_At_ + regularization_;
+  if (!dense_columns_.empty()) {
+    real_t max_diagonal = 0;
+    for (auto i = 0; i < normal_mat.rows(); i++)
+      max_diagonal = std::max(max_diagonal, normal_mat.coeff(i, i));
+    Eigen::SparseMatrix<real_t> shift(normal_mat.rows(), normal_mat.cols());
+    shift.setIdentity();
+    normal_mat += kDenseColumnShift * std::max(max_diagonal, 1.0) * shift;
+  }
+  if (!analyzed_) {
+    ldlt_.analyzePattern(normal_mat);
+    analyzed_ = true;
+  }
+  ldlt_.factorize(normal_mat);
+  if (ldlt_.info() != Eigen::Success) return false;
+  if (dense_columns_.empty()) return true;
+
+  Eigen::VectorXd dense_d(dense_columns_.size());
+  for (auto k = 0; k < dense_columns_.size(); k++)
+    dense_d(k) = d(dense_columns_[k]);
+  woodbury_solution_ = ldlt_.solve(permuted_dense_);
+  Eigen::MatrixXd capacitance =
+      Eigen::MatrixXd::Identity(dense_columns_.size(), dense_columns_.size()) +
+      dense_d.asDiagonal() * (permuted_dense_.transpose() * woodbury_solution_);
+  woodbury_lu_.compute(capacitance);
+  return true;
+}
+
+Eigen::VectorXd NormalEquationSolver::WoodburySolve(
+    const Eigen::VectorXd& permuted_rhs) {
+  Eigen::VectorXd solution = ldlt_.solve(permuted_rhs);
+  if (dense_columns_.empty()) return solution;
+  Eigen::VectorXd dense_d(dense_columns_.size());
+  for (auto k = 0; k < dense_columns_.size(); k++)
+    dense_d(k) = d_(dense_columns_[k]);
+  Eigen::VectorXd correction = woodbury_lu_.solve(
+      dense_d.cwiseProduct(permuted_dense_.transpose() * solution));
+  return solution - woodbury_solution_ * correction;
+}
+
+Eigen::VectorXd NormalEquationSolver::Solve(const Eigen::VectorXd& rhs) {
+  assert(rhs.size() == A_.rows());
+  if (method_ != CHOLESKY) return ConjugateGradientSolve(rhs);
+  Eigen::VectorXd permuted_rhs = permutation_ * rhs;
+  Eigen::VectorXd solution =
+      permutation_.inverse() * WoodburySolve(permuted_rhs);
+  if (dense_columns_.empty()) return solution;
+  for (auto k = 0; k < kDenseColumnRefinementSteps; k++) {
+    Eigen::VectorXd residual = permutation_ * (rhs - Multiply(solution));
+    Eigen::VectorXd permuted_correction = WoodburySolve(residual);
+    Eigen::VectorXd correction = permutation_.inverse() * permuted_correction;
+    solution += correction;
+  }
+  return solution;
+}
+
+Eigen::VectorXd NormalEquationSolver::Multiply(const Eigen::VectorXd& v) {
+  Eigen::VectorXd scaled = d_.cwiseProduct(At_ * v);
+  return A_ * scaled + regularization_value_ * v;
+}
+
+/* Eliminates the rows K with the largest diagonal entries one at a time (a
+ * right-looking LDL^T on the columns K of A D A^T, each of which is computed
+ * with two sparse products), then drops the off-diagonal part of the remaining
+ * Schur complement S:
+ *    P = [L_K | I] diag(D_K, diag(S)) [L_K | I]^T
+ * A pivot that is not safely positive ends the elimination early.
+ */
+void NormalEquationSolver::BuildPartialCholesky() {
+  int rows = A_.rows();
+  int rank = std::min(kPartialCholeskyRank, rows);
+  std::vector<int> candidates(rows);
+  for (auto i = 0; i < rows; i++) candidates[i] = i;
+  std::partial_sort(
+      candidates.begin(), candidates.begin() + rank, candidates.end(),
+      [&](int a, int b) { return diagonal_(a) > diagonal_(b); });
+  partial_factor_.resize(rows, rank);
+  for (auto j = 0; j < rank; j++) {
+    Eigen::VectorXd unit = Eigen::VectorXd::Zero(rows);
+    unit(candidates[j]) = 1.0;
+    partial_factor_.col(j) = Multiply(unit);
+  }
+  partial_pivots_.resize(rank);
+  for (auto j = 0; j < rank; j++) {
+    int row = candidates[j];
+    real_t pivot = partial_factor_(row, j);
+    if (!(pivot > kEpsilonF * diagonal_(row))) break;
+    partial_factor_.col(j) /= pivot;
+    for (auto eliminated : pivot_rows_) partial_factor_(eliminated, j) = 0;
+    partial_factor_(row, j) = 1.0;
+    for (auto l = j + 1; l < rank; l++)
+      partial_factor_.col(l) -=
+          partial_factor_.col(j) * (pivot * partial_factor_(candidates[l], j));
+    partial_pivots_(j) = pivot;
+    pivot_position_[row] = j;
+    pivot_rows_.push_back(row);
+  }
+  // The Schur complement of a positive definite matrix is positive definite,
+  // its diagonal is kept positive against cancellation.
+  for (auto i = 0; i < rows; i++) {
+    if (pivot_position_[i] >= 0) continue;
+    real_t schur = diagonal_(i);
+    for (auto j = 0; j < pivot_rows_.size(); j++)
+      schur -=
+          partial_pivots_(j) * partial_factor_(i, j) * partial_factor_(i, j);
+    diagonal_(i) = std::max(schur, kEpsilonF * diagonal_(i));
+  }
+}
+
+Eigen::VectorXd NormalEquationSolver::Precondition(const Eigen::VectorXd& r) {
+  Eigen::VectorXd z = r;
+  int rank = pivot_rows_.size();
+  // L_{i, j} is below the diagonal of the unit lower triangular factor.
+  auto below = [&](int i, int j) {
+    return pivot_position_[i] < 0 or pivot_position_[i] > j;
+  };
+  for (auto j = 0; j < rank; j++) {
+    real_t value = z(pivot_rows_[j]);
+    for (auto i = 0; i < z.size(); i++)
+      if (below(i, j)) z(i) -= partial_factor_(i, j) * value;
+  }
+  for (auto i = 0; i < z.size(); i++) {
+    int j = pivot_position_[i];
+    z(i) /= j >= 0 ? partial_pivots_(j) : diagonal_(i);
+  }
+  for (auto j = rank - 1; j >= 0; j--) {
+    real_t correction = 0;
+    for (auto i = 0; i < z.size(); i++)
+      if (below(i, j)) correction += partial_factor_(i, j) * z(i);
+    z(pivot_rows_[j]) -= correction;
+  }
+  return z;
+}
+
+Eigen::VectorXd NormalEquationSolver::ConjugateGradientSolve(
+    const Eigen::VectorXd& rhs) {
+  Eigen::VectorXd y = Eigen::VectorXd::Zero(rhs.size());
+  Eigen::VectorXd r = rhs;
+  Eigen::VectorXd z = Precondition(r);
+  Eigen::VectorXd p = z;
+  real_t rz = r.dot(z);
+  real_t threshold = kConjugateGradientTolerance * rhs.norm();
+  // Converges in at most m iterations in exact arithmetic, the rest is slack
+  // for the rounding errors.
+  int max_iterations = 2 * rhs.size() + 10;
+  conjugate_gradient_iterations_ = 0;
+  while (r.norm() > threshold and
+         conjugate_gradient_iterations_ < max_iterations) {
+    conjugate_gradient_iterations_ += 1;
+    Eigen::VectorXd q = Multiply(p);
+    real_t alpha = rz / p.dot(q);
+    y += alpha * p;
+    r -= alpha * q;
+    z = Precondition(r);
+    real_t next_rz = r.dot(z);
+    p = z + (next_rz / rz) * p;
+    rz = next_rz;
+  }
+  return y;
+}
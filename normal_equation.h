@@ -0,0 +1,126 @@
+/*
+ * Created on Sun Oct 18 2026
+ *
+ * Copyright (c) 2024 - Qiming Zheng
+ *
+ * This file defines the solver of the normal equations (A D A^T) y = r that
+ * every iteration of the interior-point methods solves, either with a sparse
+ * LDL^T factorization of A D A^T or with preconditioned conjugate gradients
+ * that only multiply by A and A^T.
+ *
+ */
+#pragma once
+
+#include <assert.h>
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+#include "base.h"
+#include "ordering.h"
+
+enum NormalEquationMethod {
+  // The sparse LDL^T factorization of A D A^T.
+  CHOLESKY,
+  // Conjugate gradients preconditioned with the diagonal of A D A^T.
+  CONJUGATE_GRADIENT_DIAGONAL,
+  // Conjugate gradients preconditioned with a partial Cholesky factorization:
+  // the columns of A D A^T with the largest diagonal entries are eliminated
+  // exactly, the rest of the Schur complement is approximated by its diagonal
+  // (Gondzio, 2012).
+  CONJUGATE_GRADIENT_PARTIAL_CHOLESKY,
+};
+
+class NormalEquationSolver {
+ public:
+  // `regularization` is added to the diagonal of A D A^T, it keeps the
+  // factorization stable when A is (close to) rank deficient. With CHOLESKY,
+  // the rows of A are permuted once by the fill-reducing `ordering` of the
+  // pattern of A A^T, which is the pattern of A D A^T whatever D is, and the
+  // dense columns of A are split out of it (see SplitDenseColumns). The
+  // conjugate gradient methods never form A D A^T, their memory is linear in
+  // the non-zeros of A.
+  NormalEquationSolver(const Eigen::SparseMatrix<real_t>& A,
+                       real_t regularization = 0.0,
+                       OrderingMethod ordering = AMD_ORDERING,
+                       NormalEquationMethod method = CHOLESKY);
+
+  // Assembles A D A^T for D = diag(d) and factorizes it numerically. The
+  // symbolic factorization only depends on the sparsity pattern of A, so it is
+  // computed by the first call and reused afterwards. The conjugate gradient
+  // methods only build their preconditioner.
+  bool Factorize(const Eigen::VectorXd& d);
+
+  // Replaces the regularization of the next factorizations.
+  void SetRegularization(real_t regularization);
+
+  // Solves (A D A^T) y = rhs with the last factorization.
+  Eigen::VectorXd Solve(const Eigen::VectorXd& rhs);
+
+  // A and A^T in their original row order.
+  const Eigen::SparseMatrix<real_t>& A() { return A_; }
+
+  const Eigen::SparseMatrix<real_t>& At() { return At_; }
+
+  // The fill of the factor L under the chosen ordering.
+  const FillStatistics& GetFillStatistics() { return fill_statistics_; }
+
+  // The columns of A left out of the sparse factorization.
+  const std::vector<int>& GetDenseColumns() { return dense_columns_; }
+
+  // The number of conjugate gradient iterations of the last solve.
+  int GetConjugateGradientIterations() {
+    return conjugate_gradient_iterations_;
+  }
+
+ private:
+  // (A D A^T + regularization * I) v, with two sparse products.
+  Eigen::VectorXd Multiply(const Eigen::VectorXd& v);
+  // Solves P z = r with the preconditioner P of the last Factorize.
+  Eigen::VectorXd Precondition(const Eigen::VectorXd& r);
+  void BuildPartialCholesky();
+  Eigen::VectorXd ConjugateGradientSolve(const Eigen::VectorXd& rhs);
+  // A single column with a non-zero in every row makes A D A^T dense. Such
+  // columns U are factorized apart: with M the (sparse) contribution of the
+  // other columns, by the Sherman-Morrison-Woodbury formula
+  //    (M + U D_U U^T)^{-1} = M^{-1} - W (I + D_U U^T W)^{-1} D_U W^T,
+  // where W = M^{-1} U.
+  void SplitDenseColumns();
+  // Solves with the sparse factorization and the dense correction, in the
+  // permuted row order.
+  Eigen::VectorXd WoodburySolve(const Eigen::VectorXd& permuted_rhs);
+
+  NormalEquationMethod method_;
+  Eigen::SparseMatrix<real_t> A_;
+  Eigen::SparseMatrix<real_t> At_;
+  Eigen::VectorXd d_;
+  real_t regularization_value_ = 0.0;
+  // The diagonal of A D A^T, or of the Schur complement of the partial
+  // Cholesky factorization (on the rows it does not eliminate).
+  Eigen::VectorXd diagonal_;
+  // The k eliminated rows, the columns of L (m x k, unit on the eliminated
+  // row) and the pivots of the partial Cholesky factorization L D_k L^T.
+  std::vector<int> pivot_rows_;
+  std::vector<int> pivot_position_;
+  Eigen::MatrixXd partial_factor_;
+  Eigen::VectorXd partial_pivots_;
+  int conjugate_gradient_iterations_ = 0;
+  // P A and (P A)^T, where P is the permutation of the ordering, so that
+  // (P A) D (P A)^T = P (A D A^T) P^T is factorized in the natural order.
+  Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> permutation_;
+  Eigen::SparseMatrix<real_t> permuted_A_;
+  Eigen::SparseMatrix<real_t> permuted_At_;
+  FillStatistics fill_statistics_;
+  Eigen::SparseMatrix<real_t> regularization_;
+  // The dense columns, P U, and the Woodbury terms W and I + D_U U^T W of the
+  // last factorization.
+  std::vector<int> dense_columns_;
+  std::vector<int> sparse_columns_;
+  Eigen::MatrixXd permuted_dense_;
+  Eigen::MatrixXd woodbury_solution_;
+  Eigen::PartialPivLU<Eigen::MatrixXd> woodbury_lu_;
+  Eigen::SimplicialLDLT<Eigen::SparseMatrix<real_t>, Eigen::Lower,
+                        Eigen::NaturalOrdering<int>>
+      ldlt_;
+  bool analyzed_ = false;
+};
@@ -0,0 +1,99 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <Eigen/Dense>
+
+#include "normal_equation.h"
+
+TEST(NormalEquationSolver, Solve) {
+  Eigen::MatrixXd dense(3, 5);
+  dense << 1, 0, 2, 0, 1,  //
+      0, 3, 0, 1, 0,       //
+      4, 0, 0, 1, 1;
+  Eigen::SparseMatrix<real_t> A = dense.sparseView();
+  for (auto ordering :
+       {NATURAL_ORDERING, AMD_ORDERING, NESTED_DISSECTION_ORDERING}) {
+    NormalEquationSolver solver(A, 0.0, ordering);
+
+    // The symbolic factorization of the first call is reused by the second.
+    for (auto scale : {1.0, 1e-3}) {
+      Eigen::VectorXd d(5);
+      d << 1.0, 2.0, 0.5, 4.0, 3.0;
+      d *= scale;
+      EXPECT_TRUE(solver.Factorize(d));
+
+      Eigen::VectorXd rhs(3);
+      rhs << 1.0, -2.0, 3.0;
+      Eigen::MatrixXd normal_mat = dense * d.asDiagonal() * dense.transpose();
+      Eigen::VectorXd expected = normal_mat.inverse() * rhs;
+      Eigen::VectorXd actual = solver.Solve(rhs);
+      for (auto i = 0; i < 3; i++) {
+        EXPECT_LE(actual(i) - expected(i), 1e-6 * std::abs(expected(i)));
+        EXPECT_GE(actual(i) - expected(i), -1e-6 * std::abs(expected(i)));
+      }
+    }
+  }
+}
+
+TEST(NormalEquationSolver, ConjugateGradientSolve) {
+  // A sparse 40 x 100 matrix with a wide range of column scales.
+  int rows = 40, cols = 100;
+  std::vector<Eigen::Triplet<real_t>> triplets;
+  for (auto j = 0; j < cols; j++) {
+    triplets.push_back({j % rows, j, 1.0 + j % 7});
+    triplets.push_back({(j * 7 + 3) % rows, j, -0.5 * (1 + j % 3)});
+  }
+  Eigen::SparseMatrix<real_t> A(rows, cols);
+  A.setFromTriplets(triplets.begin(), triplets.end());
+  Eigen::VectorXd d(cols);
+  for (auto j = 0; j < cols; j++) d(j) = std::pow(10.0, j % 9 - 4);
+  Eigen::VectorXd rhs(rows);
+  for (auto i = 0; i < rows; i++) rhs(i) = std::sin(i + 1.0);
+
+  NormalEquationSolver cholesky(A);
+  EXPECT_TRUE(cholesky.Factorize(d));
+  Eigen::VectorXd expected = cholesky.Solve(rhs);
+
+  for (auto method :
+       {CONJUGATE_GRADIENT_DIAGONAL, CONJUGATE_GRADIENT_PARTIAL_CHOLESKY}) {
+    NormalEquationSolver solver(A, 0.0, AMD_ORDERING, method);
+    EXPECT_TRUE(solver.Factorize(d));
+    Eigen::VectorXd actual = solver.Solve(rhs);
+    EXPECT_LE((actual - expected).norm(), 1e-6 * expected.norm());
+    EXPECT_GT(solver.GetConjugateGradientIterations(), 0);
+    EXPECT_LE(solver.GetConjugateGradientIterations(), 2 * rows + 10);
+  }
+}
+
+TEST(NormalEquationSolver, DenseColumns) {
+  // Two columns with a non-zero in every row, the other columns are sparse and
+  // leave the last row empty, so the sparse part alone is singular.
+  int rows = 100, cols = 200;
+  std::vector<Eigen::Triplet<real_t>> triplets;
+  for (auto j = 0; j < cols; j++) {
+    triplets.push_back({j % (rows - 1), j, 1.0 + j % 5});
+    triplets.push_back({(j * 3 + 1) % (rows - 1), j, -1.0});
+  }
+  for (auto i = 0; i < rows; i++) {
+    triplets.push_back({i, cols, 1.0});
+    triplets.push_back({i, cols + 1, 1.0 + i % 3});
+  }
+  Eigen::SparseMatrix<real_t> A(rows, cols + 2);
+  A.setFromTriplets(triplets.begin(), triplets.end());
+  Eigen::VectorXd d(cols + 2);
+  for (auto j = 0; j < cols + 2; j++) d(j) = 0.5 + j % 4;
+  Eigen::VectorXd rhs(rows);
+  for (auto i = 0; i < rows; i++) rhs(i) = std::cos(i + 1.0);
+
+  NormalEquationSolver solver(A);
+  EXPECT_EQ(solver.GetDenseColumns(), std::vector<int>({cols, cols + 1}));
+  // The factor stays far from dense.
+  EXPECT_LT(solver.GetFillStatistics().factor_nonzeros, rows * (rows + 1) / 4);
+  EXPECT_TRUE(solver.Factorize(d));
+
+  Eigen::MatrixXd dense = A;
+  Eigen::MatrixXd normal_mat = dense * d.asDiagonal() * dense.transpose();
+  Eigen::VectorXd expected = normal_mat.ldlt().solve(rhs);
+  Eigen::VectorXd actual = solver.Solve(rhs);
+  EXPECT_LE((actual - expected).norm(), 1e-6 * expected.norm());
+}
@@ -0,0 +1,215 @@
+#include "ordering.h"
+
+#include <Eigen/OrderingMethods>
+#include <algorithm>
+
+// Nested dissection stops splitting subgraphs at this size and orders them
+// with the minimum degree ordering.
+const int kNestedDissectionLeafSize = 64;
+
+typedef std::vector<std::vector<int>> Graph;
+
+// The adjacency lists of the symmetrized pattern, without self loops.
+Graph ToGraph(const Eigen::SparseMatrix<real_t>& mat) {
+  assert(mat.rows() == mat.cols());
+  Graph graph(mat.rows());
+  for (auto k = 0; k < mat.outerSize(); k++) {
+    for (Eigen::SparseMatrix<real_t>::InnerIterator it(mat, k); it; ++it) {
+      if (it.row() == it.col()) continue;
+      graph[it.row()].push_back(it.col());
+      graph[it.col()].push_back(it.row());
+    }
+  }
+  for (auto& adj : graph) {
+    std::sort(adj.begin(), adj.end());
+    adj.erase(std::unique(adj.begin(), adj.end()), adj.end());
+  }
+  return graph;
+}
+
+// Appends the minimum degree ordering of the subgraph induced by `nodes`.
+void MinimumDegreeOrdering(const Graph& graph, const std::vector<int>& nodes,
+                           std::vector<int>& local_index,
+                           std::vector<int>& order) {
+  int size = nodes.size();
+  for (auto i = 0; i < size; i++) local_index[nodes[i]] = i;
+  std::vector<Eigen::Triplet<real_t>> triplets;
+  for (auto i = 0; i < size; i++) {
+    triplets.push_back({i, i, 1.0});
+    for (auto v : graph[nodes[i]])
+      if (local_index[v] >= 0) triplets.push_back({local_index[v], i, 1.0});
+  }
+  for (auto v : nodes) local_index[v] = -1;
+  Eigen::SparseMatrix<real_t> sub(size, size);
+  sub.setFromTriplets(triplets.begin(), triplets.end());
+  Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> perm;
+  Eigen::AMDOrdering<int>()(sub, perm);
+  for (auto k = 0; k < size; k++) order.push_back(nodes[perm.indices()[k]]);
+}
+
+// The breadth-first search of the subgraph of the nodes labelled `label` from
+// `root`. Returns the nodes level by level.
+std::vector<std::vector<int>> LevelStructure(const Graph& graph, int root,
+                                             int label,
+                                             const std::vector<int>& labels,
+                                             std::vector<int>& visited,
+                                             int stamp) {
+  std::vector<std::vector<int>> levels = {{root}};
+  visited[root] = stamp;
+  while (true) {
+    std::vector<int> next;
+    for (auto u : levels.back()) {
+      for (auto v : graph[u]) {
+        if (labels[v] != label or visited[v] == stamp) continue;
+        visited[v] = stamp;
+        next.push_back(v);
+      }
+    }
+    if (next.empty()) break;
+    levels.push_back(next);
+  }
+  return levels;
+}
+
+struct NestedDissection {
+  const Graph& graph;
+  std::vector<int> labels;
+  std::vector<int> visited;
+  std::vector<int> local_index;
+  int next_label = 0;
+  int next_stamp = 0;
+  std::vector<int> order;
+
+  NestedDissection(const Graph& graph)
+      : graph(graph),
+        labels(graph.size(), -1),
+        visited(graph.size(), -1),
+        local_index(graph.size(), -1) {}
+
+  void Dissect(const std::vector<int>& nodes) {
+    if (nodes.size() <= kNestedDissectionLeafSize) {
+      MinimumDegreeOrdering(graph, nodes, local_index, order);
+      return;
+    }
+    int label = next_label++;
+    for (auto v : nodes) labels[v] = label;
+
+    // A pseudo-peripheral root (George and Liu, 1979): the last level of the
+    // search from the root is searched again as long as it gets deeper.
+    int root = nodes[0];
+    auto levels =
+        LevelStructure(graph, root, label, labels, visited, next_stamp++);
+    while (true) {
+      int candidate = levels.back()[0];
+      for (auto v : levels.back())
+        if (graph[v].size() < graph[candidate].size()) candidate = v;
+      auto candidate_levels = LevelStructure(graph, candidate, label, labels,
+                                             visited, next_stamp++);
+      if (candidate_levels.size() <= levels.size()) break;
+      root = candidate;
+      levels = candidate_levels;
+    }
+
+    long reached = 0;
+    for (auto& level : levels) reached += level.size();
+    if (reached < nodes.size()) {
+      // Disconnected, the component of the root and the rest are independent.
+      std::vector<int> component, rest;
+      for (auto& level : levels)
+        component.insert(component.end(), level.begin(), level.end());
+      int stamp = visited[root];
+      for (auto v : nodes)
+        if (visited[v] != stamp) rest.push_back(v);
+      Dissect(component);
+      Dissect(rest);
+      return;
+    }
+    if (levels.size() < 3) {
+      MinimumDegreeOrdering(graph, nodes, local_index, order);
+      return;
+    }
+
+    // The middle level separates the levels above it from the ones below.
+    int middle = levels.size() / 2;
+    std::vector<int> first, second;
+    for (auto i = 0; i < middle; i++)
+      first.insert(first.end(), levels[i].begin(), levels[i].end());
+    for (auto i = middle + 1; i < levels.size(); i++)
+      second.insert(second.end(), levels[i].begin(), levels[i].end());
+    Dissect(first);
+    Dissect(second);
+    order.insert(order.end(), levels[middle].begin(), levels[middle].end());
+  }
+};
+
+std::vector<int> ComputeOrdering(const Eigen::SparseMatrix<real_t>& mat,
+                                 OrderingMethod method) {
+  int size = mat.rows();
+  std::vector<int> order;
+  switch (method) {
+    case NATURAL_ORDERING: {
+      for (auto i = 0; i < size; i++) order.push_back(i);
+    } break;
+
+    case AMD_ORDERING: {
+      Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> perm;
+      Eigen::AMDOrdering<int>()(mat, perm);
+      for (auto k = 0; k < size; k++) order.push_back(perm.indices()[k]);
+    } break;
+
+    case NESTED_DISSECTION_ORDERING: {
+      auto graph = ToGraph(mat);
+      NestedDissection dissection(graph);
+      std::vector<int> nodes;
+      for (auto i = 0; i < size; i++) nodes.push_back(i);
+      dissection.Dissect(nodes);
+      order = dissection.order;
+    } break;
+  }
+  assert(order.size() == size);
+  return order;
+}
+
+/* Row i of L has a non-zero in column j < i iff j is on the path of the
+ * elimination tree from some k with A_{i, k} != 0 (k < i) up to i. The tree is
+ * built on the fly: the parent of j is the first row i that reaches it (Liu,
+ * 1986).
+ */
+FillStatistics ComputeFillStatistics(const Eigen::SparseMatrix<real_t>& mat,
+                                     const std::vector<int>& order) {
+  auto graph = ToGraph(mat);
+  int size = graph.size();
+  assert(order.size() == size);
+  std::vector<int> position(size);
+  for (auto k = 0; k < size; k++) position[order[k]] = k;
+
+  FillStatistics stats;
+  std::vector<int> parent(size, -1), flag(size, -1);
+  std::vector<long> column_count(size, 1);
+  for (auto i = 0; i < size; i++) {
+    flag[i] = i;
+    stats.matrix_nonzeros += 1;
+    for (auto v : graph[order[i]]) {
+      int k = position[v];
+      if (k >= i) continue;
+      stats.matrix_nonzeros += 1;
+      for (auto j = k; flag[j] != i; j = parent[j]) {
+        if (parent[j] < 0) parent[j] = i;
+        column_count[j] += 1;
+        flag[j] = i;
+      }
+    }
+  }
+  for (auto count : column_count) {
+    stats.factor_nonzeros += count;
+    stats.factor_flops += count * count;
+  }
+  return stats;
+}
+
+std::string FillStatistics::ToString() const {
+  return "matrix non-zeros " + std::to_string(matrix_nonzeros) +
+         ", factor non-zeros " + std::to_string(factor_nonzeros) +
+         " (fill ratio " + std::to_string(FillRatio()) +
+         "), factorization flops " + std::to_string(factor_flops);
+}
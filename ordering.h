@@ -0,0 +1,58 @@
+/*
+ * Created on Sun Oct 18 2026
+ *
+ * Copyright (c) 2024 - Qiming Zheng
+ *
+ * This file defines the fill-reducing orderings of the symmetric sparse
+ * matrices factorized by the solvers (e.g. the normal equations A D A^T of the
+ * interior-point methods), and the fill statistics of their factorizations.
+ *
+ */
+#pragma once
+
+#include <assert.h>
+
+#include <Eigen/Sparse>
+#include <string>
+#include <vector>
+
+#include "base.h"
+
+enum OrderingMethod {
+  // The rows and the columns are eliminated in their original order.
+  NATURAL_ORDERING,
+  // Approximate minimum degree: eliminates the node of (approximately) the
+  // smallest degree in the graph of the remaining submatrix first.
+  AMD_ORDERING,
+  // Nested dissection: splits the graph in two halves with a small separator,
+  // orders the halves recursively and the separator last.
+  NESTED_DISSECTION_ORDERING,
+};
+
+// The number of non-zeros of the lower triangle (including the diagonal) of a
+// symmetric matrix and of its Cholesky (or LDL^T) factor L.
+struct FillStatistics {
+  long matrix_nonzeros = 0;
+  long factor_nonzeros = 0;
+  // The number of multiply-adds of the numerical factorization,
+  // sum_j |L_{*, j}|^2.
+  long factor_flops = 0;
+
+  real_t FillRatio() const {
+    return matrix_nonzeros == 0 ? 1.0 : factor_nonzeros * 1.0 / matrix_nonzeros;
+  }
+
+  std::string ToString() const;
+};
+
+// Computes the elimination order of the symmetric matrix with the sparsity
+// pattern of `mat` (only the pattern is read, and it is symmetrized), where
+// order[k] is the index of the k-th eliminated row / column.
+std::vector<int> ComputeOrdering(const Eigen::SparseMatrix<real_t>& mat,
+                                 OrderingMethod method);
+
+// The fill of the factorization of the symmetric matrix with the sparsity
+// pattern of `mat` eliminated in `order`, computed symbolically from the
+// elimination tree (no numerical factorization is done).
+FillStatistics ComputeFillStatistics(const Eigen::SparseMatrix<real_t>& mat,
+                                     const std::vector<int>& order);
@@ -0,0 +1,71 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "ordering.h"
+
+Eigen::SparseMatrix<real_t> FromEdges(int size,
+                                      std::vector<std::pair<int, int>> edges) {
+  std::vector<Eigen::Triplet<real_t>> triplets;
+  for (auto i = 0; i < size; i++) triplets.push_back({i, i, 4.0});
+  for (auto edge : edges) {
+    triplets.push_back({edge.first, edge.second, -1.0});
+    triplets.push_back({edge.second, edge.first, -1.0});
+  }
+  Eigen::SparseMatrix<real_t> mat(size, size);
+  mat.setFromTriplets(triplets.begin(), triplets.end());
+  return mat;
+}
+
+bool IsPermutation(std::vector<int> order, int size) {
+  std::sort(order.begin(), order.end());
+  for (auto i = 0; i < size; i++)
+    if (order[i] != i) return false;
+  return order.size() == size;
+}
+
+TEST(Ordering, ArrowMatrix) {
+  // The first row / column is dense: eliminating it first fills the whole
+  // factor, eliminating it last does not fill at all.
+  int size = 20;
+  std::vector<std::pair<int, int>> edges;
+  for (auto i = 1; i < size; i++) edges.push_back({0, i});
+  auto mat = FromEdges(size, edges);
+
+  auto natural =
+      ComputeFillStatistics(mat, ComputeOrdering(mat, NATURAL_ORDERING));
+  EXPECT_EQ(natural.matrix_nonzeros, 2 * size - 1);
+  EXPECT_EQ(natural.factor_nonzeros, size * (size + 1) / 2);
+
+  for (auto method : {AMD_ORDERING, NESTED_DISSECTION_ORDERING}) {
+    auto order = ComputeOrdering(mat, method);
+    EXPECT_TRUE(IsPermutation(order, size));
+    EXPECT_EQ(order.back(), 0);
+    auto fill = ComputeFillStatistics(mat, order);
+    EXPECT_EQ(fill.factor_nonzeros, fill.matrix_nonzeros);
+  }
+}
+
+TEST(Ordering, GridGraph) {
+  // The 5-point Laplacian of a 30 x 30 grid, the natural (banded) ordering
+  // fills the whole band.
+  int n = 30;
+  std::vector<std::pair<int, int>> edges;
+  for (auto i = 0; i < n; i++) {
+    for (auto j = 0; j < n; j++) {
+      if (i + 1 < n) edges.push_back({i * n + j, (i + 1) * n + j});
+      if (j + 1 < n) edges.push_back({i * n + j, i * n + j + 1});
+    }
+  }
+  auto mat = FromEdges(n * n, edges);
+
+  auto natural =
+      ComputeFillStatistics(mat, ComputeOrdering(mat, NATURAL_ORDERING));
+  for (auto method : {AMD_ORDERING, NESTED_DISSECTION_ORDERING}) {
+    auto order = ComputeOrdering(mat, method);
+    EXPECT_TRUE(IsPermutation(order, n * n));
+    auto fill = ComputeFillStatistics(mat, order);
+    EXPECT_EQ(fill.matrix_nonzeros, natural.matrix_nonzeros);
+    EXPECT_LT(fill.factor_nonzeros, natural.factor_nonzeros);
+    EXPECT_LT(fill.factor_flops, natural.factor_flops);
+  }
+}
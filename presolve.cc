@@ -0,0 +1,782 @@
+#include "presolve.h"
+
+const real_t kInfinity = std::numeric_limits<real_t>::infinity();
+// Two bounds closer than this (relative to their magnitude) are the same.
+const real_t kPresolveTolerance = 1e-9;
+// The coefficients created by the substitutions below this are dropped.
+const real_t kPresolveDropTolerance = 1e-12;
+// A doubleton equation eliminates the variable with the fewer non-zeros,
+// unless its coefficient is this much smaller than the other one.
+const real_t kDoubletonPivotRatio = 1e-3;
+
+// a > b, beyond the tolerance.
+bool Exceeds(real_t a, real_t b) {
+  if (std::isinf(a) or std::isinf(b)) return a > b;
+  return a > b + kPresolveTolerance * std::max(1.0, std::abs(b));
+}
+
+bool SameValue(real_t a, real_t b) { return !Exceeds(a, b) and !Exceeds(b, a); }
+
+// The bounds of a * x implied by x in [lower, upper].
+std::pair<real_t, real_t> ScaleBounds(real_t a, real_t lower, real_t upper) {
+  if (a > 0) return {a * lower, a * upper};
+  return {a * upper, a * lower};
+}
+
+// The bounds of x_j implied by a_j x_j + a_k x_k = b and x_k in [lower, upper].
+std::pair<real_t, real_t> DoubletonBounds(real_t a_j, real_t a_k, real_t b,
+                                          real_t lower, real_t upper) {
+  auto rest = ScaleBounds(-a_k, lower, upper);
+  return ScaleBounds(1 / a_j, b + rest.first, b + rest.second);
+}
+
+Presolver::Presolver(const Model& model) : opt_type_(model.opt_obj.opt_type) {
+  auto column = [&](Variable var) {
+    auto iter = column_index_.find(var);
+    if (iter != column_index_.end()) return iter->second;
+    column_index_[var] = columns_.size();
+    columns_.push_back({var, {}, 0, -kInfinity, kInfinity});
+    return int(columns_.size() - 1);
+  };
+  for (auto& constraint : model.constraints) {
+    Row row;
+    real_t rhs =
+        ToReal(constraint.compare) - ToReal(constraint.expression.constant);
+    row.lower = constraint.equation_type == Constraint::LE ? -kInfinity : rhs;
+    row.upper = constraint.equation_type == Constraint::GE ? kInfinity : rhs;
+    for (auto entry : constraint.expression.variable_coeff) {
+      real_t coeff = ToReal(entry.second);
+      if (coeff != 0) row.entries[column(entry.first)] = coeff;
+    }
+    for (auto entry : row.entries)
+      columns_[entry.first].entries[rows_.size()] = entry.second;
+    rows_.push_back(row);
+  }
+  // Everything is a minimization inside.
+  real_t sign = opt_type_ == OptimizationObject::MAX ? -1.0 : 1.0;
+  for (auto entry : model.opt_obj.expression.variable_coeff)
+    columns_[column(entry.first)].cost = sign * ToReal(entry.second);
+  objective_offset_ = sign * ToReal(model.opt_obj.expression.constant);
+
+  statistics_.rows = rows_.size();
+  statistics_.columns = columns_.size();
+  for (auto& row : rows_) statistics_.nonzeros += row.entries.size();
+}
+
+Result Presolver::Presolve() {
+  bool reduced = true;
+  while (reduced and !infeasible_ and !unbounded_) {
+    reduced = false;
+    reduced |= RemoveEmptyRows();
+    reduced |= RemoveSingletonRows();
+    reduced |= RemoveEmptyColumns();
+    reduced |= RemoveFixedColumns();
+    reduced |= RemoveForcingAndDominatedRows();
+    reduced |= RemoveDoubletonEquations();
+    reduced |= RemoveDuplicateRows();
+    reduced |= RemoveDuplicateColumns();
+  }
+  if (infeasible_) return NOSOLUTION;
+  if (unbounded_) return UNBOUNDED;
+
+  statistics_.reduced_rows = statistics_.reduced_columns = 0;
+  statistics_.reduced_nonzeros = 0;
+  for (auto& row : rows_) {
+    if (!row.active) continue;
+    statistics_.reduced_rows += 1;
+    statistics_.reduced_nonzeros += row.entries.size();
+  }
+  for (auto& col : columns_) statistics_.reduced_columns += col.active;
+  BuildReducedModel();
+  return SOLVED;
+}
+
+void Presolver::RemoveRow(int row) {
+  for (auto entry : rows_[row].entries)
+    columns_[entry.first].entries.erase(row);
+  rows_[row].entries.clear();
+  rows_[row].active = false;
+}
+
+void Presolver::RemoveColumn(int col) {
+  for (auto entry : columns_[col].entries)
+    rows_[entry.first].entries.erase(col);
+  columns_[col].entries.clear();
+  columns_[col].active = false;
+}
+
+void Presolver::SetCoeff(int row, int col, real_t coeff) {
+  if (std::abs(coeff) < kPresolveDropTolerance) {
+    rows_[row].entries.erase(col);
+    columns_[col].entries.erase(row);
+    return;
+  }
+  rows_[row].entries[col] = coeff;
+  columns_[col].entries[row] = coeff;
+}
+
+void Presolver::FixColumn(int col, real_t value) {
+  for (auto entry : columns_[col].entries) {
+    rows_[entry.first].lower -= entry.second * value;
+    rows_[entry.first].upper -= entry.second * value;
+  }
+  objective_offset_ += columns_[col].cost * value;
+  RemoveColumn(col);
+}
+
+std::vector<std::pair<int, real_t>> Presolver::OtherEntries(int col, int row) {
+  std::vector<std::pair<int, real_t>> entries;
+  for (auto entry : columns_[col].entries)
+    if (entry.first != row) entries.push_back(entry);
+  return entries;
+}
+
+real_t Presolver::ReducedCost(
+    real_t cost, const std::vector<std::pair<int, real_t>>& entries,
+    const std::vector<real_t>& dual) {
+  for (auto entry : entries) cost -= entry.second * dual[entry.first];
+  return cost;
+}
+
+bool Presolver::RemoveEmptyRows() {
+  bool reduced = false;
+  for (auto i = 0; i < rows_.size(); i++) {
+    auto& row = rows_[i];
+    if (!row.active or !row.entries.empty()) continue;
+    if (Exceeds(row.lower, 0) or Exceeds(0, row.upper)) infeasible_ = true;
+    PostsolveStep step;
+    step.type = PostsolveStep::FREE_ROW;
+    step.row = i;
+    steps_.push_back(step);
+    RemoveRow(i);
+    reduced = true;
+  }
+  return reduced;
+}
+
+bool Presolver::RemoveSingletonRows() {
+  bool reduced = false;
+  for (auto i = 0; i < rows_.size(); i++) {
+    auto& row = rows_[i];
+    if (!row.active or row.entries.size() != 1) continue;
+    int j = row.entries.begin()->first;
+    real_t a = row.entries.begin()->second;
+    auto& col = columns_[j];
+    auto implied = ScaleBounds(1 / a, row.lower, row.upper);
+    PostsolveStep step;
+    step.type = PostsolveStep::SINGLETON_ROW;
+    step.row = i;
+    step.col = j;
+    step.coeff = a;
+    step.old_lower = col.lower;
+    step.old_upper = col.upper;
+    step.lower = implied.first;
+    step.upper = implied.second;
+    steps_.push_back(step);
+    col.lower = std::max(col.lower, implied.first);
+    col.upper = std::min(col.upper, implied.second);
+    if (Exceeds(col.lower, col.upper)) infeasible_ = true;
+    if (col.lower > col.upper) col.lower = col.upper;
+    RemoveRow(i);
+    reduced = true;
+  }
+  return reduced;
+}
+
+bool Presolver::RemoveEmptyColumns() {
+  bool reduced = false;
+  for (auto j = 0; j < columns_.size(); j++) {
+    auto& col = columns_[j];
+    if (!col.active or !col.entries.empty()) continue;
+    // The best bound, any finite value for a column without a cost.
+    real_t value = 0;
+    if (col.cost > 0 or (col.cost == 0 and col.lower > -kInfinity))
+      value = col.lower;
+    else if (col.cost < 0 or col.upper < kInfinity)
+      value = col.upper;
+    if (std::isinf(value)) {
+      unbounded_ = true;
+      return true;
+    }
+    PostsolveStep step;
+    step.type = PostsolveStep::FIXED_COLUMN;
+    step.col = j;
+    step.value = value;
+    step.cost = col.cost;
+    step.old_lower = col.lower;
+    step.old_upper = col.upper;
+    step.column_entries.push_back({});
+    steps_.push_back(step);
+    FixColumn(j, value);
+    reduced = true;
+  }
+  return reduced;
+}
+
+bool Presolver::RemoveFixedColumns() {
+  bool reduced = false;
+  for (auto j = 0; j < columns_.size(); j++) {
+    auto& col = columns_[j];
+    if (!col.active or col.entries.empty()) continue;
+    if (std::isinf(col.lower) or !SameValue(col.lower, col.upper)) continue;
+    PostsolveStep step;
+    step.type = PostsolveStep::FIXED_COLUMN;
+    step.col = j;
+    step.value = col.lower;
+    step.cost = col.cost;
+    step.old_lower = col.lower;
+    step.old_upper = col.upper;
+    step.column_entries.push_back(OtherEntries(j, -1));
+    steps_.push_back(step);
+    FixColumn(j, col.lower);
+    reduced = true;
+  }
+  return reduced;
+}
+
+/* With the bounds of its columns, the activity of a row lies in [min, max]:
+ *    1. [min, max] and [L, U] do not intersect: the model is infeasible;
+ *    2. [min, max] is in [L, U]: the row is redundant;
+ *    3. min = U (max = L): the row is forcing, every column is fixed at the
+ *       bound that gives the minimum (maximum) activity;
+ *    4. min >= L (max <= U): the lower (upper) side is dominated.
+ */
+bool Presolver::RemoveForcingAndDominatedRows() {
+  bool reduced = false;
+  for (auto i = 0; i < rows_.size(); i++) {
+    auto& row = rows_[i];
+    if (!row.active or row.entries.empty()) continue;
+    real_t min_activity = 0, max_activity = 0;
+    for (auto entry : row.entries) {
+      auto& col = columns_[entry.first];
+      auto bounds = ScaleBounds(entry.second, col.lower, col.upper);
+      min_activity += bounds.first;
+      max_activity += bounds.second;
+    }
+    if (Exceeds(min_activity, row.upper) or Exceeds(row.lower, max_activity)) {
+      infeasible_ = true;
+      return true;
+    }
+    bool lower_dominated = !Exceeds(row.lower, min_activity);
+    bool upper_dominated = !Exceeds(max_activity, row.upper);
+    if (lower_dominated and upper_dominated) {
+      PostsolveStep step;
+      step.type = PostsolveStep::FREE_ROW;
+      step.row = i;
+      steps_.push_back(step);
+      RemoveRow(i);
+      reduced = true;
+      continue;
+    }
+    bool forcing_upper = std::isfinite(min_activity) and
+                         !Exceeds(row.upper, min_activity);
+    bool forcing_lower = std::isfinite(max_activity) and
+                         !Exceeds(max_activity, row.lower);
+    if (forcing_upper or forcing_lower) {
+      PostsolveStep step;
+      step.type = PostsolveStep::FORCING_ROW;
+      step.row = i;
+      step.coeff = forcing_upper ? 1.0 : -1.0;
+      for (auto entry : row.entries) {
+        auto& col = columns_[entry.first];
+        bool at_lower = (entry.second > 0) == forcing_upper;
+        step.row_entries.push_back(entry);
+        step.values.push_back(at_lower ? col.lower : col.upper);
+        step.costs.push_back(col.cost);
+        step.column_entries.push_back(OtherEntries(entry.first, i));
+      }
+      steps_.push_back(step);
+      RemoveRow(i);
+      for (auto k = 0; k < step.row_entries.size(); k++)
+        FixColumn(step.row_entries[k].first, step.values[k]);
+      reduced = true;
+      continue;
+    }
+    if (lower_dominated and std::isfinite(row.lower)) {
+      row.lower = -kInfinity;
+      reduced = true;
+    }
+    if (upper_dominated and std::isfinite(row.upper)) {
+      row.upper = kInfinity;
+      reduced = true;
+    }
+  }
+  return reduced;
+}
+
+/* a_j x_j + a_k x_k = b: x_k = (b - a_j x_j) / a_k is substituted out of the
+ * other rows and of the objective, and its bounds become bounds of x_j.
+ */
+bool Presolver::RemoveDoubletonEquations() {
+  bool reduced = false;
+  for (auto i = 0; i < rows_.size(); i++) {
+    auto& row = rows_[i];
+    if (!row.active or row.entries.size() != 2) continue;
+    if (std::isinf(row.lower) or !SameValue(row.lower, row.upper)) continue;
+    int j = row.entries.begin()->first, k = row.entries.rbegin()->first;
+    if (columns_[j].entries.size() < columns_[k].entries.size())
+      std::swap(j, k);
+    if (std::abs(row.entries[k]) <
+        kDoubletonPivotRatio * std::abs(row.entries[j]))
+      std::swap(j, k);
+    real_t a_j = row.entries[j], a_k = row.entries[k], b = row.lower;
+    auto& kept = columns_[j];
+    auto& eliminated = columns_[k];
+
+    PostsolveStep step;
+    step.type = PostsolveStep::DOUBLETON_EQUATION;
+    step.row = i;
+    step.col = j;
+    step.other = k;
+    step.coeff = a_j;
+    step.other_coeff = a_k;
+    step.value = b;
+    step.old_lower = kept.lower;
+    step.old_upper = kept.upper;
+    step.lower = eliminated.lower;
+    step.upper = eliminated.upper;
+    step.cost = kept.cost;
+    step.other_cost = eliminated.cost;
+    step.column_entries.push_back(OtherEntries(j, i));
+    step.column_entries.push_back(OtherEntries(k, i));
+    steps_.push_back(step);
+
+    auto implied =
+        DoubletonBounds(a_j, a_k, b, eliminated.lower, eliminated.upper);
+    kept.lower = std::max(kept.lower, implied.first);
+    kept.upper = std::min(kept.upper, implied.second);
+    if (Exceeds(kept.lower, kept.upper)) infeasible_ = true;
+    if (kept.lower > kept.upper) kept.lower = kept.upper;
+    kept.cost -= eliminated.cost * a_j / a_k;
+    objective_offset_ += eliminated.cost * b / a_k;
+    for (auto entry : step.column_entries[1]) {
+      int r = entry.first;
+      real_t a_r = entry.second;
+      real_t coeff = kept.entries.count(r) ? kept.entries[r] : 0;
+      SetCoeff(r, j, coeff - a_r * a_j / a_k);
+      rows_[r].lower -= a_r * b / a_k;
+      rows_[r].upper -= a_r * b / a_k;
+    }
+    RemoveRow(i);
+    RemoveColumn(k);
+    reduced = true;
+  }
+  return reduced;
+}
+
+/* Rows with the same columns and proportional coefficients, a_k = ratio * a_i,
+ * bound the same activity: row k is merged into row i. Candidates are grouped
+ * by their sparsity pattern first.
+ */
+bool Presolver::RemoveDuplicateRows() {
+  std::map<std::vector<int>, std::vector<int>> groups;
+  for (auto i = 0; i < rows_.size(); i++) {
+    if (!rows_[i].active or rows_[i].entries.size() < 2) continue;
+    std::vector<int> pattern;
+    for (auto entry : rows_[i].entries) pattern.push_back(entry.first);
+    groups[pattern].push_back(i);
+  }
+  bool reduced = false;
+  for (auto& group : groups) {
+    auto& members = group.second;
+    for (auto p = 0; p < members.size(); p++) {
+      int i = members[p];
+      if (!rows_[i].active) continue;
+      for (auto q = p + 1; q < members.size(); q++) {
+        int k = members[q];
+        if (!rows_[k].active) continue;
+        auto& row = rows_[i];
+        auto& duplicate = rows_[k];
+        real_t ratio = duplicate.entries.begin()->second /
+                       row.entries.begin()->second;
+        bool parallel = true;
+        for (auto entry : row.entries)
+          parallel = parallel and
+                     SameValue(duplicate.entries[entry.first],
+                               ratio * entry.second);
+        if (!parallel) continue;
+
+        auto implied = ScaleBounds(1 / ratio, duplicate.lower, duplicate.upper);
+        PostsolveStep step;
+        step.type = PostsolveStep::DUPLICATE_ROW;
+        step.row = i;
+        step.other = k;
+        step.coeff = ratio;
+        step.old_lower = row.lower;
+        step.old_upper = row.upper;
+        step.lower = implied.first;
+        step.upper = implied.second;
+        steps_.push_back(step);
+        row.lower = std::max(row.lower, implied.first);
+        row.upper = std::min(row.upper, implied.second);
+        if (Exceeds(row.lower, row.upper)) infeasible_ = true;
+        if (row.lower > row.upper) row.lower = row.upper;
+        RemoveRow(k);
+        reduced = true;
+      }
+    }
+  }
+  return reduced;
+}
+
+/* Columns with the same rows, proportional coefficients and proportional
+ * costs, a_k = ratio * a_j and c_k = ratio * c_j, only matter through
+ * x_j + ratio * x_k: column k is merged into column j, whose bounds become
+ * those of the sum.
+ */
+bool Presolver::RemoveDuplicateColumns() {
+  std::map<std::vector<int>, std::vector<int>> groups;
+  for (auto j = 0; j < columns_.size(); j++) {
+    if (!columns_[j].active or columns_[j].entries.empty()) continue;
+    std::vector<int> pattern;
+    for (auto entry : columns_[j].entries) pattern.push_back(entry.first);
+    groups[pattern].push_back(j);
+  }
+  bool reduced = false;
+  for (auto& group : groups) {
+    auto& members = group.second;
+    for (auto p = 0; p < members.size(); p++) {
+      int j = members[p];
+      if (!columns_[j].active) continue;
+      for (auto q = p + 1; q < members.size(); q++) {
+        int k = members[q];
+        if (!columns_[k].active) continue;
+        auto& col = columns_[j];
+        auto& duplicate = columns_[k];
+        real_t ratio = duplicate.entries.begin()->second /
+                       col.entries.begin()->second;
+        bool parallel = SameValue(duplicate.cost, ratio * col.cost);
+        for (auto entry : col.entries)
+          parallel = parallel and
+                     SameValue(duplicate.entries[entry.first],
+                               ratio * entry.second);
+        if (!parallel) continue;
+
+        PostsolveStep step;
+        step.type = PostsolveStep::DUPLICATE_COLUMN;
+        step.col = j;
+        step.other = k;
+        step.coeff = ratio;
+        step.old_lower = col.lower;
+        step.old_upper = col.upper;
+        step.lower = duplicate.lower;
+        step.upper = duplicate.upper;
+        steps_.push_back(step);
+        auto sum = ScaleBounds(ratio, duplicate.lower, duplicate.upper);
+        col.lower += sum.first;
+        col.upper += sum.second;
+        RemoveColumn(k);
+        reduced = true;
+      }
+    }
+  }
+  return reduced;
+}
+
+void Presolver::BuildReducedModel() {
+  auto& model = reduced_model_;
+  model = {{}, OptimizationObject(FLOAT)};
+  model.opt_obj.SetOptType(opt_type_);
+  real_t sign = opt_type_ == OptimizationObject::MAX ? -1.0 : 1.0;
+  reduced_constraints_.clear();
+  // x = lower + x', or x = upper - x', or x = x' for a free variable.
+  auto shift = [&](const Column& col) {
+    return std::isfinite(col.lower) ? col.lower
+           : std::isfinite(col.upper) ? col.upper
+                                      : 0.0;
+  };
+  auto direction = [&](const Column& col) {
+    return std::isinf(col.lower) and std::isfinite(col.upper) ? -1.0 : 1.0;
+  };
+
+  for (auto i = 0; i < rows_.size(); i++) {
+    auto& row = rows_[i];
+    if (!row.active) continue;
+    Expression expression(kFloatZero);
+    real_t offset = 0;
+    for (auto entry : row.entries) {
+      auto& col = columns_[entry.first];
+      expression.SetCoeffOf(col.var, Num(entry.second * direction(col)));
+      offset += entry.second * shift(col);
+    }
+    auto add = [&](Constraint::Type type, real_t rhs,
+                   ReducedConstraint::Type origin) {
+      Constraint constraint(FLOAT);
+      constraint.expression = expression;
+      constraint.SetEquationType(type);
+      constraint.SetCompare(Num(rhs - offset));
+      model.constraints.push_back(constraint);
+      reduced_constraints_.push_back({origin, i});
+    };
+    if (row.lower == row.upper) {
+      add(Constraint::EQ, row.lower, ReducedConstraint::ROW_EQUAL);
+      continue;
+    }
+    if (std::isfinite(row.lower))
+      add(Constraint::GE, row.lower, ReducedConstraint::ROW_LOWER);
+    if (std::isfinite(row.upper))
+      add(Constraint::LE, row.upper, ReducedConstraint::ROW_UPPER);
+  }
+
+  for (auto j = 0; j < columns_.size(); j++) {
+    auto& col = columns_[j];
+    if (!col.active) continue;
+    model.opt_obj.expression.SetCoeffOf(
+        col.var, Num(sign * col.cost * direction(col)));
+    // The cost of the shift is not in the reduced objective.
+    objective_offset_ += col.cost * shift(col);
+    if (std::isinf(col.lower) and std::isinf(col.upper)) continue;
+    Constraint non_negative(FLOAT);
+    non_negative.expression = Expression(col.var);
+    non_negative.SetEquationType(Constraint::GE);
+    model.constraints.push_back(non_negative);
+    reduced_constraints_.push_back({ReducedConstraint::LOWER_BOUND, j});
+    if (std::isinf(col.lower) or std::isinf(col.upper)) continue;
+    Constraint upper_bound(FLOAT);
+    upper_bound.expression = Expression(col.var);
+    upper_bound.SetEquationType(Constraint::LE);
+    upper_bound.SetCompare(Num(col.upper - col.lower));
+    model.constraints.push_back(upper_bound);
+    reduced_constraints_.push_back({ReducedConstraint::UPPER_BOUND, j});
+  }
+}
+
+PresolveSolution Presolver::Postsolve(const PresolveSolution& reduced) {
+  bool with_dual = reduced.dual.size() == reduced_constraints_.size();
+  bool with_basis = reduced.row_basis.size() == reduced_constraints_.size();
+  std::vector<real_t> x(columns_.size(), 0), z(columns_.size(), 0);
+  std::vector<real_t> y(rows_.size(), 0);
+  std::vector<BasisStatus> column_status(columns_.size(), BASIC);
+  std::vector<BasisStatus> row_status(rows_.size(), BASIC);
+
+  for (auto j = 0; j < columns_.size(); j++) {
+    auto& col = columns_[j];
+    if (!col.active) continue;
+    auto iter = reduced.primal.find(col.var);
+    real_t value = iter == reduced.primal.end() ? 0 : ToReal(iter->second);
+    bool negated = std::isinf(col.lower) and std::isfinite(col.upper);
+    x[j] = std::isfinite(col.lower) ? col.lower + value
+           : negated                ? col.upper - value
+                                    : value;
+    if (!with_basis) continue;
+    auto status = reduced.column_basis.find(col.var);
+    if (status == reduced.column_basis.end()) continue;
+    column_status[j] = status->second;
+    if (status->second == AT_LOWER and negated) column_status[j] = AT_UPPER;
+  }
+  for (auto k = 0; k < reduced_constraints_.size(); k++) {
+    auto& origin = reduced_constraints_[k];
+    bool is_row = origin.type != ReducedConstraint::UPPER_BOUND and
+                  origin.type != ReducedConstraint::LOWER_BOUND;
+    if (with_dual and is_row) y[origin.index] += reduced.dual[k];
+    if (!with_basis or reduced.row_basis[k] == BASIC) continue;
+    switch (origin.type) {
+      case ReducedConstraint::ROW_LOWER:
+        row_status[origin.index] = AT_LOWER;
+        break;
+      case ReducedConstraint::ROW_UPPER:
+        row_status[origin.index] = AT_UPPER;
+        break;
+      case ReducedConstraint::ROW_EQUAL:
+        row_status[origin.index] = reduced.row_basis[k];
+        break;
+      case ReducedConstraint::UPPER_BOUND:
+        // x' is basic in the reduced model, its bound is non-basic instead.
+        column_status[origin.index] = AT_UPPER;
+        break;
+      case ReducedConstraint::LOWER_BOUND:
+        break;
+    }
+  }
+  for (auto j = 0; j < columns_.size(); j++) {
+    if (!columns_[j].active) continue;
+    z[j] = columns_[j].cost;
+    for (auto entry : columns_[j].entries)
+      z[j] -= entry.second * y[entry.first];
+  }
+
+  // The status of a column at `value` with the reduced cost `reduced_cost`.
+  auto non_basic_status = [](real_t reduced_cost, real_t value, real_t lower,
+                             real_t upper) {
+    if (Exceeds(reduced_cost, 0)) return AT_LOWER;
+    if (Exceeds(0, reduced_cost)) return AT_UPPER;
+    if (SameValue(value, lower)) return AT_LOWER;
+    if (SameValue(value, upper)) return AT_UPPER;
+    return AT_ZERO;
+  };
+
+  for (auto iter = steps_.rbegin(); iter != steps_.rend(); iter++) {
+    auto& step = *iter;
+    switch (step.type) {
+      case PostsolveStep::FREE_ROW: {
+        y[step.row] = 0;
+        row_status[step.row] = BASIC;
+      } break;
+
+      case PostsolveStep::FIXED_COLUMN: {
+        x[step.col] = step.value;
+        z[step.col] = ReducedCost(step.cost, step.column_entries[0], y);
+        column_status[step.col] = non_basic_status(
+            z[step.col], step.value, step.old_lower, step.old_upper);
+      } break;
+
+      // The row is binding iff the column is non-basic at the bound the row
+      // implied, then the reduced cost of the column moves to the row.
+      case PostsolveStep::SINGLETON_ROW: {
+        auto status = column_status[step.col];
+        bool binding =
+            (status == AT_LOWER and Exceeds(step.lower, step.old_lower)) or
+            (status == AT_UPPER and Exceeds(step.old_upper, step.upper));
+        y[step.row] = 0;
+        row_status[step.row] = BASIC;
+        if (!binding) break;
+        y[step.row] = z[step.col] / step.coeff;
+        z[step.col] = 0;
+        column_status[step.col] = BASIC;
+        row_status[step.row] =
+            (status == AT_LOWER) == (step.coeff > 0) ? AT_LOWER : AT_UPPER;
+      } break;
+
+      // The dual of the row is the largest (in absolute value) that keeps
+      // the reduced costs of the fixed columns dual feasible, a column that
+      // limits it is basic.
+      case PostsolveStep::FORCING_ROW: {
+        bool upper = step.coeff > 0;
+        real_t dual = 0;
+        int limiting = -1;
+        std::vector<real_t> rest;
+        for (auto k = 0; k < step.row_entries.size(); k++) {
+          int col = step.row_entries[k].first;
+          real_t a = step.row_entries[k].second;
+          x[col] = step.values[k];
+          rest.push_back(ReducedCost(step.costs[k], step.column_entries[k], y));
+          real_t candidate = rest[k] / a;
+          if (upper ? candidate < dual : candidate > dual) {
+            dual = candidate;
+            limiting = k;
+          }
+        }
+        y[step.row] = dual;
+        row_status[step.row] = BASIC;
+        for (auto k = 0; k < step.row_entries.size(); k++) {
+          int col = step.row_entries[k].first;
+          real_t a = step.row_entries[k].second;
+          z[col] = k == limiting ? 0 : rest[k] - a * dual;
+          column_status[col] = (a > 0) == upper ? AT_LOWER : AT_UPPER;
+        }
+        if (limiting < 0) break;
+        column_status[step.row_entries[limiting].first] = BASIC;
+        row_status[step.row] = upper ? AT_UPPER : AT_LOWER;
+      } break;
+
+      // Either x_k is basic (z_k = 0), or x_j sits at a bound implied by x_k
+      // and x_j becomes basic (z_j = 0) while x_k takes that bound.
+      case PostsolveStep::DOUBLETON_EQUATION: {
+        int j = step.col, k = step.other;
+        x[k] = (step.value - step.coeff * x[j]) / step.other_coeff;
+        auto implied = DoubletonBounds(step.coeff, step.other_coeff,
+                                       step.value, step.lower, step.upper);
+        auto status = column_status[j];
+        bool from_eliminated =
+            (status == AT_LOWER and Exceeds(implied.first, step.old_lower)) or
+            (status == AT_UPPER and Exceeds(step.old_upper, implied.second));
+        real_t rest_j = ReducedCost(step.cost, step.column_entries[0], y);
+        real_t rest_k = ReducedCost(step.other_cost, step.column_entries[1], y);
+        if (from_eliminated) {
+          y[step.row] = rest_j / step.coeff;
+          z[j] = 0;
+          z[k] = rest_k - step.other_coeff * y[step.row];
+          column_status[j] = BASIC;
+          column_status[k] = std::abs(x[k] - step.lower) <
+                                     std::abs(x[k] - step.upper)
+                                 ? AT_LOWER
+                                 : AT_UPPER;
+        } else {
+          y[step.row] = rest_k / step.other_coeff;
+          z[k] = 0;
+          z[j] = rest_j - step.coeff * y[step.row];
+          column_status[k] = BASIC;
+        }
+        row_status[step.row] = y[step.row] < 0 ? AT_UPPER : AT_LOWER;
+      } break;
+
+      // Row k is binding iff row i is at the side implied by row k.
+      case PostsolveStep::DUPLICATE_ROW: {
+        int i = step.row, k = step.other;
+        auto status = row_status[i];
+        bool binding =
+            (status == AT_LOWER and Exceeds(step.lower, step.old_lower)) or
+            (status == AT_UPPER and Exceeds(step.old_upper, step.upper));
+        y[k] = 0;
+        row_status[k] = BASIC;
+        if (!binding) break;
+        y[k] = y[i] / step.coeff;
+        y[i] = 0;
+        row_status[i] = BASIC;
+        row_status[k] =
+            (status == AT_LOWER) == (step.coeff > 0) ? AT_LOWER : AT_UPPER;
+      } break;
+
+      // Splits x_j + ratio * x_k: at a bound of the sum, both are at the
+      // matching bounds. Otherwise x_k takes a bound and x_j the rest, as long
+      // as it fits in its bounds.
+      case PostsolveStep::DUPLICATE_COLUMN: {
+        int j = step.col, k = step.other;
+        real_t sum = x[j], ratio = step.coeff;
+        auto status = column_status[j];
+        z[k] = ratio * z[j];
+        if (status == AT_LOWER or status == AT_UPPER) {
+          bool lower = status == AT_LOWER;
+          x[j] = lower ? step.old_lower : step.old_upper;
+          x[k] = lower == (ratio > 0) ? step.lower : step.upper;
+          column_status[k] = lower == (ratio > 0) ? AT_LOWER : AT_UPPER;
+          break;
+        }
+        x[k] = 0;
+        column_status[k] = AT_ZERO;
+        if (std::isfinite(step.lower)) {
+          x[k] = step.lower;
+          column_status[k] = AT_LOWER;
+        } else if (std::isfinite(step.upper)) {
+          x[k] = step.upper;
+          column_status[k] = AT_UPPER;
+        }
+        x[j] = sum - ratio * x[k];
+        if (x[j] < step.old_lower or x[j] > step.old_upper) {
+          bool lower = x[j] < step.old_lower;
+          x[j] = lower ? step.old_lower : step.old_upper;
+          x[k] = (sum - x[j]) / ratio;
+          column_status[k] = status;
+          column_status[j] = lower ? AT_LOWER : AT_UPPER;
+        }
+      } break;
+    }
+  }
+
+  PresolveSolution solution;
+  for (auto j = 0; j < columns_.size(); j++) {
+    // The rounding errors of the substitutions are cleaned at the bounds.
+    if (SameValue(x[j], columns_[j].lower)) x[j] = columns_[j].lower;
+    if (SameValue(x[j], columns_[j].upper)) x[j] = columns_[j].upper;
+    solution.primal[columns_[j].var] = Num(x[j]);
+  }
+  if (with_dual) solution.dual = y;
+  if (with_basis) {
+    for (auto j = 0; j < columns_.size(); j++)
+      solution.column_basis[columns_[j].var] = column_status[j];
+    solution.row_basis = row_status;
+  }
+  return solution;
+}
+
+Num Presolver::PostsolveOptimum(Num reduced_optimum) {
+  real_t sign = opt_type_ == OptimizationObject::MAX ? -1.0 : 1.0;
+  return Num(ToReal(reduced_optimum) + sign * objective_offset_);
+}
+
+std::string PresolveStatistics::ToString() const {
+  return "rows " + std::to_string(rows) + " -> " +
+         std::to_string(reduced_rows) + ", columns " + std::to_string(columns) +
+         " -> " + std::to_string(reduced_columns) + ", non-zeros " +
+         std::to_string(nonzeros) + " -> " + std::to_string(reduced_nonzeros);
+}
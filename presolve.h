@@ -0,0 +1,176 @@
+/*
+ * Created on Sun Oct 18 2026
+ *
+ * Copyright (c) 2024 - Qiming Zheng
+ *
+ * This file defines the presolve of the LP models: the reductions that shrink
+ * a model before it is handed to a solver, and the postsolve that maps the
+ * solution (primal values, duals and basis) of the reduced model back to the
+ * original one.
+ *
+ */
+#pragma once
+
+#include <assert.h>
+
+#include <string>
+#include <vector>
+
+#include "base.h"
+#include "lp.h"
+
+// The status of a variable or a constraint in a basic solution. A constraint
+// is AT_LOWER (AT_UPPER) when its activity is at its lower (upper) side, the
+// sides of an equality are the same. AT_ZERO is a non-basic free variable.
+enum BasisStatus {
+  BASIC,
+  AT_LOWER,
+  AT_UPPER,
+  AT_ZERO,
+};
+
+/* A solution of a model. The duals are those of the model as a minimization
+ * (a MAX objective is negated): with the reduced costs z = c - A^T y, a
+ * variable at its lower (upper) bound has z >= 0 (z <= 0), a constraint at its
+ * lower (upper) side has y >= 0 (y <= 0). `dual` and `row_basis` follow the
+ * order of the constraints, they may be left empty when unknown.
+ */
+struct PresolveSolution {
+  std::map<Variable, Num> primal;
+  std::vector<real_t> dual;
+  std::map<Variable, BasisStatus> column_basis;
+  std::vector<BasisStatus> row_basis;
+};
+
+struct PresolveStatistics {
+  int rows = 0, columns = 0, nonzeros = 0;
+  int reduced_rows = 0, reduced_columns = 0, reduced_nonzeros = 0;
+
+  std::string ToString() const;
+};
+
+/* Each constraint is a row L <= a^T x <= U and each variable a column with the
+ * bounds lb <= x <= ub (a constraint on a single variable is a bound). The
+ * reductions, applied until none applies:
+ *    1. empty rows are dropped, empty columns are fixed at their best bound;
+ *    2. singleton rows become bounds of their column;
+ *    3. fixed columns (lb = ub) are substituted out;
+ *    4. rows are compared with their activity bounds: a row that can not be
+ *       violated (or a side of it) is dropped, a forcing row (its activity
+ *       can only reach one side) fixes all of its columns at their bounds;
+ *    5. doubleton equations a x_j + b x_k = c eliminate x_k, whose bounds
+ *       move to x_j;
+ *    6. duplicate rows (parallel coefficients) are merged, and so are the
+ *       duplicate columns (parallel coefficients and costs).
+ * Each reduction pushes a postsolve step, the postsolve undoes them in
+ * reverse. The reductions treat every variable as continuous.
+ */
+class Presolver {
+ public:
+  Presolver(const Model& model);
+
+  // Returns SOLVED when the model is reduced, NOSOLUTION (UNBOUNDED) when the
+  // presolve proves that it is infeasible (unbounded or infeasible). The
+  // model may be reduced to nothing, then the postsolve of the empty solution
+  // is the solution.
+  Result Presolve();
+
+  /* The reduced model. Its variables keep their names, but a variable with a
+   * finite lower bound is shifted (x = lb + x') and one with only a finite
+   * upper bound is negated (x = ub - x'), so that x' >= 0; the finite upper
+   * bounds of the shifted variables are constraints. A constraint with both
+   * sides finite and different is split in two constraints.
+   */
+  const Model& GetReducedModel() { return reduced_model_; }
+
+  // Maps a solution of the reduced model to the original model. The duals
+  // and the basis are recovered when those of the reduced model are given
+  // (one per constraint of the reduced model).
+  PresolveSolution Postsolve(const PresolveSolution& reduced);
+
+  // The optimum of the original model, given the optimum of the reduced one.
+  Num PostsolveOptimum(Num reduced_optimum);
+
+  const PresolveStatistics& GetStatistics() { return statistics_; }
+
+ private:
+  struct Row {
+    std::map<int, real_t> entries;
+    real_t lower, upper;
+    bool active = true;
+  };
+  struct Column {
+    Variable var;
+    std::map<int, real_t> entries;
+    real_t cost = 0, lower, upper;
+    bool active = true;
+  };
+  struct PostsolveStep {
+    enum Type {
+      // The row was dropped, its dual is 0 and it is basic.
+      FREE_ROW,
+      SINGLETON_ROW,
+      FIXED_COLUMN,
+      FORCING_ROW,
+      DOUBLETON_EQUATION,
+      DUPLICATE_ROW,
+      DUPLICATE_COLUMN,
+    };
+    Type type;
+    int row = -1, col = -1;
+    // The removed column (doubleton equations, duplicate columns) or row
+    // (duplicate rows), and its coefficient or ratio to the kept one.
+    int other = -1;
+    real_t coeff = 0, other_coeff = 0, value = 0;
+    // The bounds of `col` (`row`) before the step, and the bounds implied by
+    // the removed row or column.
+    real_t old_lower = 0, old_upper = 0, lower = 0, upper = 0;
+    real_t cost = 0, other_cost = 0;
+    // The columns of a forcing row with their values, and the other entries
+    // of the columns involved (in the rows other than `row`).
+    std::vector<std::pair<int, real_t>> row_entries;
+    std::vector<real_t> values, costs;
+    std::vector<std::vector<std::pair<int, real_t>>> column_entries;
+  };
+  // Where a constraint of the reduced model comes from.
+  struct ReducedConstraint {
+    enum Type { ROW_LOWER, ROW_UPPER, ROW_EQUAL, UPPER_BOUND, LOWER_BOUND };
+    Type type;
+    int index;
+  };
+
+  bool RemoveEmptyRows();
+  bool RemoveSingletonRows();
+  bool RemoveEmptyColumns();
+  bool RemoveFixedColumns();
+  bool RemoveForcingAndDominatedRows();
+  bool RemoveDoubletonEquations();
+  bool RemoveDuplicateRows();
+  bool RemoveDuplicateColumns();
+  void BuildReducedModel();
+
+  void RemoveRow(int row);
+  void RemoveColumn(int col);
+  void SetCoeff(int row, int col, real_t coeff);
+  // Substitutes x_col = value out of the model.
+  void FixColumn(int col, real_t value);
+  // The entries of a column in the rows other than `row`.
+  std::vector<std::pair<int, real_t>> OtherEntries(int col, int row);
+  // c_j - sum_i a_ij y_i over the given entries of column j.
+  real_t ReducedCost(real_t cost,
+                     const std::vector<std::pair<int, real_t>>& entries,
+                     const std::vector<real_t>& dual);
+
+  OptimizationObject::Type opt_type_;
+  std::vector<Row> rows_;
+  std::vector<Column> columns_;
+  std::map<Variable, int> column_index_;
+  // The constant of the objective (as a minimization) of the reduced model.
+  real_t objective_offset_ = 0;
+  std::vector<PostsolveStep> steps_;
+  Model reduced_model_ = {{}, OptimizationObject(FLOAT)};
+  std::vector<ReducedConstraint> reduced_constraints_;
+  bool infeasible_ = false;
+  bool unbounded_ = false;
+  PresolveStatistics statistics_;
+};
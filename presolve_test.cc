@@ -0,0 +1,150 @@
+#include "presolve.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "parser.h"
+
+TEST(Presolver, PresolveAndPostsolvePrimal) {
+  Parser parser;
+  std::ifstream file("tests/test12.txt");
+  Presolver presolver(parser.Parse(file));
+
+  EXPECT_EQ(presolver.Presolve(), SOLVED);
+  // The bounds are not rows of the reduced model.
+  auto& statistics = presolver.GetStatistics();
+  EXPECT_EQ(statistics.rows, 11);
+  EXPECT_EQ(statistics.reduced_rows, 3);
+
+  LPModel model(presolver.GetReducedModel());
+  model.ToStandardForm();
+  model.ToSlackForm();
+  EXPECT_EQ(model.SimplexSolve(), SOLVED);
+
+  auto optimum = presolver.PostsolveOptimum(model.GetSimplexOptimum());
+  auto solution = presolver.Postsolve({model.GetSimplexSolution()}).primal;
+  Variable xa("xa"), xb("xb"), xm("xm"), yu("yu"), yv("yv");
+  auto expected_sol = std::map<Variable, Num>(
+      {{xa, 80.0f}, {xb, 80.0f}, {xm, 720.0f}, {yu, 0.0f}, {yv, 80.0f}});
+  EXPECT_LE(2400.0f - optimum, 1e-3f);
+  EXPECT_GE(2400.0f - optimum, -1e-3f);
+  for (auto entry : expected_sol) {
+    EXPECT_EQ(solution.find(entry.first) != solution.end(), true);
+    EXPECT_LE(entry.second - solution[entry.first], 1e-3f);
+    EXPECT_GE(entry.second - solution[entry.first], -1e-3f);
+  }
+}
+
+TEST(Presolver, DoubletonEquationAndDuplicates) {
+  Parser parser;
+  Presolver presolver(parser.Parse(
+      "max x + y + 2 * z + 2 * w\n"
+      "st\n"
+      "x + 2 * y = 4\n"
+      "x + y + z + w <= 5\n"
+      "2 * x + 2 * y + 2 * z + 2 * w <= 8\n"
+      "x >= 0\n"
+      "y >= 0\n"
+      "z >= 0\n"
+      "w >= 0\n"
+      "w <= 1\n"));
+
+  EXPECT_EQ(presolver.Presolve(), SOLVED);
+  // The doubleton equation, the duplicate row and the duplicate column z, w
+  // leave a single row.
+  EXPECT_EQ(presolver.GetStatistics().reduced_rows, 1);
+  EXPECT_EQ(presolver.GetStatistics().reduced_columns, 2);
+
+  LPModel model(presolver.GetReducedModel());
+  model.ToStandardForm();
+  model.ToSlackForm();
+  EXPECT_EQ(model.SimplexSolve(), SOLVED);
+
+  auto optimum = presolver.PostsolveOptimum(model.GetSimplexOptimum());
+  auto solution = presolver.Postsolve({model.GetSimplexSolution()}).primal;
+  Variable x("x"), y("y"), z("z"), w("w");
+  EXPECT_LE(6.0f - optimum, 1e-3f);
+  EXPECT_GE(6.0f - optimum, -1e-3f);
+  auto value = [&](Variable var) { return solution[var].float_value; };
+  EXPECT_NEAR(value(x) + 2 * value(y), 4.0, 1e-6);
+  EXPECT_NEAR(value(x) + value(y) + value(z) + value(w), 4.0, 1e-6);
+  EXPECT_NEAR(value(x) + value(y) + 2 * value(z) + 2 * value(w), 6.0, 1e-6);
+  for (auto var : {x, y, z, w}) EXPECT_GE(value(var), -1e-6);
+  EXPECT_LE(value(w), 1.0 + 1e-6);
+}
+
+TEST(Presolver, PostsolveDualAndBasis) {
+  Parser parser;
+  Presolver presolver(parser.Parse(
+      "min 2 * x + 3 * y\n"
+      "st\n"
+      "x + y >= 4\n"
+      "x <= 1\n"
+      "y <= 3\n"
+      "x >= 0\n"
+      "y >= 0\n"));
+
+  // The first row is forcing once the bounds are known.
+  EXPECT_EQ(presolver.Presolve(), SOLVED);
+  EXPECT_EQ(presolver.GetReducedModel().constraints.size(), 0);
+
+  auto solution = presolver.Postsolve({});
+  Variable x("x"), y("y");
+  EXPECT_EQ(presolver.PostsolveOptimum(Num(0.0)), Num(11.0));
+  EXPECT_EQ(solution.primal[x], Num(1.0));
+  EXPECT_EQ(solution.primal[y], Num(3.0));
+  EXPECT_THAT(solution.dual, testing::ElementsAre(3.0, -1.0, 0.0, 0.0, 0.0));
+  EXPECT_EQ(solution.column_basis[x], BASIC);
+  EXPECT_EQ(solution.column_basis[y], BASIC);
+  EXPECT_THAT(solution.row_basis,
+              testing::ElementsAre(AT_LOWER, AT_UPPER, BASIC, BASIC, BASIC));
+}
+
+TEST(Presolver, ShiftedBounds) {
+  Parser parser;
+  struct Case {
+    std::string input;
+    real_t optimum, x, y;
+  };
+  // x is shifted by its lower bound, then by its upper bound.
+  std::vector<Case> cases = {{"min 2 * x + y\n"
+                              "st\n"
+                              "x + y >= 4\n"
+                              "x >= 3\n"
+                              "y >= 0\n",
+                              7, 3, 1},
+                             {"max 3 * x + y\n"
+                              "st\n"
+                              "x + y <= 6\n"
+                              "x <= 5\n"
+                              "y >= 0\n",
+                              16, 5, 1}};
+  for (auto& test : cases) {
+    Presolver presolver(parser.Parse(test.input));
+    EXPECT_EQ(presolver.Presolve(), SOLVED);
+
+    LPModel model(presolver.GetReducedModel());
+    model.ToStandardForm();
+    model.ToSlackForm();
+    EXPECT_EQ(model.SimplexSolve(), SOLVED);
+
+    auto optimum = presolver.PostsolveOptimum(model.GetSimplexOptimum());
+    auto solution = presolver.Postsolve({model.GetSimplexSolution()}).primal;
+    Variable x("x"), y("y");
+    EXPECT_NEAR(optimum.float_value, test.optimum, 1e-6);
+    EXPECT_NEAR(solution[x].float_value, test.x, 1e-6);
+    EXPECT_NEAR(solution[y].float_value, test.y, 1e-6);
+  }
+}
+
+TEST(Presolver, Infeasible) {
+  Parser parser;
+  Presolver presolver(parser.Parse(
+      "max x + y\n"
+      "st\n"
+      "x + y <= 1\n"
+      "x >= 2\n"
+      "y >= 0\n"));
+
+  EXPECT_EQ(presolver.Presolve(), NOSOLUTION);
+}
@@ -0,0 +1,180 @@
+#include "scaling.h"
+
+#include <cmath>
+#include <functional>
+
+// The geometric scaling stops after this many passes, or as soon as a pass
+// improves max |a_ij| / min |a_ij| by less than this factor.
+const int kMaxGeometricScalingPasses = 20;
+const real_t kGeometricScalingImprovement = 0.9;
+
+real_t NearestPowerOfTwo(real_t value) {
+  return std::exp2(std::round(std::log2(value)));
+}
+
+Scaler::Scaler(const Model& model) : row_scale_(model.constraints.size(), 1) {
+  ComputeScaling(model);
+  BuildScaledModel(model);
+}
+
+void Scaler::ComputeScaling(const Model& model) {
+  // The entries of the constraints on several variables, (row, column, |a|).
+  std::vector<Variable> columns;
+  std::map<Variable, int> column_index;
+  struct Entry {
+    int row, col;
+    real_t value;
+  };
+  std::vector<Entry> entries;
+  for (auto i = 0; i < model.constraints.size(); i++) {
+    auto& coeffs = model.constraints[i].expression.variable_coeff;
+    if (coeffs.size() < 2) continue;
+    for (auto entry : coeffs) {
+      real_t value = std::abs(ToReal(entry.second));
+      if (value == 0) continue;
+      if (!column_index.count(entry.first)) {
+        column_index[entry.first] = columns.size();
+        columns.push_back(entry.first);
+      }
+      entries.push_back({i, column_index[entry.first], value});
+    }
+  }
+  std::vector<real_t> row_scale(model.constraints.size(), 1);
+  std::vector<real_t> col_scale(columns.size(), 1);
+  std::vector<bool> scalable(columns.size());
+  for (auto j = 0; j < columns.size(); j++)
+    scalable[j] = columns[j].type != INTEGER;
+
+  auto range = [&]() {
+    real_t min_coeff = std::numeric_limits<real_t>::infinity(), max_coeff = 0;
+    for (auto& e : entries) {
+      real_t value = e.value * row_scale[e.row] * col_scale[e.col];
+      min_coeff = std::min(min_coeff, value);
+      max_coeff = std::max(max_coeff, value);
+    }
+    return std::make_pair(min_coeff, max_coeff);
+  };
+  // Divides each row (column) by combine(min, max) of its scaled entries.
+  auto scale = [&](bool rows, std::function<real_t(real_t, real_t)> combine) {
+    int size = rows ? row_scale.size() : col_scale.size();
+    std::vector<real_t> min_coeff(size,
+                                  std::numeric_limits<real_t>::infinity());
+    std::vector<real_t> max_coeff(size, 0);
+    for (auto& e : entries) {
+      real_t value = e.value * row_scale[e.row] * col_scale[e.col];
+      int k = rows ? e.row : e.col;
+      min_coeff[k] = std::min(min_coeff[k], value);
+      max_coeff[k] = std::max(max_coeff[k], value);
+    }
+    for (auto k = 0; k < size; k++) {
+      if (max_coeff[k] == 0 or (!rows and !scalable[k])) continue;
+      auto& factor = rows ? row_scale[k] : col_scale[k];
+      factor /= combine(min_coeff[k], max_coeff[k]);
+    }
+  };
+
+  if (!entries.empty()) {
+    auto initial = range();
+    statistics_.min_coeff = initial.first;
+    statistics_.max_coeff = initial.second;
+    real_t ratio = initial.second / initial.first;
+    auto geometric = [](real_t min, real_t max) {
+      return std::sqrt(min * max);
+    };
+    for (auto pass = 0; pass < kMaxGeometricScalingPasses; pass++) {
+      auto previous_rows = row_scale;
+      auto previous_cols = col_scale;
+      scale(true, geometric);
+      scale(false, geometric);
+      auto current = range();
+      real_t current_ratio = current.second / current.first;
+      if (current_ratio > kGeometricScalingImprovement * ratio) {
+        if (current_ratio > ratio) {
+          row_scale = previous_rows;
+          col_scale = previous_cols;
+        }
+        break;
+      }
+      ratio = current_ratio;
+    }
+    auto largest = [](real_t min, real_t max) { return max; };
+    scale(true, largest);
+    scale(false, largest);
+  }
+
+  for (auto& value : row_scale) value = NearestPowerOfTwo(value);
+  for (auto j = 0; j < columns.size(); j++)
+    column_scale_[columns[j]] = NearestPowerOfTwo(col_scale[j]);
+  if (!entries.empty()) {
+    statistics_.scaled_min_coeff = std::numeric_limits<real_t>::infinity();
+    statistics_.scaled_max_coeff = 0;
+    for (auto& e : entries) {
+      real_t value =
+          e.value * row_scale[e.row] * column_scale_[columns[e.col]];
+      statistics_.scaled_min_coeff =
+          std::min(statistics_.scaled_min_coeff, value);
+      statistics_.scaled_max_coeff =
+          std::max(statistics_.scaled_max_coeff, value);
+    }
+  }
+  for (auto i = 0; i < model.constraints.size(); i++)
+    if (model.constraints[i].expression.variable_coeff.size() >= 2)
+      row_scale_[i] = row_scale[i];
+}
+
+void Scaler::BuildScaledModel(const Model& model) {
+  auto col_scale = [&](Variable var) {
+    auto iter = column_scale_.find(var);
+    return iter == column_scale_.end() ? 1.0 : iter->second;
+  };
+  scaled_model_ = {{}, model.opt_obj};
+  Expression objective(model.opt_obj.expression.constant);
+  for (auto entry : model.opt_obj.expression.variable_coeff)
+    objective.SetCoeffOf(entry.first,
+                         Num(ToReal(entry.second) * col_scale(entry.first)));
+  scaled_model_.opt_obj.expression = objective;
+
+  for (auto i = 0; i < model.constraints.size(); i++) {
+    auto& constraint = model.constraints[i];
+    auto& coeffs = constraint.expression.variable_coeff;
+    if (coeffs.size() == 1) {
+      // a x <= b becomes sign(a) x' <= b / (|a| s).
+      auto entry = *coeffs.begin();
+      real_t coeff = ToReal(entry.second);
+      if (coeff != 0)
+        row_scale_[i] = 1 / (std::abs(coeff) * col_scale(entry.first));
+    }
+    Constraint scaled(FLOAT);
+    scaled.SetEquationType(constraint.equation_type);
+    scaled.SetCompare(Num(ToReal(constraint.compare) * row_scale_[i]));
+    scaled.SetConstant(
+        Num(ToReal(constraint.expression.constant) * row_scale_[i]));
+    for (auto entry : coeffs) {
+      real_t coeff = ToReal(entry.second);
+      real_t value = coeffs.size() == 1
+                         ? (coeff > 0 ? 1.0 : coeff < 0 ? -1.0 : 0.0)
+                         : coeff * row_scale_[i] * col_scale(entry.first);
+      scaled.expression.SetCoeffOf(entry.first, Num(value));
+    }
+    scaled_model_.constraints.push_back(scaled);
+  }
+}
+
+PresolveSolution Scaler::Unscale(const PresolveSolution& scaled) {
+  PresolveSolution solution = scaled;
+  for (auto& entry : solution.primal) {
+    auto iter = column_scale_.find(entry.first);
+    if (iter == column_scale_.end()) continue;
+    entry.second = Num(ToReal(entry.second) * iter->second);
+  }
+  for (auto i = 0; i < solution.dual.size(); i++)
+    solution.dual[i] *= row_scale_[i];
+  return solution;
+}
+
+std::string ScalingStatistics::ToString() const {
+  return "coefficients in [" + std::to_string(min_coeff) + ", " +
+         std::to_string(max_coeff) + "], scaled in [" +
+         std::to_string(scaled_min_coeff) + ", " +
+         std::to_string(scaled_max_coeff) + "]";
+}
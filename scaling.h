@@ -0,0 +1,64 @@
+/*
+ * Created on Sun Oct 18 2026
+ *
+ * Copyright (c) 2024 - Qiming Zheng
+ *
+ * This file defines the scaling of the LP models: the rows and the columns of
+ * the constraint matrix are multiplied by powers of 2 so that its non-zeros are
+ * close to 1, which makes the absolute tolerances of the solvers meaningful.
+ *
+ */
+#pragma once
+
+#include <assert.h>
+
+#include <string>
+#include <vector>
+
+#include "base.h"
+#include "lp.h"
+#include "presolve.h"
+
+// The range of the absolute values of the non-zeros of the constraint matrix
+// (without the bounds), before and after the scaling.
+struct ScalingStatistics {
+  real_t min_coeff = 0, max_coeff = 0;
+  real_t scaled_min_coeff = 0, scaled_max_coeff = 0;
+
+  std::string ToString() const;
+};
+
+/* Scales A into R A S, where R = diag(r) scales the constraints and
+ * S = diag(s) the variables (x = S x'):
+ *    1. geometric scaling: the rows, then the columns, are divided by the
+ *       geometric mean of their largest and smallest non-zeros, for as long as
+ *       max |a_ij| / min |a_ij| improves enough;
+ *    2. equilibration: the rows, then the columns, are divided by their
+ *       largest non-zero.
+ * The factors are rounded to powers of 2, so that the scaling itself is exact.
+ * A constraint on a single variable (a bound) is not scaled with the others,
+ * its coefficient becomes +-1. The integer variables are not scaled.
+ */
+class Scaler {
+ public:
+  Scaler(const Model& model);
+
+  // The scaled model, over the same variable names (x' = S^{-1} x). The
+  // objective is the same function of x, so the optimum is not scaled.
+  const Model& GetScaledModel() { return scaled_model_; }
+
+  // Maps a solution of the scaled model back: x = S x', y = R y'. The basis
+  // is the same.
+  PresolveSolution Unscale(const PresolveSolution& scaled);
+
+  const ScalingStatistics& GetStatistics() { return statistics_; }
+
+ private:
+  void ComputeScaling(const Model& model);
+  void BuildScaledModel(const Model& model);
+
+  std::map<Variable, real_t> column_scale_;
+  std::vector<real_t> row_scale_;
+  Model scaled_model_ = {{}, OptimizationObject(FLOAT)};
+  ScalingStatistics statistics_;
+};
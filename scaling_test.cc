@@ -0,0 +1,84 @@
+#include "scaling.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "parser.h"
+
+TEST(Scaler, ReducesCoefficientRange) {
+  Parser parser;
+  Scaler scaler(parser.Parse(
+      "max 1000 * x + y\n"
+      "st\n"
+      "1000 * x + 0.001 * y <= 2000\n"
+      "0.01 * x + 0.00000001 * y <= 1\n"
+      "x >= 0\n"
+      "y >= 0\n"
+      "y <= 5000\n"));
+
+  auto& statistics = scaler.GetStatistics();
+  EXPECT_NEAR(statistics.max_coeff / statistics.min_coeff, 1e11, 1e3);
+  // The matrix has rank one, it is scaled to ones up to the rounding of the
+  // factors to powers of 2.
+  EXPECT_LE(statistics.scaled_max_coeff, 2.0);
+  EXPECT_LE(statistics.scaled_max_coeff / statistics.scaled_min_coeff, 4.0);
+
+  // The bounds keep a coefficient of +-1.
+  auto& scaled = scaler.GetScaledModel();
+  for (auto i = 2; i < 5; i++) {
+    auto coeffs = scaled.constraints[i].expression.variable_coeff;
+    EXPECT_EQ(coeffs.size(), 1);
+    EXPECT_EQ(coeffs.begin()->second, Num(1.0));
+  }
+}
+
+TEST(Scaler, ScaleAndUnscale) {
+  Parser parser;
+  std::ifstream file("tests/test12.txt");
+  Scaler scaler(parser.Parse(file));
+
+  LPModel model(scaler.GetScaledModel());
+  model.ToStandardForm();
+  model.ExtractUpperBounds();
+  model.ToSlackForm();
+  model.ToTableau(COLUMN_ONLY);
+  EXPECT_EQ(model.TableauDualSimplexSolve(), SOLVED);
+
+  auto optimum = model.GetTableauDualSimplexOptimum();
+  auto solution =
+      scaler.Unscale({model.GetTableauDualSimplexSolution()}).primal;
+  Variable xa("xa"), xb("xb"), xm("xm"), yu("yu"), yv("yv");
+  auto expected_sol = std::map<Variable, Num>(
+      {{xa, 80.0f}, {xb, 80.0f}, {xm, 720.0f}, {yu, 0.0f}, {yv, 80.0f}});
+  EXPECT_LE(2400.0f - optimum, 1e-3f);
+  EXPECT_GE(2400.0f - optimum, -1e-3f);
+  for (auto entry : expected_sol) {
+    EXPECT_EQ(solution.find(entry.first) != solution.end(), true);
+    EXPECT_LE(entry.second - solution[entry.first], 1e-3f);
+    EXPECT_GE(entry.second - solution[entry.first], -1e-3f);
+  }
+}
+
+TEST(Scaler, UnscaleDual) {
+  Parser parser;
+  Scaler scaler(parser.Parse(
+      "min 2 * x + 3 * y\n"
+      "st\n"
+      "4 * x + 4 * y >= 16\n"
+      "x >= 0\n"
+      "y >= 0\n"
+      "2 * x <= 2\n"));
+
+  // The duals of the original model are y = (0.75, 0, 0, -0.5), those of the
+  // scaled one y' = R^{-1} y.
+  auto& scaled = scaler.GetScaledModel();
+  auto rhs = [&](int i) {
+    auto& constraint = scaled.constraints[i];
+    return ToReal(constraint.compare) - ToReal(constraint.expression.constant);
+  };
+  real_t r0 = rhs(0) / 16, r3 = rhs(3) / 2;
+  auto solution = scaler.Unscale({{}, {0.75 / r0, 0, 0, -0.5 / r3}});
+  EXPECT_THAT(solution.dual,
+              testing::ElementsAre(testing::DoubleNear(0.75, 1e-12), 0, 0,
+                                   testing::DoubleNear(-0.5, 1e-12)));
+}
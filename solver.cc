@@ -1,9 +1,12 @@
 #include <fstream>
+#include <optional>
 #include <sstream>
 
 #include "ilp.h"
 #include "lp.h"
 #include "parser.h"
+#include "presolve.h"
+#include "scaling.h"
 
 enum SolverAlgorithm {
   SOLVER_UNKNOWN,
@@ -11,6 +14,9 @@ enum SolverAlgorithm {
   SIMPLEX_TABLEAU,
   REVISED_SIMPLEX_TABLEAU,
   DUAL_SIMPLEX,
+  INTERIOR_POINT,
+  CROSSOVER,
+  PRIMAL_DUAL_HYBRID_GRADIENT,
   COLUMN_GENERATION,
 };
 
@@ -40,6 +46,15 @@ SolverAlgorithm ParseAlgorithm(std::string algo) {
   if (ToLower(algo) == "dual_simplex") {
     return DUAL_SIMPLEX;
   }
+  if (ToLower(algo) == "interior_point") {
+    return INTERIOR_POINT;
+  }
+  if (ToLower(algo) == "crossover") {
+    return CROSSOVER;
+  }
+  if (ToLower(algo) == "pdhg") {
+    return PRIMAL_DUAL_HYBRID_GRADIENT;
+  }
   if (ToLower(algo) == "column_generation") {
     return COLUMN_GENERATION;
   }
@@ -66,12 +81,26 @@ int main(int argc, char **argv) {
   assert(int(-1.5) == -1);
   assert(int(1.5) == 1);
   if (argc < 2) {
-    std::cout << "usage: " << argv[0] << " input-file [solver-algo]\n";
+    std::cout << "usage: " << argv[0]
+              << " input-file [solver-algo] [pivoting-strategy] [presolve]"
+                 " [scale]\n";
     return -1;
   }
   std::ifstream lpfile(argv[1]);
   SolverAlgorithm solver = SIMPLEX;
   LPModel::PivotingStrategy strategy = LPModel::PivotingStrategy::MAX_COST;
+  bool presolve = false, scale = false;
+  while (argc >= 3) {
+    auto option = ToLower(argv[argc - 1]);
+    if (option == "presolve") {
+      presolve = true;
+    } else if (option == "scale") {
+      scale = true;
+    } else {
+      break;
+    }
+    argc -= 1;
+  }
   if (argc >= 3) solver = ParseAlgorithm(argv[2]);
   if (argc >= 4) strategy = ParsePivotingStrategy(argv[3]);
   Parser parser;
@@ -108,6 +137,25 @@ int main(int argc, char **argv) {
     Result result;
     Num optimum;
     std::map<Variable, Num> solution;
+    // Only built when the presolve is on.
+    std::optional<Presolver> presolver;
+    if (presolve) {
+      presolver.emplace(model);
+      result = presolver->Presolve();
+      Model reduced_model = presolver->GetReducedModel();
+      lp_model = reduced_model;
+      // Nothing is left to solve.
+      if (result != Result::SOLVED or reduced_model.constraints.empty()) {
+        solver = SOLVER_UNKNOWN;
+        optimum = Num(0.0);
+      }
+    }
+    // The scaling applies to what is left after the presolve.
+    std::optional<Scaler> scaler;
+    if (scale and solver != SOLVER_UNKNOWN) {
+      scaler.emplace(presolver ? presolver->GetReducedModel() : model);
+      lp_model = scaler->GetScaledModel();
+    }
     switch (solver) {
       case SIMPLEX: {
         lp_model.SetPivotingStrategy(strategy);
@@ -144,6 +192,49 @@ int main(int argc, char **argv) {
         }
       } break;
 
+      case DUAL_SIMPLEX: {
+        lp_model.ToStandardForm();
+        lp_model.ExtractUpperBounds();
+        lp_model.ToSlackForm();
+        lp_model.ToTableau(COLUMN_ONLY);
+        result = lp_model.TableauDualSimplexSolve();
+        if (result == Result::SOLVED) {
+          optimum = lp_model.GetTableauDualSimplexOptimum();
+          solution = lp_model.GetTableauDualSimplexSolution();
+        }
+      } break;
+
+      case INTERIOR_POINT: {
+        lp_model.ToStandardForm();
+        lp_model.ToSlackForm();
+        result = lp_model.MehrotraPredictorCorrectorSolve();
+        if (result == Result::SOLVED) {
+          optimum = lp_model.GetMehrotraPredictorCorrectorOptimum();
+          solution = lp_model.GetMehrotraPredictorCorrectorSolution();
+        }
+      } break;
+
+      case CROSSOVER: {
+        lp_model.ToStandardForm();
+        lp_model.ToSlackForm();
+        result = lp_model.MehrotraPredictorCorrectorSolve();
+        if (result == Result::SOLVED) result = lp_model.CrossoverSolve();
+        if (result == Result::SOLVED) {
+          optimum = lp_model.GetCrossoverOptimum();
+          solution = lp_model.GetCrossoverSolution();
+        }
+      } break;
+
+      case PRIMAL_DUAL_HYBRID_GRADIENT: {
+        lp_model.ToStandardForm();
+        lp_model.ToSlackForm();
+        result = lp_model.PrimalDualHybridGradientSolve();
+        if (result == Result::SOLVED) {
+          optimum = lp_model.GetPrimalDualHybridGradientOptimum();
+          solution = lp_model.GetPrimalDualHybridGradientSolution();
+        }
+      } break;
+
       case COLUMN_GENERATION: {
         lp_model.ToStandardForm();
         result = lp_model.ColumnGenerationSolve({}, true);
@@ -156,6 +247,12 @@ int main(int argc, char **argv) {
       default:
         break;
     }
+    if (scaler and result == Result::SOLVED)
+      solution = scaler->Unscale({solution}).primal;
+    if (presolver and result == Result::SOLVED) {
+      optimum = presolver->PostsolveOptimum(optimum);
+      solution = presolver->Postsolve({solution}).primal;
+    }
 
     if (result == Result::SOLVED) {
       std::cout << optimum.ToString() << "\n";